@@ -187,13 +187,10 @@ int main(int argc, char *argv[])
 		goto destroy_context;
 	}
 
-	for (i=0; i < user_param.num_of_qps; i++) {
-
-		/* shaking hands and gather the other side info. */
-		if (ctx_hand_shake(&user_comm,&my_dest[i],&rem_dest[i])) {
-			fprintf(stderr,"Failed to exchange data between server and clients\n");
-			goto destroy_context;
-		}
+	/* shaking hands and gather the other side info. */
+	if (ctx_hand_shake_bulk(&user_comm,my_dest,rem_dest,user_param.num_of_qps)) {
+		fprintf(stderr,"Failed to exchange data between server and clients\n");
+		goto destroy_context;
 	}
 
 	if (user_param.work_rdma_cm == OFF) {
@@ -228,15 +225,13 @@ int main(int argc, char *argv[])
 
 	user_comm.rdma_params->side = REMOTE;
 
-	for (i=0; i < user_param.num_of_qps; i++) {
-
-		if (ctx_hand_shake(&user_comm,&my_dest[i],&rem_dest[i])) {
-			fprintf(stderr," Failed to exchange data between server and clients\n");
-			goto destroy_context;
-		}
+	if (ctx_hand_shake_bulk(&user_comm,my_dest,rem_dest,user_param.num_of_qps)) {
+		fprintf(stderr," Failed to exchange data between server and clients\n");
+		goto destroy_context;
+	}
 
+	for (i=0; i < user_param.num_of_qps; i++)
 		ctx_print_pingpong_data(&rem_dest[i],&user_comm);
-	}
 
 	/* An additional handshake is required after moving qp to RTR. */
 	if (ctx_hand_shake(&user_comm,my_dest,rem_dest)) {
@@ -5,23 +5,53 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include <errno.h>
+#include <limits.h>
 #include <sys/ipc.h>
 #include <sys/shm.h>
+#include <sys/mman.h>
+#if !defined(__FreeBSD__)
+#include <sys/vfs.h>
+#endif
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#endif
 #include "host_memory.h"
 #include "perftest_parameters.h"
 
 
 struct host_memory_ctx {
 	struct memory_ctx base;
-	int use_hugepages;
+	int page_policy;
+	char *hugetlbfs_dir;
+	uint64_t hugetlbfs_page_size;
+	int map_populate;
 };
 
 
 #define HUGEPAGE_ALIGN  (2*1024*1024)
+#define HUGEPAGE_1G_ALIGN  (1024*1024*1024UL)
 #define SHMAT_ADDR (void *)(0x0UL)
 #define SHMAT_FLAGS (0)
 #define SHMAT_INVALID_PTR ((void *)-1)
+#define HUGETLBFS_MAGIC_NUM (0x958458f6)
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT (26)
+#endif
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+
+#define ALIGN_UP(size, align) ((((size) + (align) - 1) / (align)) * (align))
+
+/* Below it the non-temporal copy doesn't pay off the store fence. */
+#define NT_STORE_MIN_SIZE (256)
 
 #if !defined(__FreeBSD__)
 int alloc_hugepage_region(int alignment, uint64_t size, void **addr)
@@ -53,7 +83,183 @@ int alloc_hugepage_region(int alignment, uint64_t size, void **addr)
 
 	return SUCCESS;
 }
+
+/* The size of the pages of the mmap policies, 0 for the others. */
+static uint64_t host_mmap_page_size(struct host_memory_ctx *host_ctx)
+{
+	switch (host_ctx->page_policy) {
+	case PAGE_POLICY_MMAP_2M:
+		return HUGEPAGE_ALIGN;
+	case PAGE_POLICY_MMAP_1G:
+		return HUGEPAGE_1G_ALIGN;
+	case PAGE_POLICY_HUGETLBFS:
+		return host_ctx->hugetlbfs_page_size;
+	default:
+		return 0;
+	}
+}
+
+static int alloc_mmap_hugepage_region(struct host_memory_ctx *host_ctx, uint64_t size, void **addr)
+{
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+
+	flags |= (host_ctx->page_policy == PAGE_POLICY_MMAP_1G) ? MAP_HUGE_1GB : MAP_HUGE_2MB;
+	if (host_ctx->map_populate)
+		flags |= MAP_POPULATE;
+	*addr = mmap(NULL, ALIGN_UP(size, host_mmap_page_size(host_ctx)), PROT_READ | PROT_WRITE, flags, -1, 0);
+	if (*addr == MAP_FAILED) {
+		*addr = NULL;
+		fprintf(stderr, "Failed to map %s hugepages - %s. Please configure hugepages\n",
+			page_policy_str(host_ctx->page_policy), strerror(errno));
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+/* Maps an unlinked file on the hugetlbfs mount, in the page size of the mount. */
+static int alloc_hugetlbfs_region(struct host_memory_ctx *host_ctx, uint64_t size, void **addr)
+{
+	char path[PATH_MAX];
+	struct statfs fs;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/perftest.XXXXXX", host_ctx->hugetlbfs_dir);
+	fd = mkstemp(path);
+	if (fd < 0) {
+		fprintf(stderr, "Failed to create a file in %s - %s\n", host_ctx->hugetlbfs_dir, strerror(errno));
+		return FAILURE;
+	}
+	unlink(path);
+
+	if (fstatfs(fd, &fs) || fs.f_type != HUGETLBFS_MAGIC_NUM) {
+		fprintf(stderr, "%s is not a hugetlbfs mount\n", host_ctx->hugetlbfs_dir);
+		goto close_fd;
+	}
+	host_ctx->hugetlbfs_page_size = fs.f_bsize;
+
+	if (ftruncate(fd, ALIGN_UP(size, host_ctx->hugetlbfs_page_size))) {
+		fprintf(stderr, "Failed to size the hugetlbfs file - %s\n", strerror(errno));
+		goto close_fd;
+	}
+
+	*addr = mmap(NULL, ALIGN_UP(size, host_ctx->hugetlbfs_page_size), PROT_READ | PROT_WRITE,
+		     MAP_SHARED | (host_ctx->map_populate ? MAP_POPULATE : 0), fd, 0);
+	if (*addr == MAP_FAILED) {
+		*addr = NULL;
+		fprintf(stderr, "Failed to map the hugetlbfs file - %s\n", strerror(errno));
+		goto close_fd;
+	}
+
+	/* The mapping keeps the file. */
+	close(fd);
+	return SUCCESS;
+
+close_fd:
+	close(fd);
+	return FAILURE;
+}
+
+/* The default policy with --map_populate, an anonymous mapping trimmed to the alignment. */
+static int alloc_populated_region(int alignment, uint64_t size, void **addr)
+{
+	uint64_t page_size = sysconf(_SC_PAGESIZE);
+	uint64_t buf_alignment = ALIGN_UP(alignment, page_size);
+	uint64_t buf_size = ALIGN_UP(size, page_size);
+	uint64_t slack = buf_alignment - page_size;
+	uint64_t head;
+	char *region;
+
+	region = mmap(NULL, buf_size + slack, PROT_READ | PROT_WRITE,
+		      MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+	if (region == MAP_FAILED) {
+		*addr = NULL;
+		fprintf(stderr, "Failed to map the populated buffer - %s\n", strerror(errno));
+		return FAILURE;
+	}
+
+	head = ALIGN_UP((uintptr_t)region, buf_alignment) - (uintptr_t)region;
+	if (head)
+		munmap(region, head);
+	if (slack - head)
+		munmap(region + head + buf_size, slack - head);
+
+	*addr = region + head;
+	return SUCCESS;
+}
+
+/* THP and 4k pages are asked for with madvise, over an aligned allocation. */
+static int alloc_madvise_region(int page_policy, int alignment, uint64_t size, void **addr)
+{
+	uint64_t buf_alignment = (page_policy == PAGE_POLICY_THP) ? ALIGN_UP(alignment, HUGEPAGE_ALIGN) : alignment;
+	uint64_t buf_size = ALIGN_UP(size, buf_alignment);
+
+	if (posix_memalign(addr, buf_alignment, buf_size)) {
+		*addr = NULL;
+		return FAILURE;
+	}
+
+	if (madvise(*addr, buf_size, (page_policy == PAGE_POLICY_THP) ? MADV_HUGEPAGE : MADV_NOHUGEPAGE))
+		fprintf(stderr, "Warning: madvise of %s pages failed - %s\n", page_policy_str(page_policy), strerror(errno));
+
+	return SUCCESS;
+}
+#endif
+
+/* The copies of --copy_mode, the platforms without them copy with memcpy. */
+static void *nt_store_copy(void *dest, const void *src, size_t size)
+{
+#if defined(__x86_64__)
+	char *d = dest;
+	const char *s = src;
+	size_t head = (16 - ((uintptr_t)d & 15)) & 15;
+	__m128i x0, x1, x2, x3;
+
+	if (size < NT_STORE_MIN_SIZE)
+		return memcpy(dest, src, size);
+
+	/* The streaming stores need a 16 bytes aligned destination. */
+	memcpy(d, s, head);
+	d += head;
+	s += head;
+	size -= head;
+
+	for (; size >= 64; size -= 64, d += 64, s += 64) {
+		x0 = _mm_loadu_si128((const __m128i *)s);
+		x1 = _mm_loadu_si128((const __m128i *)(s + 16));
+		x2 = _mm_loadu_si128((const __m128i *)(s + 32));
+		x3 = _mm_loadu_si128((const __m128i *)(s + 48));
+		_mm_stream_si128((__m128i *)d, x0);
+		_mm_stream_si128((__m128i *)(d + 16), x1);
+		_mm_stream_si128((__m128i *)(d + 32), x2);
+		_mm_stream_si128((__m128i *)(d + 48), x3);
+	}
+	for (; size >= 16; size -= 16, d += 16, s += 16)
+		_mm_stream_si128((__m128i *)d, _mm_loadu_si128((const __m128i *)s));
+
+	memcpy(d, s, size);
+	/* Order the streaming stores before the doorbell of the post. */
+	_mm_sfence();
+	return dest;
+#else
+	return memcpy(dest, src, size);
+#endif
+}
+
+static void *rep_movsb_copy(void *dest, const void *src, size_t size)
+{
+#if defined(__x86_64__) && defined(__GNUC__)
+	void *d = dest;
+
+	__asm__ __volatile__("rep movsb"
+			     : "+D" (d), "+S" (src), "+c" (size)
+			     :
+			     : "memory");
+	return dest;
+#else
+	return memcpy(dest, src, size);
 #endif
+}
 
 int host_memory_init(struct memory_ctx *ctx) {
 	return SUCCESS;
@@ -72,13 +278,34 @@ int host_memory_allocate_buffer(struct memory_ctx *ctx, int alignment, uint64_t
 	posix_memalign(addr, alignment, size);
 #else
 	struct host_memory_ctx *host_ctx = container_of(ctx, struct host_memory_ctx, base);
-	if (host_ctx->use_hugepages) {
+	switch (host_ctx->page_policy) {
+	case PAGE_POLICY_SHM:
 		if (alloc_hugepage_region(alignment, size, addr) != 0){
 			fprintf(stderr, "Failed to allocate hugepage region.\n");
 			return FAILURE;
 		}
-	} else {
-		*addr = memalign(alignment, size);
+		break;
+	case PAGE_POLICY_MMAP_2M:
+	case PAGE_POLICY_MMAP_1G:
+		if (alloc_mmap_hugepage_region(host_ctx, size, addr))
+			return FAILURE;
+		break;
+	case PAGE_POLICY_HUGETLBFS:
+		if (alloc_hugetlbfs_region(host_ctx, size, addr))
+			return FAILURE;
+		break;
+	case PAGE_POLICY_THP:
+	case PAGE_POLICY_4K:
+		alloc_madvise_region(host_ctx->page_policy, alignment, size, addr);
+		break;
+	default:
+		if (host_ctx->map_populate) {
+			if (alloc_populated_region(alignment, size, addr))
+				return FAILURE;
+		} else {
+			*addr = memalign(alignment, size);
+		}
+		break;
 	}
 #endif
 	if (!*addr) {
@@ -86,7 +313,7 @@ int host_memory_allocate_buffer(struct memory_ctx *ctx, int alignment, uint64_t
 		return FAILURE;
 	}
 
-	memset(*addr, 0, size);
+	/* The pages are faulted in by the buffer initialization of the caller. */
 	*can_init = true;
 	return SUCCESS;
 }
@@ -94,10 +321,23 @@ int host_memory_allocate_buffer(struct memory_ctx *ctx, int alignment, uint64_t
 int host_memory_free_buffer(struct memory_ctx *ctx, int dmabuf_fd, void *addr, uint64_t size) {
 	struct host_memory_ctx *host_ctx = container_of(ctx, struct host_memory_ctx, base);
 
-	if (host_ctx->use_hugepages) {
+	switch (host_ctx->page_policy) {
+	case PAGE_POLICY_SHM:
 		shmdt(addr);
-	} else {
-		free(addr);
+		break;
+#if !defined(__FreeBSD__)
+	case PAGE_POLICY_MMAP_2M:
+	case PAGE_POLICY_MMAP_1G:
+	case PAGE_POLICY_HUGETLBFS:
+		munmap(addr, ALIGN_UP(size, host_mmap_page_size(host_ctx)));
+		break;
+#endif
+	default:
+		if (host_ctx->map_populate)
+			munmap(addr, ALIGN_UP(size, sysconf(_SC_PAGESIZE)));
+		else
+			free(addr);
+		break;
 	}
 	return SUCCESS;
 }
@@ -113,6 +353,15 @@ struct memory_ctx *host_memory_create(struct perftest_parameters *params) {
 	ctx->base.copy_host_to_buffer = memcpy;
 	ctx->base.copy_buffer_to_host = memcpy;
 	ctx->base.copy_buffer_to_buffer = memcpy;
-	ctx->use_hugepages = params->use_hugepages;
+	if (params->copy_mode == COPY_MODE_NT_STORE) {
+		ctx->base.copy_host_to_buffer = nt_store_copy;
+		ctx->base.copy_buffer_to_host = nt_store_copy;
+	} else if (params->copy_mode == COPY_MODE_REP_MOVSB) {
+		ctx->base.copy_host_to_buffer = rep_movsb_copy;
+		ctx->base.copy_buffer_to_host = rep_movsb_copy;
+	}
+	ctx->page_policy = params->page_policy;
+	ctx->hugetlbfs_dir = params->hugetlbfs_dir;
+	ctx->map_populate = params->map_populate;
 	return &ctx->base;
 }
@@ -161,7 +161,7 @@ static int post_one_recv_wqe(struct pingpong_context *ctx)
 	struct ibv_sge list;
 
 	list.addr   = (uintptr_t)ctx->buf[0];
-	list.length = sizeof(struct pingpong_dest);
+	list.length = CTRL_CM_MSG_SIZE;
 	list.lkey   = ctx->mr[0]->lkey;
 
 	wr.next = NULL;
@@ -834,6 +834,7 @@ int set_up_connection(struct pingpong_context *ctx,
 	union ibv_gid temp_gid;
 	union ibv_gid temp_gid2;
 	struct ibv_port_attr attr;
+	cycles_t phase_start = get_cycles();
 
 	srand48(getpid() * time(NULL));
 
@@ -949,6 +950,8 @@ int set_up_connection(struct pingpong_context *ctx,
 			}
 		}
 	}
+
+	setup_phase_add(SETUP_REPORT(user_param), SETUP_PHASE_SET_UP_CONNECTION, phase_start);
 	return 0;
 }
 
@@ -1098,7 +1101,7 @@ int rdma_client_connect(struct pingpong_context *ctx,struct perftest_parameters
 	}
 
 	memset(&conn_param, 0, sizeof conn_param);
-	if (user_param->verb == READ || user_param->verb == ATOMIC) {
+	if (USES_VERB(user_param, READ) || USES_VERB(user_param, ATOMIC)) {
 		conn_param.responder_resources = user_param->out_reads;
 		conn_param.initiator_depth = user_param->out_reads;
 	}
@@ -1259,7 +1262,7 @@ int rdma_server_connect(struct pingpong_context *ctx,
 	}
 
 	memset(&conn_param, 0, sizeof conn_param);
-	if (user_param->verb == READ || user_param->verb == ATOMIC) {
+	if (USES_VERB(user_param, READ) || USES_VERB(user_param, ATOMIC)) {
 		conn_param.responder_resources = user_param->out_reads;
 		conn_param.initiator_depth = user_param->out_reads;
 	}
@@ -1350,6 +1353,8 @@ int create_comm_struct(struct perftest_comm *comm,
 	comm->rdma_params->has_source_ip	= user_param->has_source_ip;
 	comm->rdma_params->memory_type		= MEMORY_HOST;
 	comm->rdma_params->memory_create	= host_memory_create;
+	/* The handshakes are accounted to the test parameters. */
+	comm->setup_report			= SETUP_REPORT(user_param);
 
 	if (user_param->use_rdma_cm) {
 
@@ -1377,7 +1382,8 @@ int create_comm_struct(struct perftest_comm *comm,
 		#ifdef HAVE_DCS
 		MAIN_ALLOC(comm->rdma_ctx->dci_stream_id,uint32_t, comm->rdma_params->num_of_qps, free_qpx);
 		#endif
-		comm->rdma_ctx->buff_size = user_param->cycle_buffer;
+		comm->rdma_ctx->buff_size = (user_param->cycle_buffer > CTRL_CM_MSG_SIZE) ?
+			user_param->cycle_buffer : CTRL_CM_MSG_SIZE;
 
 		if (create_rdma_resources(comm->rdma_ctx,comm->rdma_params)) {
 			fprintf(stderr," Unable to create the resources needed by comm struct\n");
@@ -1488,6 +1494,7 @@ int ctx_hand_shake(struct perftest_comm *comm,
 {
 	int (*read_func_ptr) (struct pingpong_dest*,struct perftest_comm*);
 	int (*write_func_ptr)(struct pingpong_dest*,struct perftest_comm*);
+	cycles_t phase_start = get_cycles();
 
 	if (comm->rdma_params->use_rdma_cm || comm->rdma_params->work_rdma_cm) {
 		read_func_ptr  = &rdma_read_keys;
@@ -1523,6 +1530,7 @@ int ctx_hand_shake(struct perftest_comm *comm,
 		}
 	}
 
+	setup_phase_add(comm->setup_report, SETUP_PHASE_HAND_SHAKE, phase_start);
 	return 0;
 }
 
@@ -1530,6 +1538,225 @@ int ctx_hand_shake(struct perftest_comm *comm,
 
 
 
+/******************************************************************************
+ *
+ ******************************************************************************/
+static int ethernet_read_full(struct perftest_comm *comm, uint8_t *buf, size_t size)
+{
+	ssize_t ret;
+
+	while (size) {
+		ret = read(comm->rdma_params->sockfd, buf, size);
+		if (ret <= 0) {
+			fprintf(stderr, "Couldn't read control message\n");
+			return FAILURE;
+		}
+		buf += ret;
+		size -= ret;
+	}
+
+	return SUCCESS;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static uint32_t bulk_dest_checksum(const uint8_t *data, size_t size)
+{
+	/* FNV-1a, enough to catch a torn or misaligned stream */
+	uint32_t hash = 2166136261u;
+	size_t i;
+
+	for (i = 0; i < size; i++) {
+		hash ^= data[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static void bulk_dest_pack(uint8_t *buf, struct pingpong_dest *dest, int num_of_qps)
+{
+	uint8_t *rec = buf + BULK_DEST_HDR_SIZE;
+	uint32_t payload_size = num_of_qps * BULK_DEST_REC_SIZE;
+	uint32_t val32;
+	uint64_t val64;
+	uint16_t magic = htons(BULK_DEST_MAGIC);
+	int i;
+
+	for (i = 0; i < num_of_qps; i++, rec += BULK_DEST_REC_SIZE) {
+		val32 = htonl(dest[i].lid);
+		memcpy(rec, &val32, 4);
+		val32 = htonl(dest[i].out_reads);
+		memcpy(rec + 4, &val32, 4);
+		val32 = htonl(dest[i].qpn);
+		memcpy(rec + 8, &val32, 4);
+		val32 = htonl(dest[i].psn);
+		memcpy(rec + 12, &val32, 4);
+		val32 = htonl(dest[i].rkey);
+		memcpy(rec + 16, &val32, 4);
+		val64 = hton_64(dest[i].vaddr);
+		memcpy(rec + 20, &val64, 8);
+		memcpy(rec + 28, dest[i].gid.raw, 16);
+		val32 = htonl(dest[i].srqn);
+		memcpy(rec + 40, &val32, 4);
+	}
+
+	memcpy(buf, &magic, sizeof(magic));
+	buf[2] = CTRL_PROTO_BULK_DEST;
+	buf[3] = 0;
+	val32 = htonl(num_of_qps);
+	memcpy(buf + 4, &val32, 4);
+	val32 = htonl(payload_size);
+	memcpy(buf + 8, &val32, 4);
+	val32 = htonl(bulk_dest_checksum(buf + BULK_DEST_HDR_SIZE, payload_size));
+	memcpy(buf + 12, &val32, 4);
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static int bulk_dest_check_hdr(const uint8_t *buf, int num_of_qps)
+{
+	uint16_t magic;
+	uint32_t count, payload_size;
+
+	memcpy(&magic, buf, sizeof(magic));
+	memcpy(&count, buf + 4, 4);
+	memcpy(&payload_size, buf + 8, 4);
+
+	if (ntohs(magic) != BULK_DEST_MAGIC || ntohl(payload_size) != ntohl(count) * BULK_DEST_REC_SIZE) {
+		fprintf(stderr, " Received a malformed QP information message\n");
+		return FAILURE;
+	}
+
+	if (ntohl(count) != num_of_qps) {
+		fprintf(stderr, " Remote side has %u QPs, expected %d\n", ntohl(count), num_of_qps);
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static int bulk_dest_unpack(const uint8_t *buf, struct pingpong_dest *dest, int num_of_qps)
+{
+	const uint8_t *rec = buf + BULK_DEST_HDR_SIZE;
+	uint32_t payload_size = num_of_qps * BULK_DEST_REC_SIZE;
+	uint32_t val32;
+	uint64_t val64;
+	int i;
+
+	memcpy(&val32, buf + 12, 4);
+	if (ntohl(val32) != bulk_dest_checksum(rec, payload_size)) {
+		fprintf(stderr, " QP information message checksum mismatch\n");
+		return FAILURE;
+	}
+
+	for (i = 0; i < num_of_qps; i++, rec += BULK_DEST_REC_SIZE) {
+		memcpy(&val32, rec, 4);
+		dest[i].lid = ntohl(val32);
+		memcpy(&val32, rec + 4, 4);
+		dest[i].out_reads = ntohl(val32);
+		memcpy(&val32, rec + 8, 4);
+		dest[i].qpn = ntohl(val32);
+		memcpy(&val32, rec + 12, 4);
+		dest[i].psn = ntohl(val32);
+		memcpy(&val32, rec + 16, 4);
+		dest[i].rkey = ntohl(val32);
+		memcpy(&val64, rec + 20, 8);
+		dest[i].vaddr = ntoh_64(val64);
+		memcpy(dest[i].gid.raw, rec + 28, 16);
+		memcpy(&val32, rec + 40, 4);
+		dest[i].srqn = ntohl(val32);
+	}
+
+	return SUCCESS;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+int ctx_hand_shake_bulk(struct perftest_comm *comm,
+		struct pingpong_dest *my_dest,
+		struct pingpong_dest *rem_dest,
+		int num_of_qps)
+{
+	const int chunk = CTRL_CM_MSG_SIZE;
+	uint8_t *my_buf = NULL, *rem_buf = NULL;
+	size_t size, alloc_size;
+	int i, rounds, rc = FAILURE;
+	cycles_t phase_start = get_cycles();
+
+	if (comm->rdma_params->rem_ctrl_proto < CTRL_PROTO_BULK_DEST) {
+		for (i = 0; i < num_of_qps; i++) {
+			if (ctx_hand_shake(comm, &my_dest[i], &rem_dest[i]))
+				return 1;
+		}
+		return 0;
+	}
+
+	size = BULK_DEST_HDR_SIZE + (size_t)num_of_qps * BULK_DEST_REC_SIZE;
+	/* Round up to whole control QP receives for the rdma_cm path */
+	rounds = (size + chunk - 1) / chunk;
+	alloc_size = (size_t)rounds * chunk;
+
+	my_buf = calloc(1, alloc_size);
+	rem_buf = calloc(1, alloc_size);
+	if (my_buf == NULL || rem_buf == NULL) {
+		fprintf(stderr, "failed to allocate memory\n");
+		goto free_bufs;
+	}
+
+	bulk_dest_pack(my_buf, my_dest, num_of_qps);
+
+	if (comm->rdma_params->use_rdma_cm || comm->rdma_params->work_rdma_cm) {
+		/* Both sides post CTRL_CM_MSG_SIZE receives, so a round trip carries
+		 * the records of about 90 QPs. */
+		for (i = 0; i < rounds; i++) {
+			if (ctx_xchg_data_rdma(comm, my_buf + i * chunk, rem_buf + i * chunk, chunk))
+				goto free_bufs;
+			if (i == 0 && bulk_dest_check_hdr(rem_buf, num_of_qps))
+				goto free_bufs;
+		}
+	} else {
+		if (comm->rdma_params->servername) {
+			if (ethernet_write_data(comm, (char *)my_buf, size))
+				goto free_bufs;
+			if (ethernet_read_full(comm, rem_buf, BULK_DEST_HDR_SIZE) ||
+			    bulk_dest_check_hdr(rem_buf, num_of_qps) ||
+			    ethernet_read_full(comm, rem_buf + BULK_DEST_HDR_SIZE, size - BULK_DEST_HDR_SIZE))
+				goto free_bufs;
+		} else {
+			if (ethernet_read_full(comm, rem_buf, BULK_DEST_HDR_SIZE) ||
+			    bulk_dest_check_hdr(rem_buf, num_of_qps) ||
+			    ethernet_read_full(comm, rem_buf + BULK_DEST_HDR_SIZE, size - BULK_DEST_HDR_SIZE))
+				goto free_bufs;
+			if (ethernet_write_data(comm, (char *)my_buf, size))
+				goto free_bufs;
+		}
+	}
+
+	if (bulk_dest_unpack(rem_buf, rem_dest, num_of_qps))
+		goto free_bufs;
+
+	for (i = 0; i < num_of_qps; i++)
+		rem_dest[i].gid_index = my_dest[i].gid_index;
+
+	setup_phase_add(comm->setup_report, SETUP_PHASE_HAND_SHAKE, phase_start);
+	rc = SUCCESS;
+
+free_bufs:
+	free(my_buf);
+	free(rem_buf);
+	return rc;
+}
+
 /******************************************************************************
  *
  ******************************************************************************/
@@ -1716,6 +1943,633 @@ int ctx_xchg_data( struct perftest_comm *comm,
 	return 0;
 }
 
+/******************************************************************************
+ *
+ ******************************************************************************/
+void ctrl_msg_init(struct ctrl_msg *msg)
+{
+	memset(msg, 0, sizeof(*msg));
+	msg->len = CTRL_MSG_HDR_SIZE;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+int ctrl_msg_put_u64(struct ctrl_msg *msg, uint16_t type, const uint64_t *vals, int count)
+{
+	uint16_t tlv_type = htons(type);
+	uint16_t tlv_len = htons((uint16_t)(count * sizeof(uint64_t)));
+	uint64_t val;
+	int i;
+
+	if (msg->len + CTRL_TLV_HDR_SIZE + count * sizeof(uint64_t) > CTRL_MSG_MAX_SIZE) {
+		fprintf(stderr, " Control message is full\n");
+		return FAILURE;
+	}
+
+	memcpy(msg->buf + msg->len, &tlv_type, sizeof(tlv_type));
+	memcpy(msg->buf + msg->len + 2, &tlv_len, sizeof(tlv_len));
+	msg->len += CTRL_TLV_HDR_SIZE;
+
+	for (i = 0; i < count; i++) {
+		val = hton_64(vals[i]);
+		memcpy(msg->buf + msg->len, &val, sizeof(val));
+		msg->len += sizeof(val);
+	}
+
+	return SUCCESS;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+int ctrl_msg_get_u64(const struct ctrl_msg *msg, uint16_t type, uint64_t *vals, int count)
+{
+	uint32_t offset = CTRL_MSG_HDR_SIZE;
+	uint16_t tlv_type, tlv_len;
+	uint64_t val;
+	int i;
+
+	/* Unknown TLVs are skipped so newer peers can add to the message. */
+	while (offset + CTRL_TLV_HDR_SIZE <= msg->len) {
+		memcpy(&tlv_type, msg->buf + offset, sizeof(tlv_type));
+		memcpy(&tlv_len, msg->buf + offset + 2, sizeof(tlv_len));
+		tlv_type = ntohs(tlv_type);
+		tlv_len = ntohs(tlv_len);
+		offset += CTRL_TLV_HDR_SIZE;
+
+		if (offset + tlv_len > msg->len)
+			break;
+
+		if (tlv_type == type) {
+			for (i = 0; i < count && (i + 1) * sizeof(uint64_t) <= tlv_len; i++) {
+				memcpy(&val, msg->buf + offset + i * sizeof(uint64_t), sizeof(val));
+				vals[i] = ntoh_64(val);
+			}
+			return i;
+		}
+		offset += tlv_len;
+	}
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static void ctrl_msg_set_hdr(struct ctrl_msg *msg)
+{
+	uint16_t magic = htons(CTRL_MSG_MAGIC);
+	uint32_t len = htonl(msg->len - CTRL_MSG_HDR_SIZE);
+
+	memcpy(msg->buf, &magic, sizeof(magic));
+	msg->buf[2] = CTRL_MSG_VERSION;
+	msg->buf[3] = 0;
+	memcpy(msg->buf + 4, &len, sizeof(len));
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static int ctrl_msg_parse_hdr(struct ctrl_msg *msg)
+{
+	uint16_t magic;
+	uint32_t len;
+
+	memcpy(&magic, msg->buf, sizeof(magic));
+	memcpy(&len, msg->buf + 4, sizeof(len));
+	len = ntohl(len);
+
+	if (ntohs(magic) != CTRL_MSG_MAGIC || len > CTRL_MSG_MAX_SIZE - CTRL_MSG_HDR_SIZE) {
+		fprintf(stderr, " Received a malformed control message\n");
+		return FAILURE;
+	}
+
+	msg->len = CTRL_MSG_HDR_SIZE + len;
+	return SUCCESS;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static int ethernet_read_ctrl_msg(struct perftest_comm *comm, struct ctrl_msg *msg)
+{
+	if (ethernet_read_full(comm, msg->buf, CTRL_MSG_HDR_SIZE))
+		return FAILURE;
+
+	if (ctrl_msg_parse_hdr(msg))
+		return FAILURE;
+
+	return ethernet_read_full(comm, msg->buf + CTRL_MSG_HDR_SIZE, msg->len - CTRL_MSG_HDR_SIZE);
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+int ctx_xchg_ctrl_msg(struct perftest_comm *comm, struct ctrl_msg *my_msg, struct ctrl_msg *rem_msg)
+{
+	const int chunk = sizeof(struct pingpong_dest);
+	uint32_t max_len;
+	int i, rounds;
+
+	ctrl_msg_set_hdr(my_msg);
+	memset(rem_msg, 0, sizeof(*rem_msg));
+
+	if (comm->rdma_params->use_rdma_cm || comm->rdma_params->work_rdma_cm) {
+		/* The rdma_cm control QP receives pingpong_dest sized messages,
+		 * so the first chunk carries the header and sets the round count. */
+		if (ctx_xchg_data_rdma(comm, my_msg->buf, rem_msg->buf, chunk))
+			return FAILURE;
+
+		if (ctrl_msg_parse_hdr(rem_msg))
+			return FAILURE;
+
+		max_len = (my_msg->len > rem_msg->len) ? my_msg->len : rem_msg->len;
+		rounds = (max_len + chunk - 1) / chunk;
+		for (i = 1; i < rounds; i++) {
+			if (ctx_xchg_data_rdma(comm, my_msg->buf + i * chunk, rem_msg->buf + i * chunk, chunk))
+				return FAILURE;
+		}
+
+		return SUCCESS;
+	}
+
+	if (comm->rdma_params->servername) {
+		if (ethernet_write_data(comm, (char *)my_msg->buf, my_msg->len))
+			return FAILURE;
+		if (ethernet_read_ctrl_msg(comm, rem_msg))
+			return FAILURE;
+	} else {
+		if (ethernet_read_ctrl_msg(comm, rem_msg))
+			return FAILURE;
+		if (ethernet_write_data(comm, (char *)my_msg->buf, my_msg->len))
+			return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static inline uint64_t double_to_u64(double x)
+{
+	union {
+		double ddata;
+		uint64_t u64data;
+	} d;
+
+	d.ddata = x;
+	return d.u64data;
+}
+
+static inline double u64_to_double(uint64_t x)
+{
+	union {
+		double ddata;
+		uint64_t u64data;
+	} d;
+
+	d.u64data = x;
+	return d.ddata;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static void xchg_bw_reports_ctrl_msg(struct perftest_comm *comm, struct bw_report_data *my_bw_rep,
+		struct bw_report_data *rem_bw_rep)
+{
+	struct ctrl_msg my_msg, rem_msg;
+	uint64_t fields[CTRL_BW_NUM_FIELDS];
+	uint64_t cpu_util;
+
+	fields[CTRL_BW_SIZE]		= my_bw_rep->size;
+	fields[CTRL_BW_ITERS]		= my_bw_rep->iters;
+	fields[CTRL_BW_SL]		= my_bw_rep->sl;
+	fields[CTRL_BW_PEAK]		= double_to_u64(my_bw_rep->bw_peak);
+	fields[CTRL_BW_AVG]		= double_to_u64(my_bw_rep->bw_avg);
+	fields[CTRL_BW_MSG_RATE_AVG]	= double_to_u64(my_bw_rep->msgRate_avg);
+	fields[CTRL_BW_AVG_P1]		= double_to_u64(my_bw_rep->bw_avg_p1);
+	fields[CTRL_BW_MSG_RATE_AVG_P1]	= double_to_u64(my_bw_rep->msgRate_avg_p1);
+	fields[CTRL_BW_AVG_P2]		= double_to_u64(my_bw_rep->bw_avg_p2);
+	fields[CTRL_BW_MSG_RATE_AVG_P2]	= double_to_u64(my_bw_rep->msgRate_avg_p2);
+
+	ctrl_msg_init(&my_msg);
+	if (ctrl_msg_put_u64(&my_msg, CTRL_TLV_BW_REPORT, fields, CTRL_BW_NUM_FIELDS)) {
+		fprintf(stderr," Failed to build the bw report message\n");
+		exit(1);
+	}
+	if (my_bw_rep->cpu_util > 0) {
+		cpu_util = (uint64_t)(my_bw_rep->cpu_util * CTRL_CPU_UTIL_SCALE + 0.5);
+		if (ctrl_msg_put_u64(&my_msg, CTRL_TLV_CPU_UTIL, &cpu_util, 1)) {
+			fprintf(stderr," Failed to build the bw report message\n");
+			exit(1);
+		}
+	}
+
+	if (ctx_xchg_ctrl_msg(comm, &my_msg, &rem_msg)) {
+		fprintf(stderr," Failed to exchange data between server and clients\n");
+		exit(1);
+	}
+
+	memset(fields, 0, sizeof(fields));
+	if (!ctrl_msg_get_u64(&rem_msg, CTRL_TLV_BW_REPORT, fields, CTRL_BW_NUM_FIELDS)) {
+		fprintf(stderr," Remote side did not send a bw report\n");
+		exit(1);
+	}
+
+	rem_bw_rep->size		= fields[CTRL_BW_SIZE];
+	rem_bw_rep->iters		= fields[CTRL_BW_ITERS];
+	rem_bw_rep->sl			= (int)fields[CTRL_BW_SL];
+	rem_bw_rep->bw_peak		= u64_to_double(fields[CTRL_BW_PEAK]);
+	rem_bw_rep->bw_avg		= u64_to_double(fields[CTRL_BW_AVG]);
+	rem_bw_rep->msgRate_avg		= u64_to_double(fields[CTRL_BW_MSG_RATE_AVG]);
+	rem_bw_rep->bw_avg_p1		= u64_to_double(fields[CTRL_BW_AVG_P1]);
+	rem_bw_rep->msgRate_avg_p1	= u64_to_double(fields[CTRL_BW_MSG_RATE_AVG_P1]);
+	rem_bw_rep->bw_avg_p2		= u64_to_double(fields[CTRL_BW_AVG_P2]);
+	rem_bw_rep->msgRate_avg_p2	= u64_to_double(fields[CTRL_BW_MSG_RATE_AVG_P2]);
+
+	if (ctrl_msg_get_u64(&rem_msg, CTRL_TLV_CPU_UTIL, &cpu_util, 1))
+		rem_bw_rep->cpu_util = (float)cpu_util / CTRL_CPU_UTIL_SCALE;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+int ctx_set_size_pass(struct perftest_comm *comm, struct perftest_parameters *user_param,
+		int pass, int sync)
+{
+	uint64_t step, min_iters, my_iters, rem_iters, probe_iters;
+	cycles_t probe_cycles;
+	double cycles_per_iter;
+	int num_of_qps;
+	int passes_per_size = SIZE_PASSES(user_param) / user_param->num_of_sizes;
+	int phase = pass % passes_per_size;
+
+	user_param->size = user_param->sizes[pass / passes_per_size];
+
+	/* With --sge the last pass of each size is the measured one, the pass
+	 * before it posts a single SGE per WR as the reference of its report.
+	 */
+	if (user_param->sge > 1) {
+		user_param->num_sge = (phase == passes_per_size - 1) ? user_param->sge : 1;
+		user_param->sge_ref_pass = (phase == passes_per_size - 2);
+	}
+
+	if (!user_param->time_per_size)
+		return SUCCESS;
+
+	if (!user_param->size_max_iters)
+		user_param->size_max_iters = user_param->iters;
+
+	/* Keep the iterations a multiple of the CQ moderation and post list,
+	 * and deep enough for the send and receive queues, as -n is.
+	 */
+	step = (uint64_t)user_param->cq_mod * user_param->post_list;
+	if (!step)
+		step = 1;
+	min_iters = SIZE_PROBE_ITERS;
+	if (min_iters < user_param->tx_depth)
+		min_iters = user_param->tx_depth;
+	if (min_iters < user_param->rx_depth)
+		min_iters = user_param->rx_depth;
+	min_iters = (min_iters + step - 1) / step * step;
+	if (min_iters > user_param->size_max_iters)
+		min_iters = user_param->size_max_iters;
+
+	/* The iterations of the probe hold for the rest of the passes of the size. */
+	if (phase > 1)
+		return SUCCESS;
+
+	if (phase == 0) {
+		user_param->num_sge = user_param->sge;
+		user_param->size_probe = ON;
+		user_param->iters = min_iters;
+		return SUCCESS;
+	}
+
+	/* The probe run is timed by its own stamps, as its report would be,
+	 * so the sync, warm up and prints around it don't count.
+	 */
+	if (user_param->tst == LAT) {
+		probe_cycles = user_param->tposted[user_param->iters - 1] - user_param->tposted[0];
+		probe_iters = user_param->iters - 1;
+	} else {
+		num_of_qps = user_param->num_of_qps;
+		if ((user_param->connection_type == DC || user_param->use_xrc) && user_param->duplex)
+			num_of_qps /= 2;
+		probe_cycles = user_param->tcompleted[user_param->noPeak ? 0 : user_param->iters * num_of_qps - 1] -
+			       user_param->tposted[0];
+		probe_iters = user_param->iters;
+	}
+
+	my_iters = min_iters;
+	if (probe_cycles > 0 && probe_iters > 0) {
+		cycles_per_iter = (double)probe_cycles / probe_iters;
+		my_iters = user_param->time_per_size * get_cpu_mhz(user_param->cpu_freq_f) * 1000 / cycles_per_iter;
+	}
+	my_iters = my_iters / step * step;
+	if (my_iters < min_iters)
+		my_iters = min_iters;
+	if (my_iters > user_param->size_max_iters)
+		my_iters = user_param->size_max_iters;
+
+	if (sync) {
+		uint64_t be_iters = htobe64(my_iters);
+
+		if (ctx_xchg_data(comm, &be_iters, &rem_iters, sizeof(rem_iters))) {
+			fprintf(stderr, " Failed to exchange the iterations of size %" PRIu64 "\n", user_param->size);
+			return FAILURE;
+		}
+		rem_iters = be64toh(rem_iters);
+		if (rem_iters > my_iters)
+			my_iters = rem_iters;
+	}
+
+	user_param->size_probe = OFF;
+	user_param->iters = my_iters;
+	return SUCCESS;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+/* A trial of the RFC 2544 search, as the client sees it. */
+struct rfc2544_trial {
+	uint64_t	sent;
+	uint64_t	received;
+	double		offered;	/* The rate limit in Mpps, 0 without it. */
+	double		rate;		/* The sent rate in Mpps. */
+	double		loss;		/* In percent. */
+};
+
+static int rfc2544_xchg(struct perftest_comm *comm, const uint64_t *fields, uint64_t *rem_fields)
+{
+	struct ctrl_msg my_msg, rem_msg;
+
+	ctrl_msg_init(&my_msg);
+	if (ctrl_msg_put_u64(&my_msg, CTRL_TLV_RFC2544, fields, CTRL_RFC2544_NUM_FIELDS))
+		return FAILURE;
+
+	if (ctx_xchg_ctrl_msg(comm, &my_msg, &rem_msg)) {
+		fprintf(stderr, " Failed to exchange the RFC 2544 trial\n");
+		return FAILURE;
+	}
+
+	memset(rem_fields, 0, CTRL_RFC2544_NUM_FIELDS * sizeof(uint64_t));
+	if (!ctrl_msg_get_u64(&rem_msg, CTRL_TLV_RFC2544, rem_fields, CTRL_RFC2544_NUM_FIELDS)) {
+		fprintf(stderr, " Remote side did not run the RFC 2544 search\n");
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+static void rfc2544_print(struct perftest_parameters *user_param, const uint64_t *fields)
+{
+	double rate = u64_to_double(fields[CTRL_RFC2544_RATE]);
+	double bw = (user_param->report_fmt == MBS) ? rate * 1000000 * user_param->size / 1048576 :
+		rate * user_param->size * 8 / 1000;
+
+	printf(RESULT_LINE);
+	printf(RESULT_FMT_RFC2544, (user_param->report_fmt == MBS) ? "MiB/sec" : "Gb/sec");
+	printf(REPORT_FMT_RFC2544, (unsigned long)user_param->size, (int)fields[CTRL_RFC2544_TRIALS],
+		user_param->rfc2544_loss, u64_to_double(fields[CTRL_RFC2544_MAX_RATE]), rate, bw,
+		u64_to_double(fields[CTRL_RFC2544_LOSS]));
+}
+
+/* The rate of the SW rate limiter in msg/sec, as run_iter_bw converts it. */
+static double rfc2544_limit_pps(struct perftest_parameters *user_param)
+{
+	switch (user_param->rate_units) {
+		case MEGA_BYTE_PS:
+			return user_param->rate_limit / user_param->size * 1048576;
+		case GIGA_BIT_PS:
+			return user_param->rate_limit / (user_param->size * 8) * 1000000000;
+		default:
+			return user_param->rate_limit;
+	}
+}
+
+/* Runs a trial of -D seconds at expected_pps, or a probe of RFC2544_PROBE_ITERS
+ * per QP without it, under a limit of limit_pps if set.
+ */
+static int rfc2544_client_trial(struct perftest_comm *comm, struct pingpong_context *ctx,
+		struct perftest_parameters *user_param, struct pingpong_dest *rem_dest,
+		double limit_pps, double expected_pps, struct rfc2544_trial *trial)
+{
+	double cycles_to_units = get_cpu_mhz(user_param->cpu_freq_f);
+	uint64_t step = user_param->post_list > 1 ? user_param->post_list : user_param->cq_mod;
+	uint64_t fields[CTRL_RFC2544_NUM_FIELDS] = {0};
+	uint64_t rem_fields[CTRL_RFC2544_NUM_FIELDS];
+	uint64_t iters = RFC2544_PROBE_ITERS;
+
+	if (expected_pps > 0)
+		iters = expected_pps * user_param->duration / user_param->num_of_qps;
+	if (iters < (uint64_t)user_param->tx_depth)
+		iters = user_param->tx_depth;
+	user_param->iters = (iters + step - 1) / step * step;
+	user_param->fill_count = 0;
+
+	if (limit_pps > 0) {
+		user_param->rate_limit_type = SW_RATE_LIMIT;
+		user_param->rate_units = PACKET_PS;
+		user_param->rate_limit = limit_pps;
+	} else {
+		user_param->rate_limit_type = DISABLE_RATE_LIMIT;
+	}
+
+	ctx_set_send_wqes(ctx, user_param, rem_dest);
+
+	/* The server counts for the trial and RFC2544_DRAIN_SEC more, from when it is ready. */
+	fields[CTRL_RFC2544_OP] = CTRL_RFC2544_TRIAL;
+	fields[CTRL_RFC2544_WINDOW] = expected_pps > 0 ? user_param->duration : 1;
+	if (rfc2544_xchg(comm, fields, rem_fields))
+		return FAILURE;
+
+	fields[CTRL_RFC2544_OP] = CTRL_RFC2544_READY;
+	if (rfc2544_xchg(comm, fields, rem_fields))
+		return FAILURE;
+
+	if (run_iter_bw(ctx, user_param))
+		return FAILURE;
+
+	trial->sent = user_param->iters * user_param->num_of_qps;
+	trial->offered = limit_pps / 1000000;
+	trial->rate = trial->sent / ((user_param->tcompleted[0] - user_param->tposted[0]) / cycles_to_units);
+
+	fields[CTRL_RFC2544_OP] = CTRL_RFC2544_COUNTS;
+	fields[CTRL_RFC2544_COUNT] = trial->sent;
+	if (rfc2544_xchg(comm, fields, rem_fields))
+		return FAILURE;
+
+	/* A late message of the previous trial may be counted in this one. */
+	trial->received = rem_fields[CTRL_RFC2544_COUNT];
+	if (trial->received > trial->sent) {
+		fprintf(stderr, " The server received %" PRIu64 " messages of the %" PRIu64 " sent in the trial,"
+			" late messages of a previous trial?\n", trial->received, trial->sent);
+		return FAILURE;
+	}
+	trial->loss = (double)(trial->sent - trial->received) * 100 / trial->sent;
+
+	return SUCCESS;
+}
+
+static void rfc2544_print_trial(struct perftest_parameters *user_param, int index,
+		const struct rfc2544_trial *trial, const char *result)
+{
+	if (user_param->output == FULL_VERBOSITY)
+		printf(REPORT_FMT_RFC2544_TRIAL, index, trial->offered, trial->rate,
+			trial->sent, trial->received, trial->loss, result);
+}
+
+static int rfc2544_server(struct perftest_comm *comm, struct pingpong_context *ctx,
+		struct perftest_parameters *user_param)
+{
+	uint64_t fields[CTRL_RFC2544_NUM_FIELDS] = {0};
+	uint64_t rem_fields[CTRL_RFC2544_NUM_FIELDS];
+	int duration = user_param->duration;
+	int margin = user_param->margin;
+	int return_value = SUCCESS;
+
+	/* Every message of a trial is counted, from the first one on. */
+	user_param->margin = 0;
+
+	while (1) {
+		fields[CTRL_RFC2544_OP] = CTRL_RFC2544_COUNTS;
+		fields[CTRL_RFC2544_COUNT] = 0;
+		if (rfc2544_xchg(comm, fields, rem_fields)) {
+			return_value = FAILURE;
+			break;
+		}
+
+		if (rem_fields[CTRL_RFC2544_OP] == CTRL_RFC2544_DONE) {
+			rfc2544_print(user_param, rem_fields);
+			break;
+		}
+
+		fields[CTRL_RFC2544_OP] = CTRL_RFC2544_READY;
+		if (rfc2544_xchg(comm, fields, rem_fields)) {
+			return_value = FAILURE;
+			break;
+		}
+
+		/* The window starts with the trial, so one that delivers nothing still ends. */
+		user_param->duration = rem_fields[CTRL_RFC2544_WINDOW] + RFC2544_DRAIN_SEC;
+		start_duration_window(user_param);
+		if (run_iter_bw_server(ctx, user_param)) {
+			return_value = FAILURE;
+			break;
+		}
+
+		fields[CTRL_RFC2544_COUNT] = user_param->recv_total;
+		if (rfc2544_xchg(comm, fields, rem_fields)) {
+			return_value = FAILURE;
+			break;
+		}
+	}
+
+	user_param->duration = duration;
+	user_param->margin = margin;
+	return return_value;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+int run_rfc2544(struct perftest_comm *comm, struct pingpong_context *ctx,
+		struct perftest_parameters *user_param, struct pingpong_dest *rem_dest)
+{
+	struct rfc2544_trial trial, best;
+	uint64_t fields[CTRL_RFC2544_NUM_FIELDS] = {0};
+	uint64_t rem_fields[CTRL_RFC2544_NUM_FIELDS];
+	int test_type = user_param->test_type;
+	enum rate_limiter_types rate_limit_type = user_param->rate_limit_type;
+	enum rate_limiter_units rate_units = user_param->rate_units;
+	double rate_limit = user_param->rate_limit;
+	double cap_pps = 0, max_pps, lo, hi, mid;
+	int trials = 0;
+	int return_value = FAILURE;
+
+	if (comm->rdma_params->rem_ctrl_proto < CTRL_PROTO_TLV_REPORTS) {
+		fprintf(stderr, " The remote side doesn't support the RFC 2544 search\n");
+		return FAILURE;
+	}
+
+	if (user_param->machine == SERVER)
+		return rfc2544_server(comm, ctx, user_param);
+
+	memset(&best, 0, sizeof(best));
+
+	/* A --rate_limit of the SW rate limiter caps the search. */
+	if (rate_limit_type == SW_RATE_LIMIT)
+		cap_pps = rfc2544_limit_pps(user_param);
+
+	/* The trials send a fixed count each, so all their completions are
+	 * polled before the next one, at the rate that fills -D seconds.
+	 */
+	user_param->test_type = ITERATIONS;
+
+	if (user_param->output == FULL_VERBOSITY) {
+		printf(RESULT_LINE);
+		printf(RESULT_FMT_RFC2544_TRIAL);
+	}
+
+	if (rfc2544_client_trial(comm, ctx, user_param, rem_dest, cap_pps, 0, &trial))
+		goto out;
+	rfc2544_print_trial(user_param, ++trials, &trial, "probe");
+
+	/* The first trial runs at the max rate of the sender, or at the cap. */
+	if (rfc2544_client_trial(comm, ctx, user_param, rem_dest, cap_pps,
+				 cap_pps > 0 ? cap_pps : trial.rate * 1000000, &trial))
+		goto out;
+	max_pps = trial.rate * 1000000;
+	fields[CTRL_RFC2544_MAX_RATE] = double_to_u64(trial.rate);
+
+	if (trial.loss <= user_param->rfc2544_loss) {
+		best = trial;
+		rfc2544_print_trial(user_param, ++trials, &trial, "pass");
+	} else {
+		rfc2544_print_trial(user_param, ++trials, &trial, "fail");
+
+		lo = 0;
+		hi = max_pps;
+		while (hi - lo > max_pps * user_param->rfc2544_res / 100 && trials < RFC2544_MAX_TRIALS) {
+			mid = (lo + hi) / 2;
+			if (rfc2544_client_trial(comm, ctx, user_param, rem_dest, mid, mid, &trial))
+				goto out;
+
+			if (trial.loss <= user_param->rfc2544_loss) {
+				lo = mid;
+				best = trial;
+				rfc2544_print_trial(user_param, ++trials, &trial, "pass");
+			} else {
+				hi = mid;
+				rfc2544_print_trial(user_param, ++trials, &trial, "fail");
+			}
+		}
+	}
+
+	fields[CTRL_RFC2544_OP] = CTRL_RFC2544_DONE;
+	fields[CTRL_RFC2544_RATE] = double_to_u64(best.rate);
+	fields[CTRL_RFC2544_LOSS] = double_to_u64(best.loss);
+	fields[CTRL_RFC2544_TRIALS] = trials;
+	if (rfc2544_xchg(comm, fields, rem_fields))
+		goto out;
+
+	rfc2544_print(user_param, fields);
+	return_value = SUCCESS;
+
+out:
+	user_param->test_type = test_type;
+	user_param->rate_limit_type = rate_limit_type;
+	user_param->rate_units = rate_units;
+	user_param->rate_limit = rate_limit;
+	user_param->iters = 0;
+	return return_value;
+}
+
 /******************************************************************************
  *
  ******************************************************************************/
@@ -1725,6 +2579,13 @@ void xchg_bw_reports (struct perftest_comm *comm, struct bw_report_data *my_bw_r
 	struct bw_report_data temp;
 	int size;
 
+	rem_bw_rep->cpu_util = 0;
+
+	if (comm->rdma_params->rem_ctrl_proto >= CTRL_PROTO_TLV_REPORTS) {
+		xchg_bw_reports_ctrl_msg(comm, my_bw_rep, rem_bw_rep);
+		return;
+	}
+
 	temp.size = hton_long(my_bw_rep->size);
 
 	if ( remote_version >= 5.33 )
@@ -1886,10 +2747,23 @@ int ctx_close_connection(struct perftest_comm *comm,
 void exchange_versions(struct perftest_comm *user_comm, struct perftest_parameters *user_param)
 {
 	if (!user_param->dont_xchg_versions) {
+		/* Older versions parse the string with atof() and never look past the NUL */
+		if (strlen(user_param->version) < CTRL_PROTO_MARK_OFFSET) {
+			user_param->version[CTRL_PROTO_MARK_OFFSET] = CTRL_PROTO_MARK;
+			user_param->version[CTRL_PROTO_MARK_OFFSET + 1] = CTRL_MSG_VERSION;
+		}
+
 		if (ctx_xchg_data(user_comm,(void*)(&user_param->version),(void*)(&user_param->rem_version),sizeof(user_param->rem_version))) {
 			fprintf(stderr," Failed to exchange data between server and clients\n");
 			exit(1);
 		}
+
+		if (user_param->rem_version[CTRL_PROTO_MARK_OFFSET] == CTRL_PROTO_MARK) {
+			user_param->rem_ctrl_proto = user_param->rem_version[CTRL_PROTO_MARK_OFFSET + 1];
+			if (user_param->rem_ctrl_proto > CTRL_MSG_VERSION)
+				user_param->rem_ctrl_proto = CTRL_MSG_VERSION;
+		}
+		user_comm->rdma_params->rem_ctrl_proto = user_param->rem_ctrl_proto;
 	}
 }
 
@@ -1940,7 +2814,7 @@ void check_sys_data(struct perftest_comm *user_comm, struct perftest_parameters
 	user_param->cache_line_size = (rem_cache_line_size > user_param->cache_line_size) ? rem_cache_line_size : user_param->cache_line_size;
 
 	/*update user_comm as well*/
-	if (user_param->use_rdma_cm) {
+	if (user_param->use_rdma_cm && user_param->cycle_buffer > CTRL_CM_MSG_SIZE) {
 		user_comm->rdma_ctx->buff_size = user_param->cycle_buffer;
 	}
 
@@ -2022,6 +2896,8 @@ int check_mtu(struct ibv_context *context,struct perftest_parameters *user_param
 						port_attr.max_msg_sz);
 					fprintf(stderr, " Changing to this size\n");
 					user_param->size = port_attr.max_msg_sz;
+					if (user_param->test_method == RUN_ALL)
+						trim_sizes(user_param, user_param->size);
 				} else {
 					fprintf(stderr," Max message size in SRD cannot be greater than %u \n",
 						port_attr.max_msg_sz);
@@ -2065,6 +2941,8 @@ int check_mtu(struct ibv_context *context,struct perftest_parameters *user_param
 						efa_device_attr.max_rdma_size);
 					fprintf(stderr, " Changing to this size\n");
 					user_param->size = efa_device_attr.max_rdma_size;
+					if (user_param->test_method == RUN_ALL)
+						trim_sizes(user_param, user_param->size);
 				} else {
 					fprintf(stderr, " Max RDMA request size in SRD cannot be greater than %u\n",
 						efa_device_attr.max_rdma_size);
@@ -2367,6 +3245,10 @@ int rdma_cm_address_handler(struct pingpong_context *ctx,
 {
 	int rc;
 	char *error_message;
+	struct cma_node *cm_node = cma_id->context;
+
+	if (cm_node)
+		cm_node->addr_resolved = get_cycles();
 
 	if (user_param->tos != DEF_TOS) {
 		rc = rdma_set_option(cma_id, RDMA_OPTION_ID,
@@ -2407,16 +3289,39 @@ error:
 ******************************************************************************/
 int rdma_cm_route_handler(struct pingpong_context *ctx,
 		struct perftest_parameters *user_param, struct rdma_cm_id *cma_id)
+{
+	struct cma_node *cm_node = cma_id->context;
+
+	if (cm_node)
+		cm_node->route_resolved = get_cycles();
+
+	/* Park the node until one of the connects in flight completes. */
+	if (cm_node && user_param->cm_inflight &&
+			ctx->cma_master.connects_in_flight >= user_param->cm_inflight) {
+		ctx->cma_master.pending_nodes[ctx->cma_master.pending_tail++] = cm_node->id;
+		return SUCCESS;
+	}
+
+	return rdma_cm_connect_node(ctx, user_param, cma_id);
+}
+
+/******************************************************************************
+*
+******************************************************************************/
+int rdma_cm_connect_node(struct pingpong_context *ctx,
+		struct perftest_parameters *user_param, struct rdma_cm_id *cma_id)
 {
 	int rc, connection_index;
 	char *error_message;
 	struct rdma_conn_param conn_param;
+	struct cma_node *cm_node = cma_id->context;
+	cycles_t phase_start;
 
 	ctx->context = cma_id->verbs;
 	connection_index = ctx->cma_master.connection_index;
-
-	// Initialization of client contexts in case of first connection:
-	if (connection_index == 0) {
+	// Initialization of client contexts in case of first connection,
+	// they are kept when the nodes reconnect (ib_conn_rate):
+	if (connection_index == 0 && !ctx->pd) {
 		rc = ctx_init(ctx, user_param);
 		if (rc) {
 			error_message = "Failed to initialize RDMA contexts.";
@@ -2425,15 +3330,17 @@ int rdma_cm_route_handler(struct pingpong_context *ctx,
 	}
 
 	ctx->cm_id = cma_id;
+	phase_start = get_cycles();
 	rc = create_qp_main(ctx, user_param, connection_index);
 	if (rc) {
 		error_message = "Failed to create QP.";
 		goto error;
 	}
+	setup_phase_add(SETUP_REPORT(user_param), SETUP_PHASE_CREATE_QPS, phase_start);
 
 	memset(&conn_param, 0, sizeof conn_param);
 
-	if (user_param->verb == READ || user_param->verb == ATOMIC) {
+	if (USES_VERB(user_param, READ) || USES_VERB(user_param, ATOMIC)) {
 		conn_param.responder_resources = user_param->out_reads;
 		conn_param.initiator_depth = user_param->out_reads;
 	}
@@ -2443,6 +3350,9 @@ int rdma_cm_route_handler(struct pingpong_context *ctx,
 	conn_param.private_data = ctx->cma_master.rai->ai_connect;
 	conn_param.private_data_len = ctx->cma_master.rai->ai_connect_len;
 
+	if (cm_node)
+		cm_node->connect_start = get_cycles();
+
 	rc = rdma_connect(cma_id, &conn_param);
 	if (rc) {
 		error_message = "Failed to connect through RDMA CM.";
@@ -2451,6 +3361,7 @@ int rdma_cm_route_handler(struct pingpong_context *ctx,
 
 	ctx->cma_master.nodes[connection_index].connected = 1;
 	ctx->cma_master.connection_index++;
+	ctx->cma_master.connects_in_flight++;
 	return rc;
 
 error:
@@ -2469,6 +3380,7 @@ int rdma_cm_connection_request_handler(struct pingpong_context *ctx,
 	char *error_message = "";
 	struct cma_node *cm_node;
 	struct rdma_conn_param conn_param;
+	cycles_t phase_start;
 	struct ibv_qp_attr rtr_attr = {
 		.min_rnr_timer = MIN_RNR_TIMER,
 	};
@@ -2483,8 +3395,9 @@ int rdma_cm_connection_request_handler(struct pingpong_context *ctx,
 	cm_node->cma_id = cma_id;
 
 	ctx->context = cma_id->verbs;
-	// Initialization of server contexts in case of first connection:
-	if (connection_index == 0) {
+	// Initialization of server contexts in case of first connection,
+	// they are kept when the nodes reconnect (ib_conn_rate):
+	if (connection_index == 0 && !ctx->pd) {
 		rc = ctx_init(ctx, user_param);
 		if (rc) {
 			error_message = "Failed to initialize RDMA contexts.";
@@ -2493,15 +3406,17 @@ int rdma_cm_connection_request_handler(struct pingpong_context *ctx,
 	}
 
 	ctx->cm_id = cm_node->cma_id;
+	phase_start = get_cycles();
 	rc = create_qp_main(ctx, user_param, connection_index);
 	if (rc) {
 		error_message = "Failed to create QP.";
 		goto error_2;
 	}
+	setup_phase_add(SETUP_REPORT(user_param), SETUP_PHASE_CREATE_QPS, phase_start);
 
 	memset(&conn_param, 0, sizeof(conn_param));
 
-	if (user_param->verb == READ || user_param->verb == ATOMIC) {
+	if (USES_VERB(user_param, READ) || USES_VERB(user_param, ATOMIC)) {
 		/* Clamp responder depth based on initiator resources on the peer */
 		conn_param.responder_resources =
 			(user_param->out_reads > event->param.conn.initiator_depth)
@@ -2583,8 +3498,20 @@ int rdma_cm_connection_established_handler(struct pingpong_context *ctx,
 	}
 
 	if (user_param->machine == CLIENT) {
+		struct cma_node *cm_node = event->id->context;
+
+		if (cm_node)
+			cm_node->established = get_cycles();
+
 		ctx->cma_master.connects_left--;
 		ctx->cma_master.disconnects_left++;
+		ctx->cma_master.connects_in_flight--;
+
+		/* Hand the connect slot to the next parked node. */
+		if (ctx->cma_master.pending_head < ctx->cma_master.pending_tail) {
+			cm_node = &ctx->cma_master.nodes[ctx->cma_master.pending_nodes[ctx->cma_master.pending_head++]];
+			rc = rdma_cm_connect_node(ctx, user_param, cm_node->cma_id);
+		}
 	}
 
 	return rc;
@@ -2810,6 +3737,50 @@ error:
 	return error_handler(error_message);
 }
 
+/******************************************************************************
+*
+******************************************************************************/
+static void print_cm_setup_report(struct pingpong_context *ctx,
+		struct perftest_parameters *user_param)
+{
+	const char *phase[] = {"address resolve", "route resolve", "connect wait", "connect"};
+	double cycles_to_msec = get_cpu_mhz(user_param->cpu_freq_f) * 1000;
+	double sum[4] = {0}, max[4] = {0}, delta[4], total;
+	cycles_t first = 0, last = 0;
+	struct cma_node *cm_node;
+	int i, j;
+
+	for (i = 0; i < user_param->num_of_qps; i++) {
+		cm_node = &ctx->cma_master.nodes[i];
+		delta[0] = cm_node->addr_resolved - cm_node->addr_start;
+		delta[1] = cm_node->route_resolved - cm_node->addr_resolved;
+		delta[2] = cm_node->connect_start - cm_node->route_resolved;
+		delta[3] = cm_node->established - cm_node->connect_start;
+		for (j = 0; j < 4; j++) {
+			sum[j] += delta[j];
+			if (delta[j] > max[j])
+				max[j] = delta[j];
+		}
+
+		if (!first || cm_node->addr_start < first)
+			first = cm_node->addr_start;
+		if (cm_node->established > last)
+			last = cm_node->established;
+	}
+
+	total = (last - first) / cycles_to_msec;
+
+	printf(RESULT_LINE);
+	printf("%s\n", RESULT_FMT_CM_SETUP);
+	for (j = 0; j < 4; j++)
+		printf(REPORT_FMT_CM_SETUP, phase[j],
+			sum[j] / user_param->num_of_qps / cycles_to_msec, max[j] / cycles_to_msec);
+	printf(REPORT_FMT_CM_SETUP_TOTAL, user_param->num_of_qps,
+		user_param->cm_inflight ? user_param->cm_inflight : user_param->num_of_qps,
+		total, total > 0 ? user_param->num_of_qps * 1000 / total : 0);
+	printf(RESULT_LINE);
+}
+
 /******************************************************************************
 *
 ******************************************************************************/
@@ -2826,7 +3797,15 @@ int _rdma_cm_client_connection(struct pingpong_context *ctx,
 		goto error;
 	}
 
+	ctx->cma_master.connects_in_flight = 0;
+	ctx->cma_master.pending_head = 0;
+	ctx->cma_master.pending_tail = 0;
+
+	/* All the nodes resolve their address at once, the routes and the
+	 * connects follow from the event loop as the events arrive.
+	 */
 	for (i = 0; i < user_param->num_of_qps; i++) {
+		ctx->cma_master.nodes[i].addr_start = get_cycles();
 		rc = rdma_resolve_addr(ctx->cma_master.nodes[i].cma_id,
 			ctx->cma_master.rai->ai_src_addr,
 			ctx->cma_master.rai->ai_dst_addr, 2000);
@@ -2843,6 +3822,9 @@ int _rdma_cm_client_connection(struct pingpong_context *ctx,
 		goto error;
 	}
 
+	if (user_param->report_cm_setup)
+		print_cm_setup_report(ctx, user_param);
+
 	return rc;
 
 error:
@@ -2890,6 +3872,7 @@ int create_rdma_cm_connection(struct pingpong_context *ctx,
 	int rc;
 	char *error_message;
 	struct rdma_addrinfo hints;
+	cycles_t phase_start;
 	memset(&hints, 0, sizeof(hints));
 	ctx->cma_master.connects_left = user_param->num_of_qps;
 
@@ -2912,6 +3895,7 @@ int create_rdma_cm_connection(struct pingpong_context *ctx,
 		goto destroy_rdma_id;
 	}
 
+	phase_start = get_cycles();
 	if (user_param->machine == CLIENT) {
 		rc = rdma_cm_client_connection(ctx, user_param, &hints);
 	} else {
@@ -2923,6 +3907,7 @@ int create_rdma_cm_connection(struct pingpong_context *ctx,
 		free(hints.ai_src_addr);
 		goto destroy_event_channel;
 	}
+	setup_phase_add(SETUP_REPORT(user_param), SETUP_PHASE_CONNECT, phase_start);
 
 	rc = ctx_hand_shake(comm, &my_dest[0], &rem_dest[0]);
 	if (rc) {
@@ -2942,6 +3927,7 @@ destroy_rdma_id:
 			rdma_destroy_id(ctx->cma_master.nodes[i].cma_id);
 	}
 	free(ctx->cma_master.nodes);
+	free(ctx->cma_master.pending_nodes);
 	free(hints.ai_src_addr);
 
 destroy_event_channel:
@@ -2952,6 +3938,69 @@ error:
 }
 
 
+/******************************************************************************
+*
+******************************************************************************/
+int run_iter_conn_rate_cm(struct pingpong_context *ctx,
+		struct perftest_parameters *user_param, struct perftest_comm *comm,
+		struct pingpong_dest *my_dest, struct pingpong_dest *rem_dest)
+{
+	int rc;
+	uint64_t i;
+	char *error_message;
+	cycles_t *step_cycles;
+	cycles_t stamp[CONN_CM_STEPS], start_cycles;
+
+	ALLOCATE(user_param->conn_step_cycles, cycles_t, user_param->iters * CONN_STEPS);
+	memset(user_param->conn_step_cycles, 0, sizeof(cycles_t) * user_param->iters * CONN_STEPS);
+
+	start_cycles = get_cycles();
+	for (i = 0; i < user_param->iters; i++) {
+		step_cycles = &user_param->conn_step_cycles[i * CONN_STEPS];
+
+		stamp[CONN_CM_STEP_DISCONNECT] = get_cycles();
+		rc = rdma_cm_disconnect_nodes(ctx, user_param);
+		if (rc) {
+			error_message = "Failed to disconnect RDMA CM nodes.";
+			goto error;
+		}
+
+		stamp[CONN_CM_STEP_DESTROY] = get_cycles();
+		rdma_cm_destroy_qps(ctx, user_param);
+		rc = rdma_cm_destroy_cma(ctx, user_param);
+		if (rc) {
+			error_message = "Failed to destroy RDMA CM contexts.";
+			goto error;
+		}
+
+		/* The device contexts, PD, CQs and MRs are kept, only the
+		 * CM IDs and the QPs are created again.
+		 */
+		ctx->cma_master.rai = NULL;
+		ctx->cma_master.connection_index = 0;
+		ctx->cma_master.disconnects_left = 0;
+
+		stamp[CONN_CM_STEP_CONNECT] = get_cycles();
+		rc = create_rdma_cm_connection(ctx, user_param, comm, my_dest, rem_dest);
+		if (rc) {
+			error_message = "Failed to create RDMA CM connection.";
+			goto error;
+		}
+		stamp[CONN_CM_STEP_TOTAL] = get_cycles();
+
+		step_cycles[CONN_CM_STEP_DISCONNECT] = stamp[CONN_CM_STEP_DESTROY] - stamp[CONN_CM_STEP_DISCONNECT];
+		step_cycles[CONN_CM_STEP_DESTROY] = stamp[CONN_CM_STEP_CONNECT] - stamp[CONN_CM_STEP_DESTROY];
+		step_cycles[CONN_CM_STEP_CONNECT] = stamp[CONN_CM_STEP_TOTAL] - stamp[CONN_CM_STEP_CONNECT];
+		step_cycles[CONN_CM_STEP_TOTAL] = stamp[CONN_CM_STEP_TOTAL] - stamp[CONN_CM_STEP_DISCONNECT];
+	}
+	user_param->conn_rate_cycles = get_cycles() - start_cycles;
+
+	return SUCCESS;
+
+error:
+	return error_handler(error_message);
+}
+
 /******************************************************************************
  * End
  ******************************************************************************/
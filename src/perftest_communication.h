@@ -101,10 +101,80 @@
 /* The print format of a global address or a multicast address. */
 #define PERF_RAW_MGID_FMT " %s: %02x:%02x:%02x:%02x:%02x:%02x:%02x:%02x:%02x:%02x:%02x:%02x:%02x:%02x:%02x:%02x\n"
 
+/* Control message protocol (length prefixed TLVs), advertised in the
+ * zero padded tail of the version string so older versions ignore it. */
+#define CTRL_PROTO_MARK_OFFSET	(MAX_VERSION - 3)
+#define CTRL_PROTO_MARK		('C')
+#define CTRL_MSG_MAGIC		(0x5054)
+#define CTRL_MSG_VERSION	(2)
+#define CTRL_PROTO_TLV_REPORTS	(1)	/* First version with TLV bw reports */
+#define CTRL_PROTO_BULK_DEST	(2)	/* First version with ctx_hand_shake_bulk */
+#define CTRL_MSG_HDR_SIZE	(8)
+#define CTRL_TLV_HDR_SIZE	(4)
+#define CTRL_MSG_MAX_SIZE	(4096)
+#define CTRL_CPU_UTIL_SCALE	(100)	/* CTRL_TLV_CPU_UTIL is in hundredths of a percent */
+
+enum ctrl_tlv_type {
+	CTRL_TLV_BW_REPORT	= 1,
+	CTRL_TLV_CPU_UTIL	= 2,
+	CTRL_TLV_RFC2544	= 3,
+};
+
+/* Fields of CTRL_TLV_BW_REPORT, in wire order. New fields are appended. */
+enum ctrl_bw_report_field {
+	CTRL_BW_SIZE,
+	CTRL_BW_ITERS,
+	CTRL_BW_SL,
+	CTRL_BW_PEAK,
+	CTRL_BW_AVG,
+	CTRL_BW_MSG_RATE_AVG,
+	CTRL_BW_AVG_P1,
+	CTRL_BW_MSG_RATE_AVG_P1,
+	CTRL_BW_AVG_P2,
+	CTRL_BW_MSG_RATE_AVG_P2,
+	CTRL_BW_NUM_FIELDS
+};
+
+/* Fields of CTRL_TLV_RFC2544, in wire order. The client starts each trial and
+ * sends its sent count after it, the server answers with its received count.
+ */
+enum ctrl_rfc2544_field {
+	CTRL_RFC2544_OP,
+	CTRL_RFC2544_WINDOW,	/* The receive window of the server, in seconds. */
+	CTRL_RFC2544_COUNT,
+	CTRL_RFC2544_RATE,	/* The result of the search, in msg/sec. */
+	CTRL_RFC2544_MAX_RATE,
+	CTRL_RFC2544_LOSS,
+	CTRL_RFC2544_TRIALS,
+	CTRL_RFC2544_NUM_FIELDS
+};
+
+enum ctrl_rfc2544_op {
+	CTRL_RFC2544_TRIAL,
+	CTRL_RFC2544_COUNTS,
+	CTRL_RFC2544_DONE,
+	CTRL_RFC2544_READY
+};
+
+/* Packed pingpong_dest array of ctx_hand_shake_bulk: header, then one record per QP. */
+#define BULK_DEST_MAGIC		(0x5044)
+#define BULK_DEST_HDR_SIZE	(16)
+#define BULK_DEST_REC_SIZE	(44)
+/* The receive size of the rdma_cm control QP. Older versions post pingpong_dest
+ * sized receives, so larger messages are only sent to peers with CTRL_PROTO_BULK_DEST. */
+#define CTRL_CM_MSG_SIZE	(4096)
+
+struct ctrl_msg {
+	uint32_t len;	/* Header + TLVs, in bytes */
+	/* Slack for the last pingpong_dest sized chunk over rdma_cm */
+	uint8_t buf[CTRL_MSG_MAX_SIZE + sizeof(struct pingpong_dest)];
+};
+
 struct perftest_comm {
 	struct pingpong_context    *rdma_ctx;
 	struct counter_context     *counter_ctx;
 	struct perftest_parameters *rdma_params;
+	struct setup_report        *setup_report;
 };
 
 /* bswap_double
@@ -237,6 +307,28 @@ int ctx_hand_shake(struct perftest_comm *comm,
 		struct pingpong_dest *my_dest,
 		struct pingpong_dest *rem_dest);
 
+/* ctx_hand_shake_bulk .
+ *
+ * Description :
+ *
+ *  Exchanges the pingpong_dest of all QPs at once, as one packed binary
+ *  message with a header and checksum, when the remote side supports it.
+ *  Falls back to one ctx_hand_shake per QP with older versions.
+ *
+ * Parameters :
+ *
+ *  comm       - contains connections info
+ *  my_dest    - Array of num_of_qps local entries.
+ *  rem_dest   - Array of num_of_qps entries to fill with the remote data.
+ *  num_of_qps - Number of entries.
+ *
+ * Return Value : 0 upon success. 1 if it fails.
+ */
+int ctx_hand_shake_bulk(struct perftest_comm *comm,
+		struct pingpong_dest *my_dest,
+		struct pingpong_dest *rem_dest,
+		int num_of_qps);
+
 
 
 /* ctx_print_pingpong_data.
@@ -413,6 +505,109 @@ int ctx_xchg_data_rdma( struct perftest_comm *comm, void *my_data, void *rem_dat
 void xchg_bw_reports (struct perftest_comm *comm, struct bw_report_data *my_bw_rep,
 		struct bw_report_data *rem_bw_rep, float remote_version);
 
+/* ctx_set_size_pass .
+ *
+ * Description :
+ *
+ *  Sets the message size of a pass of the sizes sweep (-a, --sizes).
+ *  With --time_per_size every size takes two passes: a probe of a few
+ *  iterations, then the measured pass whose iterations are calibrated
+ *  from the probe time, bounded by -n. When sync is set the two sides
+ *  agree on the larger of their iterations counts, so it must be set
+ *  whenever the remote side runs the sweep too.
+ *
+ * Parameters :
+ *
+ *  comm       - contains connections info
+ *  user_param - the perftest parameters.
+ *  pass       - the pass index, up to SIZE_PASSES(user_param).
+ *  sync       - exchange the calibrated iterations with the remote side.
+ *
+ * Return Value : SUCCESS, FAILURE if the exchange fails.
+ */
+int ctx_set_size_pass(struct perftest_comm *comm, struct perftest_parameters *user_param,
+		int pass, int sync);
+
+/* run_rfc2544 .
+ *
+ * Description :
+ *
+ *  The RFC 2544 throughput search of --rfc2544, on both sides.
+ *  The client sends trials of -D seconds at rates of the SW rate limiter,
+ *  a binary search below the max rate, and after each trial the server
+ *  returns the messages it received. A trial passes with at most
+ *  --rfc2544 loss, the search stops within its resolution of the max rate
+ *  and both sides print the highest passing rate.
+ *  The receive WQEs of the server must be posted.
+ *
+ * Parameters :
+ *
+ *  comm       - contains connections info
+ *  ctx        - Test Context.
+ *  user_param - the perftest parameters.
+ *  rem_dest   - pingpong_dest struct of the remote side, NULL for raw Ethernet.
+ *
+ * Return Value : SUCCESS, FAILURE.
+ */
+int run_rfc2544(struct perftest_comm *comm, struct pingpong_context *ctx,
+		struct perftest_parameters *user_param, struct pingpong_dest *rem_dest);
+
+/* ctrl_msg_init
+ *
+ * Description :
+ *  Prepares an empty control message (header only).
+ *
+ * Parameters :
+ *  msg - The control message.
+ */
+void ctrl_msg_init(struct ctrl_msg *msg);
+
+/* ctrl_msg_put_u64
+ *
+ * Description :
+ *  Appends a TLV of type holding count 64 bit values in network order.
+ *
+ * Parameters :
+ *  msg   - The control message.
+ *  type  - TLV type (enum ctrl_tlv_type).
+ *  vals  - Values to append.
+ *  count - Number of values.
+ *
+ * Return Value : SUCCESS, FAILURE (message full).
+ */
+int ctrl_msg_put_u64(struct ctrl_msg *msg, uint16_t type, const uint64_t *vals, int count);
+
+/* ctrl_msg_get_u64
+ *
+ * Description :
+ *  Looks up a TLV of type and copies up to count 64 bit values out of it.
+ *  Fields the sender did not know about are left untouched, extra fields are ignored.
+ *
+ * Parameters :
+ *  msg   - The received control message.
+ *  type  - TLV type (enum ctrl_tlv_type).
+ *  vals  - Output values.
+ *  count - Maximum number of values.
+ *
+ * Return Value : Number of values copied, 0 if the TLV is absent.
+ */
+int ctrl_msg_get_u64(const struct ctrl_msg *msg, uint16_t type, uint64_t *vals, int count);
+
+/* ctx_xchg_ctrl_msg
+ *
+ * Description :
+ *  Exchanges one length prefixed control message with the remote side,
+ *  over the socket in a single round trip, or in pingpong_dest sized chunks over rdma_cm.
+ *
+ * Parameters :
+ *  comm    - contains connections info
+ *  my_msg  - The message to send.
+ *  rem_msg - The received message.
+ *
+ * Return Value : SUCCESS, FAILURE.
+ */
+int ctx_xchg_ctrl_msg(struct perftest_comm *comm, struct ctrl_msg *my_msg, struct ctrl_msg *rem_msg);
+
 /* exchange_versions.
  *
  * Description :
@@ -610,7 +805,9 @@ int rdma_cm_address_handler(struct pingpong_context *ctx,
 *
 *    Initializes context for the test per connection in the client side
 *    and connects through rdma_connect RDMA CM API function. After receiving
-*    RDMA_CM_EVENT_ADDR_RESOLVED event from RDMA CM API.
+*    RDMA_CM_EVENT_ROUTE_RESOLVED event from RDMA CM API.
+*    With --cm_inflight, the node is parked while the limit of connects
+*    in flight is reached.
 *
 * Parameters:
 *
@@ -625,6 +822,27 @@ int rdma_cm_address_handler(struct pingpong_context *ctx,
 int rdma_cm_route_handler(struct pingpong_context *ctx,
 		struct perftest_parameters *user_param, struct rdma_cm_id *cma_id);
 
+/* rdma_cm_connect_node:
+*
+* Description:
+*
+*    Creates the QP of the node and connects it through rdma_connect.
+*    Called from rdma_cm_route_handler, or when a connect slot is freed
+*    for a node parked by --cm_inflight.
+*
+* Parameters:
+*
+*    ctx - Application contexts.
+*    user_param - User parameters from the parser.
+*    cma_id - RDMA CM ID.
+*
+* Return value:
+*    rc - On success: SUCCESS(0), on failure: FAILURE(1).
+*
+*/
+int rdma_cm_connect_node(struct pingpong_context *ctx,
+		struct perftest_parameters *user_param, struct rdma_cm_id *cma_id);
+
 /* rdma_cm_connection_request_handler:
 *
 * Description:
@@ -858,6 +1076,31 @@ int create_rdma_cm_connection(struct pingpong_context *ctx,
 		struct perftest_parameters *user_param, struct perftest_comm *comm,
 		struct pingpong_dest *my_dest, struct pingpong_dest *rem_dest);
 
+/* run_iter_conn_rate_cm:
+*
+* Description:
+*
+*    The RDMA CM flavor of the connection establishment rate test.
+*    Each round disconnects the connected nodes, destroys their QPs and
+*    CM IDs and connects them again through create_rdma_cm_connection.
+*    The cycles of every step are kept in user_param->conn_step_cycles.
+*
+* Parameters:
+*
+*    ctx - Application contexts.
+*    user_param - User parameters from the parser.
+*    comm - Communication information.
+*    my_dest - Local node destination communication information.
+*    rem_dest - Remote node destination communication information.
+*
+* Return value:
+*    rc - On success: SUCCESS(0), on failure: FAILURE(1).
+*
+*/
+int run_iter_conn_rate_cm(struct pingpong_context *ctx,
+		struct perftest_parameters *user_param, struct perftest_comm *comm,
+		struct pingpong_dest *my_dest, struct pingpong_dest *rem_dest);
+
 
 #endif /* PERFTEST_COMMUNICATION_H */
 
@@ -125,3 +125,28 @@ void counters_close(struct counter_context *ctx)
 	free(ctx->counter_list);
 	free(ctx);
 }
+
+int counters_read_value(const char *dev_name, int port,
+		const char *counter_name, unsigned long long *value)
+{
+	char read_buf[COUNTER_VALUE_MAX_LEN] = {0};
+	char *path;
+	int fd;
+	ssize_t len;
+
+	if (!dev_name || asprintf(&path, COUNTER_PATH, dev_name, port, counter_name) == -1)
+		return FAILURE;
+
+	fd = open(path, O_RDONLY);
+	free(path);
+	if (fd < 0)
+		return FAILURE;
+
+	len = read(fd, read_buf, COUNTER_VALUE_MAX_LEN - 1);
+	close(fd);
+	if (len <= 0)
+		return FAILURE;
+
+	*value = strtoull(read_buf, NULL, 10);
+	return SUCCESS;
+}
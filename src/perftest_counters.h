@@ -25,4 +25,10 @@ void counters_print(struct counter_context *ctx);
  */
 void counters_close(struct counter_context *ctx);
 
+/*
+ * Read a single counter of the port once (example: "hw_counters/out_of_buffer").
+ */
+int counters_read_value(const char *dev_name, int port,
+		const char *counter_name, unsigned long long *value);
+
 #endif
@@ -0,0 +1,154 @@
+#include <string.h>
+#include <pthread.h>
+#include "perftest_crc32c.h"
+
+#if defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+#endif
+
+#define CRC32C_POLY (0x82F63B78)
+
+typedef uint32_t (*crc32c_func)(uint32_t crc, const unsigned char *buf, size_t len);
+
+static uint32_t crc32c_table[8][256];
+static crc32c_func crc32c_update;
+static const char *crc32c_impl_name;
+static pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+
+/* Slicing-by-8, eight bytes per step out of eight tables. */
+static uint32_t crc32c_sw(uint32_t crc, const unsigned char *buf, size_t len)
+{
+	uint64_t word;
+
+	while (len && ((uintptr_t)buf & 7)) {
+		crc = crc32c_table[0][(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+		len--;
+	}
+
+	#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	while (len >= 8) {
+		memcpy(&word, buf, sizeof(word));
+		word ^= crc;
+		crc = crc32c_table[7][word & 0xff] ^
+		      crc32c_table[6][(word >> 8) & 0xff] ^
+		      crc32c_table[5][(word >> 16) & 0xff] ^
+		      crc32c_table[4][(word >> 24) & 0xff] ^
+		      crc32c_table[3][(word >> 32) & 0xff] ^
+		      crc32c_table[2][(word >> 40) & 0xff] ^
+		      crc32c_table[1][(word >> 48) & 0xff] ^
+		      crc32c_table[0][word >> 56];
+		buf += 8;
+		len -= 8;
+	}
+	#else
+	(void)word;
+	#endif
+
+	while (len--)
+		crc = crc32c_table[0][(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+
+	return crc;
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const unsigned char *buf, size_t len)
+{
+	uint64_t crc64, word;
+
+	while (len && ((uintptr_t)buf & 7)) {
+		crc = __builtin_ia32_crc32qi(crc, *buf++);
+		len--;
+	}
+
+	crc64 = crc;
+	while (len >= 8) {
+		memcpy(&word, buf, sizeof(word));
+		crc64 = __builtin_ia32_crc32di(crc64, word);
+		buf += 8;
+		len -= 8;
+	}
+	crc = (uint32_t)crc64;
+
+	while (len--)
+		crc = __builtin_ia32_crc32qi(crc, *buf++);
+
+	return crc;
+}
+#endif
+
+#if defined(__aarch64__) && defined(__linux__) && defined(__GNUC__)
+__attribute__((target("+crc")))
+static uint32_t crc32c_armv8(uint32_t crc, const unsigned char *buf, size_t len)
+{
+	uint64_t word;
+
+	while (len && ((uintptr_t)buf & 7)) {
+		crc = __builtin_aarch64_crc32cb(crc, *buf++);
+		len--;
+	}
+
+	while (len >= 8) {
+		memcpy(&word, buf, sizeof(word));
+		crc = __builtin_aarch64_crc32cx(crc, word);
+		buf += 8;
+		len -= 8;
+	}
+
+	while (len--)
+		crc = __builtin_aarch64_crc32cb(crc, *buf++);
+
+	return crc;
+}
+#endif
+
+static void crc32c_init(void)
+{
+	uint32_t crc;
+	int i, j;
+
+	for (i = 0; i < 256; i++) {
+		crc = i;
+		for (j = 0; j < 8; j++)
+			crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+		crc32c_table[0][i] = crc;
+	}
+	for (i = 0; i < 256; i++) {
+		for (j = 1; j < 8; j++)
+			crc32c_table[j][i] = crc32c_table[0][crc32c_table[j - 1][i] & 0xff] ^
+					     (crc32c_table[j - 1][i] >> 8);
+	}
+
+	crc32c_update = crc32c_sw;
+	crc32c_impl_name = "sw";
+
+	#if defined(__x86_64__) && defined(__GNUC__)
+	if (__builtin_cpu_supports("sse4.2")) {
+		crc32c_update = crc32c_sse42;
+		crc32c_impl_name = "sse4.2";
+	}
+	#endif
+	#if defined(__aarch64__) && defined(__linux__) && defined(__GNUC__)
+	if (getauxval(AT_HWCAP) & HWCAP_CRC32) {
+		crc32c_update = crc32c_armv8;
+		crc32c_impl_name = "armv8";
+	}
+	#endif
+}
+
+uint32_t perftest_crc32c(uint32_t crc, const void *buf, size_t len)
+{
+	pthread_once(&crc32c_once, crc32c_init);
+
+	return ~crc32c_update(~crc, buf, len);
+}
+
+const char *perftest_crc32c_impl(void)
+{
+	pthread_once(&crc32c_once, crc32c_init);
+
+	return crc32c_impl_name;
+}
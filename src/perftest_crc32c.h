@@ -0,0 +1,18 @@
+#ifndef PERFTEST_CRC32C_H
+#define PERFTEST_CRC32C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * CRC32C (Castagnoli) of len bytes, continuing from crc (0 to start).
+ * Uses the SSE4.2 or the ARMv8 CRC instructions when the CPU has them.
+ */
+uint32_t perftest_crc32c(uint32_t crc, const void *buf, size_t len);
+
+/*
+ * The implementation perftest_crc32c runs with: "sse4.2", "armv8" or "sw".
+ */
+const char *perftest_crc32c_impl(void);
+
+#endif
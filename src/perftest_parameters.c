@@ -10,6 +10,8 @@
 #include <sys/stat.h>
 #endif
 #include "perftest_parameters.h"
+#include "perftest_crc32c.h"
+#include "perftest_seq_track.h"
 #include "mlx5_devx.h"
 #include "raw_ethernet_resources.h"
 #include "host_memory.h"
@@ -30,12 +32,21 @@
 #define MAC_ARR_LEN (6)
 #define HEX_BASE (16)
 #define DEFAULT_JSON_FILE_NAME "perftest_out.json"
+#define DEFAULT_SETUP_JSON_FILE_NAME "perftest_setup.json"
 static const char *connStr[] = {"RC","UC","UD","RawEth","XRC","DC","SRD"};
 static const char *testsStr[] = {"Send","RDMA_Write","RDMA_Write_imm","RDMA_Read","Atomic"};
 static const char *portStates[] = {"Nop","Down","Init","Armed","","Active Defer"};
 static const char *qp_state[] = {"OFF","ON"};
 static const char *exchange_state[] = {"Ethernet","rdma_cm"};
 static const char *atomicTypesStr[] = {"CMP_AND_SWAP","FETCH_AND_ADD"};
+static const char *sgeLayoutStr[] = {"contiguous","scatter","mr"};
+static const char *remotePatternStr[] = {"OFF","seq","stride","random","zipf"};
+static const char *pagePolicyStr[] = {"default","shm","2m","1g","hugetlbfs","thp","4k"};
+static const char *bufInitStr[] = {"auto","random","zero","pattern","none"};
+static const char *copyModeStr[] = {"none","memcpy","nt_store","rep_movsb"};
+static const char *regModeStr[] = {"static","per_op","cached"};
+static const char *touchStr[] = {"none","tx_write","rx_read","both"};
+static const char *consumerDelayStr[] = {"none","fixed","exp","uniform"};
 #ifdef HAVE_HNSDV
 static const char *congestStr[] = {"DCQCN","LDCP","HC3","DIP"};
 #endif
@@ -115,6 +126,477 @@ static int parse_ethertype_from_str(char *ether_str, uint16_t *ethertype_val)
 	return SUCCESS;
 }
 
+static int parse_size_from_str(char *size_str, uint64_t *size)
+{
+	char *end;
+	uint64_t factor = 1;
+
+	*size = strtoull(size_str, &end, 0);
+	switch (*end) {
+	case 'G':
+		factor *= 1024;
+		/* fall through */
+	case 'M':
+		factor *= 1024;
+		/* fall through */
+	case 'K':
+		factor *= 1024;
+		end++;
+		break;
+	default:
+		break;
+	}
+
+	if (end == size_str || (*end != '\0' && *end != ':' && *end != ',') || !*size)
+		return FAILURE;
+
+	*size *= factor;
+	return SUCCESS;
+}
+
+/* Parses a comma separated list of sizes and geometric ranges <min>:<max>[:<factor>],
+ * for example "64,1500,4K:1M:4". The sizes are swept in the given order.
+ */
+static int parse_sizes_from_str(struct perftest_parameters *user_param, char *sizes_str)
+{
+	char *item = sizes_str, *sep;
+	uint64_t min_size, max_size, next;
+	double factor;
+
+	ALLOCATE(user_param->sizes, uint64_t, MAX_SIZES_NUM);
+	user_param->num_of_sizes = 0;
+
+	while (item) {
+		if (parse_size_from_str(item, &min_size))
+			return FAILURE;
+
+		max_size = min_size;
+		factor = DEF_SIZES_FACTOR;
+		sep = item + strcspn(item, ":,");
+		if (*sep == ':') {
+			if (parse_size_from_str(sep + 1, &max_size) || max_size < min_size)
+				return FAILURE;
+
+			sep += 1 + strcspn(sep + 1, ":,");
+			if (*sep == ':') {
+				factor = strtod(sep + 1, &sep);
+				if ((*sep != '\0' && *sep != ',') || !(factor > 1))
+					return FAILURE;
+			}
+		}
+
+		while (min_size <= max_size) {
+			if (user_param->num_of_sizes == MAX_SIZES_NUM)
+				return FAILURE;
+			user_param->sizes[user_param->num_of_sizes++] = min_size;
+
+			next = (uint64_t)ceil(min_size * factor);
+			min_size = next > min_size ? next : min_size + 1;
+		}
+
+		item = (*sep == ',') ? sep + 1 : NULL;
+	}
+
+	return SUCCESS;
+}
+
+/* Builds the alias table of the size classes with Vose's method, so each draw
+ * is a single uniform column and a biased coin.
+ */
+static void build_size_dist_alias(struct size_dist *dist)
+{
+	double prob[MAX_SIZE_DIST_CLASSES], sum = 0;
+	int small[MAX_SIZE_DIST_CLASSES], large[MAX_SIZE_DIST_CLASSES];
+	int num_small = 0, num_large = 0;
+	int i, s, l;
+
+	for (i = 0; i < dist->num; i++)
+		sum += dist->weights[i];
+
+	for (i = 0; i < dist->num; i++) {
+		dist->weights[i] /= sum;
+		prob[i] = dist->weights[i] * dist->num;
+		dist->alias[i] = i;
+		if (prob[i] < 1.0)
+			small[num_small++] = i;
+		else
+			large[num_large++] = i;
+	}
+
+	while (num_small && num_large) {
+		s = small[--num_small];
+		l = large[--num_large];
+		dist->thresh[s] = (uint64_t)(prob[s] * 4294967296.0);
+		dist->alias[s] = l;
+		prob[l] -= 1.0 - prob[s];
+		if (prob[l] < 1.0)
+			small[num_small++] = l;
+		else
+			large[num_large++] = l;
+	}
+
+	/* The leftovers are full columns, up to rounding errors. */
+	while (num_large)
+		dist->thresh[large[--num_large]] = 1ULL << 32;
+	while (num_small)
+		dist->thresh[small[--num_small]] = 1ULL << 32;
+
+	dist->rng = SIZE_DIST_SEED;
+}
+
+/* Parses an empirical CDF file, a "<size> <cumulative fraction>" line per class.
+ * Empty lines and lines starting with '#' are skipped.
+ */
+static int parse_size_dist_file(struct size_dist *dist, FILE *file)
+{
+	char line[256];
+	char *size_str, *cdf_str, *end;
+	uint64_t size;
+	double cdf, prev_cdf = 0;
+
+	while (fgets(line, sizeof(line), file)) {
+		size_str = strtok(line, " \t,:\r\n");
+		if (!size_str || *size_str == '#')
+			continue;
+
+		cdf_str = strtok(NULL, " \t,:\r\n");
+		if (!cdf_str || parse_size_from_str(size_str, &size))
+			return FAILURE;
+
+		cdf = strtod(cdf_str, &end);
+		if (*end != '\0' || cdf < prev_cdf)
+			return FAILURE;
+
+		/* A class without probability mass is never drawn. */
+		if (cdf == prev_cdf)
+			continue;
+
+		if (dist->num == MAX_SIZE_DIST_CLASSES)
+			return FAILURE;
+		dist->sizes[dist->num] = size;
+		dist->weights[dist->num++] = cdf - prev_cdf;
+		prev_cdf = cdf;
+	}
+
+	return dist->num ? SUCCESS : FAILURE;
+}
+
+/* Parses --size_dist, either a file (see parse_size_dist_file) or a comma
+ * separated list of <size>:<weight> classes, for example "64:70,4K:20,1M:10".
+ */
+static int parse_size_dist_from_str(struct perftest_parameters *user_param, char *dist_str)
+{
+	struct size_dist *dist = &user_param->size_dist;
+	char *item = dist_str, *sep;
+	FILE *file;
+	double weight;
+	int rc;
+
+	dist->num = 0;
+	file = fopen(dist_str, "r");
+	if (file) {
+		rc = parse_size_dist_file(dist, file);
+		fclose(file);
+		if (rc)
+			return FAILURE;
+		build_size_dist_alias(dist);
+		return SUCCESS;
+	}
+
+	while (item) {
+		if (dist->num == MAX_SIZE_DIST_CLASSES ||
+				parse_size_from_str(item, &dist->sizes[dist->num]))
+			return FAILURE;
+
+		sep = item + strcspn(item, ":,");
+		if (*sep != ':')
+			return FAILURE;
+
+		weight = strtod(sep + 1, &sep);
+		if ((*sep != '\0' && *sep != ',') || !(weight > 0))
+			return FAILURE;
+
+		dist->weights[dist->num++] = weight;
+		item = (*sep == ',') ? sep + 1 : NULL;
+	}
+
+	build_size_dist_alias(dist);
+	return SUCCESS;
+}
+
+/* Parses --verb_mix, a comma separated list of <verb>:<weight>, where the verb
+ * is write, read or atomic (fetch and add), for example "read:60,write:30,atomic:10".
+ */
+static int parse_verb_mix_from_str(struct perftest_parameters *user_param, char *mix_str)
+{
+	static const char *mix_verbs_str[] = {"write", "read", "atomic"};
+	static const VerbType mix_verbs[] = {WRITE, READ, ATOMIC};
+	struct verb_mix *mix = &user_param->verb_mix;
+	char *item = mix_str, *sep;
+	double weight, sum = 0;
+	int i, len;
+
+	mix->num = 0;
+	mix->mask = 0;
+	while (item) {
+		sep = item + strcspn(item, ":,");
+		if (*sep != ':' || mix->num == VERB_MIX_MAX)
+			return FAILURE;
+
+		len = sep - item;
+		for (i = 0; i < VERB_MIX_MAX; i++) {
+			if ((int)strlen(mix_verbs_str[i]) == len && !strncmp(item, mix_verbs_str[i], len))
+				break;
+		}
+		if (i == VERB_MIX_MAX || (mix->mask & (1 << mix_verbs[i])))
+			return FAILURE;
+
+		weight = strtod(sep + 1, &sep);
+		if ((*sep != '\0' && *sep != ',') || !(weight > 0))
+			return FAILURE;
+
+		mix->verbs[mix->num] = mix_verbs[i];
+		mix->weights[mix->num++] = weight;
+		mix->mask |= 1 << mix_verbs[i];
+		sum += weight;
+		item = (*sep == ',') ? sep + 1 : NULL;
+	}
+
+	weight = 0;
+	for (i = 0; i < mix->num; i++) {
+		mix->weights[i] /= sum;
+		weight += mix->weights[i];
+		mix->thresh[i] = (uint64_t)(weight * 4294967296.0);
+	}
+
+	mix->rng = VERB_MIX_SEED;
+	user_param->atomicType = FETCH_AND_ADD;
+	return SUCCESS;
+}
+
+/* Parses --sge_sizes, a comma separated list of the length of each SGE of a WR,
+ * for example "64,4K" splits a header from its payload. Returns the number of SGEs.
+ */
+static int parse_sge_sizes_from_str(struct perftest_parameters *user_param, char *sizes_str)
+{
+	char *item = sizes_str;
+	int num = 0;
+
+	memset(user_param->sge_sizes, 0, sizeof(user_param->sge_sizes));
+	while (item) {
+		if (num == MAX_SGE_NUM || parse_size_from_str(item, &user_param->sge_sizes[num]))
+			return 0;
+
+		num++;
+		item = strchr(item, ',');
+		if (item)
+			item++;
+	}
+
+	return num;
+}
+
+/* Parses --page_policy, hugetlbfs takes an optional :<dir> of the mount. */
+static int parse_page_policy_from_str(struct perftest_parameters *user_param, char *policy_str)
+{
+	int i;
+
+	if (strncmp(policy_str, "hugetlbfs:", strlen("hugetlbfs:")) == 0) {
+		user_param->page_policy = PAGE_POLICY_HUGETLBFS;
+		free(user_param->hugetlbfs_dir);
+		user_param->hugetlbfs_dir = strdup(policy_str + strlen("hugetlbfs:"));
+		return (user_param->hugetlbfs_dir && *user_param->hugetlbfs_dir) ? SUCCESS : FAILURE;
+	}
+
+	for (i = 0; i <= PAGE_POLICY_4K; i++) {
+		if (strcmp(pagePolicyStr[i], policy_str) == 0) {
+			user_param->page_policy = i;
+			return SUCCESS;
+		}
+	}
+
+	return FAILURE;
+}
+
+static int parse_buf_init_from_str(struct perftest_parameters *user_param, char *init_str)
+{
+	int i;
+
+	for (i = BUF_INIT_RANDOM; i <= BUF_INIT_NONE; i++) {
+		if (strcmp(bufInitStr[i], init_str) == 0) {
+			user_param->buf_init = i;
+			return SUCCESS;
+		}
+	}
+
+	return FAILURE;
+}
+
+static int parse_copy_mode_from_str(struct perftest_parameters *user_param, char *mode_str)
+{
+	int i;
+
+	for (i = COPY_MODE_NONE; i <= COPY_MODE_REP_MOVSB; i++) {
+		if (strcmp(copyModeStr[i], mode_str) == 0) {
+			user_param->copy_mode = i;
+			return SUCCESS;
+		}
+	}
+
+	return FAILURE;
+}
+
+static int parse_reg_mode_from_str(struct perftest_parameters *user_param, char *mode_str)
+{
+	int i;
+
+	for (i = REG_MODE_STATIC; i <= REG_MODE_CACHED; i++) {
+		if (strcmp(regModeStr[i], mode_str) == 0) {
+			user_param->reg_mode = i;
+			return SUCCESS;
+		}
+	}
+
+	return FAILURE;
+}
+
+static int parse_touch_from_str(struct perftest_parameters *user_param, char *touch_str)
+{
+	int i;
+
+	for (i = TOUCH_TX_WRITE; i <= TOUCH_BOTH; i++) {
+		if (strcmp(touchStr[i], touch_str) == 0) {
+			user_param->touch = i;
+			return SUCCESS;
+		}
+	}
+
+	return FAILURE;
+}
+
+/* Parses --consumer_delay, one of <usec>, exp:<mean usec> or uniform:<min usec>-<max usec>. */
+static int parse_consumer_delay_from_str(struct perftest_parameters *user_param, char *delay_str)
+{
+	char *end;
+
+	if (strncmp(delay_str, "exp:", strlen("exp:")) == 0) {
+		user_param->consumer_delay = CONSUMER_DELAY_EXP;
+		user_param->consumer_delay_usec = strtod(delay_str + strlen("exp:"), &end);
+	} else if (strncmp(delay_str, "uniform:", strlen("uniform:")) == 0) {
+		user_param->consumer_delay = CONSUMER_DELAY_UNIFORM;
+		user_param->consumer_delay_usec = strtod(delay_str + strlen("uniform:"), &end);
+		if (*end != '-')
+			return FAILURE;
+		user_param->consumer_delay_max_usec = strtod(end + 1, &end);
+		if (user_param->consumer_delay_max_usec < user_param->consumer_delay_usec)
+			return FAILURE;
+	} else {
+		user_param->consumer_delay = CONSUMER_DELAY_FIXED;
+		user_param->consumer_delay_usec = strtod(delay_str, &end);
+	}
+
+	if (*end != '\0' || end == delay_str || user_param->consumer_delay_usec < 0)
+		return FAILURE;
+
+	return SUCCESS;
+}
+
+/* Parses --rfc2544, <max loss %>[:<resolution %>]. */
+static int parse_rfc2544_from_str(struct perftest_parameters *user_param, char *rfc2544_str)
+{
+	char *end;
+
+	user_param->rfc2544_loss = strtod(rfc2544_str, &end);
+	if (end == rfc2544_str || user_param->rfc2544_loss < 0 || user_param->rfc2544_loss >= 100)
+		return FAILURE;
+
+	if (*end == ':') {
+		rfc2544_str = end + 1;
+		user_param->rfc2544_res = strtod(rfc2544_str, &end);
+		if (end == rfc2544_str || user_param->rfc2544_res <= 0 || user_param->rfc2544_res > 50)
+			return FAILURE;
+	}
+
+	if (*end != '\0')
+		return FAILURE;
+
+	user_param->rfc2544 = 1;
+	return SUCCESS;
+}
+
+/* Parses --recv_classes, a comma separated list of increasing receive buffer sizes,
+ * for example "256,4K,64K".
+ */
+static int parse_recv_classes_from_str(struct perftest_parameters *user_param, char *classes_str)
+{
+	char *item = classes_str;
+	uint64_t size;
+
+	if (strchr(classes_str, ':'))
+		return FAILURE;
+
+	user_param->recv_classes = 0;
+	while (item) {
+		if (user_param->recv_classes == MAX_RECV_CLASSES || parse_size_from_str(item, &size))
+			return FAILURE;
+		if (user_param->recv_classes && size <= user_param->recv_class_size[user_param->recv_classes - 1])
+			return FAILURE;
+
+		user_param->recv_class_size[user_param->recv_classes++] = size;
+		item = strchr(item, ',');
+		if (item)
+			item++;
+	}
+
+	return SUCCESS;
+}
+
+/* Parses --reg_pool, <buffers>[:seq|:random]. */
+static int parse_reg_pool_from_str(struct perftest_parameters *user_param, char *pool_str)
+{
+	char *end;
+	unsigned long pool = strtoul(pool_str, &end, 0);
+
+	if (end == pool_str || pool < 1 || pool > MAX_REG_POOL)
+		return FAILURE;
+
+	if (*end == '\0' || strcmp(end, ":seq") == 0)
+		user_param->reg_pool_random = 0;
+	else if (strcmp(end, ":random") == 0)
+		user_param->reg_pool_random = 1;
+	else
+		return FAILURE;
+
+	user_param->reg_pool = pool;
+	return SUCCESS;
+}
+
+/* Parses --remote_pattern, one of seq, stride:<bytes>, random or zipf:<theta>. */
+static int parse_remote_pattern_from_str(struct perftest_parameters *user_param, char *pattern_str)
+{
+	char *end;
+
+	if (strcmp(pattern_str, "seq") == 0) {
+		user_param->remote_pattern = REMOTE_PATTERN_SEQ;
+	} else if (strcmp(pattern_str, "random") == 0) {
+		user_param->remote_pattern = REMOTE_PATTERN_RANDOM;
+	} else if (strncmp(pattern_str, "stride:", strlen("stride:")) == 0) {
+		if (parse_size_from_str(pattern_str + strlen("stride:"), &user_param->remote_stride) ||
+				strchr(pattern_str, ','))
+			return FAILURE;
+		user_param->remote_pattern = REMOTE_PATTERN_STRIDE;
+	} else if (strncmp(pattern_str, "zipf:", strlen("zipf:")) == 0) {
+		user_param->remote_zipf_theta = strtod(pattern_str + strlen("zipf:"), &end);
+		if (*end != '\0' || !(user_param->remote_zipf_theta > 0 && user_param->remote_zipf_theta < 1))
+			return FAILURE;
+		user_param->remote_pattern = REMOTE_PATTERN_ZIPF;
+	} else {
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
 static int parse_flow_label_from_str(struct perftest_parameters *user_param, char *flow_label_str)
 {
 	int fl_cnt = 1;
@@ -492,6 +974,65 @@ static void usage(const char *argv0, VerbType verb, TestType tst, int connection
 	printf("      --cqe_poll ");
 	printf(" Number of CQEs polled per iteration \n");
 
+	printf("      --qp_threads=<num of threads> ");
+	printf(" Create, connect and destroy the QPs with a pool of threads, and report the QPs/s of each phase (default %d)\n", DEF_QP_THREADS);
+
+	if (tst == LAT) {
+		printf("      --reg_sizes=<min>:<max> ");
+		printf(" Range of buffer sizes swept by ib_reg_mr_rate in powers of 2, with K/M/G suffixes (default 4K:1G)\n");
+	}
+
+	printf("      --cm_inflight=<num of connects> ");
+	printf(" Limit the RDMA CM connects in flight, and report the setup time of each phase. Valid only with -R (default unlimited)\n");
+
+	if (verb != ATOMIC && connection_type != RawEth) {
+		printf("      --sizes=<list> ");
+		printf(" Run the listed sizes and geometric ranges <min>:<max>[:<factor>] instead of the powers of 2, e.g. 64,1500,4K:1M:4 (SYMMETRIC)\n");
+
+		printf("      --time_per_size=<msec> ");
+		printf(" Calibrate the iterations of each size of the sweep from a short probe to run about <msec>, bounded by -n (SYMMETRIC)\n");
+	}
+
+	if ((tst == BW || tst == LAT) && (verb == WRITE || verb == READ || verb == SEND) && connection_type != RawEth) {
+		printf("      --size_dist=<spec|file> ");
+		printf(" Draw each message size from <size>:<weight> classes, e.g. 64:70,4K:20,1M:10, or from a file of \"<size> <cumulative fraction>\" lines (SYMMETRIC)\n");
+	}
+
+	if (tst == BW && (verb == WRITE || verb == READ)) {
+		printf("      --verb_mix=<spec> ");
+		printf(" Draw the opcode of each message from <verb>:<weight> of write, read and atomic (fetch and add), e.g. read:60,write:30,atomic:10. RC only (SYMMETRIC)\n");
+	}
+
+	if (tst == BW && (verb == WRITE || verb == READ || verb == SEND)) {
+		printf("      --sge=<num> ");
+		printf(" Gather each WR from <num> SGEs, and scatter it to <num> SGEs in SEND, max %d. A single SGE pass of each size is the reference of the report. RC and UC only (SYMMETRIC)\n", MAX_SGE_NUM);
+
+		printf("      --sge_sizes=<list> ");
+		printf(" The length of each SGE, e.g. 64,4K for a header and data split. The message size is their sum (default: an even split of -s) (SYMMETRIC)\n");
+
+		printf("      --sge_layout=<layout> ");
+		printf(" The SGEs of a WR are contiguous, scatter (on separate pages) or mr (on separate pages and MRs) (default contiguous) (SYMMETRIC)\n");
+	}
+
+	if (tst == BW && verb != SEND) {
+		printf("      --remote_pattern=<pattern> ");
+		printf(" The order of the remote addresses: seq, stride:<bytes>, random or zipf:<theta> (0 < theta < 1), from a precomputed sequence per QP\n");
+
+		printf("      --remote_region=<size> ");
+		printf(" The size of the remote region of each QP for --remote_pattern, e.g. 16G (default: the buffer size). Both halves of the buffer grow to it (SYMMETRIC)\n");
+	}
+
+	if (tst == BW && (verb == WRITE || verb == READ)) {
+		printf("      --autotune ");
+		printf(" Search the post list, CQ moderation, TX depth, inline and CQE poll with the best message rate (bounded by -t and -I), then run the test with it\n");
+	}
+
+	printf("      --report_setup ");
+	printf(" Report the time of each setup and teardown phase (device open, MR, CQ and QP creation, handshakes, connect, destroy)\n");
+
+	printf("      --perf_events=<list of perf events> ");
+	printf(" Count CPU perf events in the measured window, reported per operation and per byte (example: \"cycles,instructions,LLC-load-misses,dTLB-load-misses\")\n");
+
 	#ifdef HAVE_HNSDV
 	printf("      --congest_type=<DCQCN, LDCP, HC3, DIP> ");
 	printf(" Use the hnsdv interface to set congestion control algorithm.\n");
@@ -690,6 +1231,91 @@ static void usage(const char *argv0, VerbType verb, TestType tst, int connection
 
 		printf("      --use_hugepages ");
 		printf(" Use Hugepages instead of contig, memalign allocations.\n");
+
+		printf("      --page_policy=<policy> ");
+		printf(" Allocate the host buffers with default (memalign), shm (as --use_hugepages), 2m or 1g (mmap MAP_HUGETLB),\n");
+		printf("                              hugetlbfs[:<dir>] (a file on a hugetlbfs mount, default %s), thp (madvise MADV_HUGEPAGE) or 4k (MADV_NOHUGEPAGE)\n", DEF_HUGETLBFS_DIR);
+	}
+
+	printf("      --buf_init=<random|zero|pattern|none> ");
+	printf(" Fill the buffers with random data, zeros, the --payload_file_path pattern or leave them untouched, the pages are pre-faulted in parallel before the registration\n");
+
+	if (tst == BW && (verb == SEND || verb == WRITE || verb == WRITE_IMM || verb == READ)) {
+		printf("      --verify ");
+		printf(" Stamp each message with a sequence number and a CRC32C and check them on the receiver (SEND, WRITE_IMM), or the last message of every buffer slot after the run (WRITE, READ)\n");
+	}
+
+	if (tst == BW && connection_type != RawEth && (verb == SEND || verb == WRITE || verb == WRITE_IMM || verb == READ)) {
+		printf("      --copy_mode=<none|memcpy|nt_store|rep_movsb> ");
+		printf(" Copy each message between an unregistered application buffer and its registered slot, before the post (SEND, WRITE, WRITE_IMM)\n");
+		printf("                              or after the completion (SEND and WRITE_IMM receivers, READ), with memcpy, non-temporal stores or rep movsb\n");
+	}
+
+	if (tst == BW && connection_type != RawEth && (verb == SEND || verb == WRITE || verb == WRITE_IMM || verb == READ)) {
+		printf("      --reg_mode=<static|per_op|cached> ");
+		printf(" Register the local buffer of each message once up front (default), before each post and deregister it at the completion,\n");
+		printf("                              or through an LRU registration cache, the buffers are taken from a pool of unregistered buffers\n");
+
+		printf("      --reg_cache_size=<entries> ");
+		printf(" The registrations the --reg_mode=cached cache keeps (default %d)\n", DEF_REG_CACHE_SIZE);
+
+		printf("      --reg_pool=<buffers>[:seq|:random] ");
+		printf(" The buffers --reg_mode rotates over, in order or at random (default %d:seq)\n", DEF_REG_POOL);
+	}
+
+	if ((tst == BW && (verb == SEND || verb == WRITE || verb == WRITE_IMM)) || (tst == LAT && verb == SEND)) {
+		printf("      --touch=<tx_write|rx_read|both> ");
+		printf(" Write the payload of each message before the post, and read it after the receive completion (SEND, WRITE_IMM)\n");
+
+		printf("      --touch_fraction=<percent> ");
+		printf(" The part of the payload --touch accesses, from its start (default 100)\n");
+
+		printf("      --touch_stride=<bytes> ");
+		printf(" The distance between the 8 bytes words --touch accesses, 8 touches every byte (default %d)\n", DEF_TOUCH_STRIDE);
+	}
+
+	if (tst == BW && connection_type != RawEth && (verb == SEND || verb == WRITE_IMM)) {
+		printf("      --consumer_delay=<usec|exp:<mean>|uniform:<min>-<max>> ");
+		printf(" Hold each receive buffer for a think time in usec before it is reposted, the receive pool of a QP is --rx-depth.\n");
+		printf("                              Reports the RNR NAKs of the receiver and, given to the sender too, its stalls\n");
+
+		printf("      --credits ");
+		printf(" Send credits of the reposted receive buffers to the sender, which waits for them instead of RNR retries (both sides)\n");
+	}
+
+	if (tst == BW && verb == SEND) {
+		printf("      --seq_track ");
+		printf(" Stamp a sequence number per QP and flow in each message, the receiver reports losses, duplicates,\n");
+		printf("                              reordering and loss bursts (UD, UC, raw Ethernet and RC, both sides)\n");
+	}
+
+	if (tst == BW && verb == SEND) {
+		printf("      --rfc2544=<max loss %%>[:<resolution %%>] ");
+		printf(" Binary search the highest rate of the SW rate limiter with at most <max loss %%>, in -D long trials,\n");
+		printf("                              to <resolution %%> of the max rate (default %.1f). UD and raw Ethernet, both sides\n",
+			RFC2544_DEF_RESOLUTION);
+	}
+
+	if (tst == BW && (verb == WRITE || verb == READ)) {
+		printf("      --object_size=<size> ");
+		printf(" Transfer objects of <size>, e.g. 2G, in -s chunks striped over the QPs (and ports with --dualport),\n");
+		printf("                              -n objects one after the other. Reports the time per object and the slowest stripe tail\n");
+	}
+
+	if (tst == BW && connection_type != RawEth && verb == SEND) {
+		printf("      --recv_classes=<size>[,<size>...] ");
+		printf(" Receive --size_dist messages in size classes, an SRQ per class out of one registered arena.\n");
+		printf("                              QP i carries the sizes of class i %% <classes>, needs -D and both sides\n");
+	}
+
+	if (connection_type != RawEth) {
+		printf("      --map_populate ");
+		printf(" Pre-fault the host buffers at allocation with mmap MAP_POPULATE (default, 2m, 1g and hugetlbfs page policies)\n");
+	}
+
+	if (tst == BW) {
+		printf("      --working_set=<size> ");
+		printf(" Spread the local and remote addresses over a buffer of <size> on each side, e.g. 4G, instead of a page per QP (SYMMETRIC)\n");
 	}
 
 	if (verb == WRITE || verb == WRITE_IMM || verb == READ) {
@@ -991,6 +1617,80 @@ static void init_perftest_params(struct perftest_parameters *user_param)
 	user_param->connectionless		= OFF;
 	user_param->cqe_poll		= CTX_POLL_BATCH;
 	user_param->use_cqe_poll		= OFF;
+	user_param->qp_threads		= DEF_QP_THREADS;
+	user_param->reg_min_size		= DEF_REG_MR_MIN_SIZE;
+	user_param->reg_max_size		= DEF_REG_MR_MAX_SIZE;
+	user_param->report_qp_rate	= OFF;
+	user_param->cm_inflight		= 0;
+	user_param->report_cm_setup	= OFF;
+	user_param->report_setup	= OFF;
+	user_param->sizes		= NULL;
+	user_param->num_of_sizes	= 0;
+	user_param->time_per_size	= 0;
+	user_param->autotune		= OFF;
+	user_param->size_dist.num	= 0;
+	user_param->size_dist.classes	= NULL;
+	user_param->verb_mix.num	= 0;
+	user_param->verb_mix.mask	= 0;
+	user_param->sge			= 1;
+	user_param->sge_layout		= SGE_CONTIGUOUS;
+	user_param->num_sge		= 1;
+	user_param->sge_ref_pass	= OFF;
+	memset(user_param->sge_sizes, 0, sizeof(user_param->sge_sizes));
+	user_param->remote_pattern	= REMOTE_PATTERN_OFF;
+	user_param->remote_region	= 0;
+	user_param->page_policy		= PAGE_POLICY_DEFAULT;
+	user_param->hugetlbfs_dir	= NULL;
+	user_param->working_set		= 0;
+	user_param->buf_init		= BUF_INIT_AUTO;
+	user_param->map_populate	= 0;
+	user_param->verify		= 0;
+	user_param->verify_msgs		= 0;
+	user_param->verify_bytes	= 0;
+	user_param->verify_errors	= 0;
+	user_param->verify_cycles	= 0;
+	user_param->copy_mode		= COPY_MODE_NONE;
+	user_param->copy_msgs		= 0;
+	user_param->copy_bytes		= 0;
+	user_param->copy_cycles		= 0;
+	user_param->reg_mode		= REG_MODE_STATIC;
+	user_param->reg_cache_size	= DEF_REG_CACHE_SIZE;
+	user_param->reg_pool		= DEF_REG_POOL;
+	user_param->reg_pool_random	= 0;
+	user_param->reg_msgs		= 0;
+	user_param->reg_hits		= 0;
+	user_param->reg_misses		= 0;
+	user_param->reg_evictions	= 0;
+	user_param->reg_cycles		= 0;
+	user_param->touch		= TOUCH_NONE;
+	user_param->touch_fraction	= 100;
+	user_param->touch_stride	= DEF_TOUCH_STRIDE;
+	user_param->touch_msgs		= 0;
+	user_param->touch_bytes		= 0;
+	user_param->touch_cycles	= 0;
+	user_param->touch_sum		= 0;
+	user_param->consumer_delay	= CONSUMER_DELAY_NONE;
+	user_param->consumer_delay_usec	= 0;
+	user_param->consumer_delay_max_usec = 0;
+	user_param->consumer_released	= 0;
+	user_param->consumer_hold_cycles = 0;
+	user_param->consumer_rnr_naks	= -1;
+	user_param->sender_stalls	= 0;
+	user_param->sender_stall_cycles	= 0;
+	user_param->use_credits		= 0;
+	user_param->recv_classes	= 0;
+	user_param->recv_pool_footprint	= 0;
+	user_param->seq_track		= 0;
+	user_param->seq_tx		= NULL;
+	user_param->seq_trackers	= NULL;
+	user_param->seq_unstamped	= 0;
+	user_param->rfc2544		= 0;
+	user_param->rfc2544_loss	= 0;
+	user_param->rfc2544_res		= RFC2544_DEF_RESOLUTION;
+	user_param->recv_total		= 0;
+	user_param->object_size		= 0;
+	user_param->object_cycles	= NULL;
+	user_param->object_tail_cycles	= NULL;
 }
 
 static int open_file_write(const char* file_path)
@@ -1224,6 +1924,8 @@ void flow_rules_force_dependecies(struct perftest_parameters *user_param)
  ******************************************************************************/
 static void force_dependecies(struct perftest_parameters *user_param)
 {
+	int i;
+
 	/*Additional configuration and assignments.*/
 	if (user_param->verb == WRITE) {
 		user_param->rx_depth = DEF_RX_RDMA;
@@ -1285,16 +1987,136 @@ static void force_dependecies(struct perftest_parameters *user_param)
 		user_param->cq_mod = user_param->tx_depth;
 	}
 
-	if (user_param->verb == READ || user_param->verb == ATOMIC)
+	if (user_param->verb == READ || user_param->verb == ATOMIC || user_param->verb_mix.num || user_param->sge > 1 ||
+			user_param->reg_mode != REG_MODE_STATIC)
 		user_param->inline_size = 0;
 
-	if (user_param->test_method == RUN_ALL)
-		user_param->size = MAX_SIZE;
+	if (user_param->sge > 1) {
+		if (user_param->tst != BW || (user_param->verb != WRITE && user_param->verb != READ && user_param->verb != SEND) ||
+				(user_param->connection_type != RC && user_param->connection_type != UC) ||
+				user_param->duplex || user_param->use_srq || user_param->post_list > 1 || user_param->recv_post_list > 1) {
+			fprintf(stderr, " --sge is supported only in unidirectional RC and UC WRITE, READ and SEND BW tests, without SRQ or post list\n");
+			exit(1);
+		}
+		if (user_param->size_dist.num || user_param->verb_mix.num || user_param->autotune ||
+				user_param->use_null_mr || user_param->aes_xts || user_param->flows > 1) {
+			fprintf(stderr, " --sge can't be used with --size_dist, --verb_mix, --autotune, --use_null_mr, encryption or flows\n");
+			exit(1);
+		}
+		if (user_param->test_type == DURATION || user_param->test_method == RUN_INFINITELY) {
+			fprintf(stderr, " --sge is currently supported in iteration mode only\n");
+			exit(1);
+		}
+		if (user_param->sge_layout == SGE_MR && user_param->memory_type != MEMORY_HOST) {
+			fprintf(stderr, " --sge_layout=mr is supported only with host memory\n");
+			exit(1);
+		}
+
+		/* --sge_sizes sets the message size, so it can't be swept. */
+		if (user_param->sge_sizes[0]) {
+			if (user_param->test_method != RUN_REGULAR) {
+				fprintf(stderr, " --sge_sizes can't be used with -a or --sizes\n");
+				exit(1);
+			}
+			user_param->size = 0;
+			for (i = 0; i < user_param->sge; i++)
+				user_param->size += user_param->sge_sizes[i];
+		}
 
-	if (user_param->verb == ATOMIC && user_param->size != DEF_SIZE_ATOMIC) {
-		printf(RESULT_LINE);
-		printf("Message size cannot be changed for Atomic tests \n");
-		exit (1);
+		/* A single size runs as a sweep of one, for the single SGE reference pass. */
+		if (user_param->test_method == RUN_REGULAR) {
+			ALLOCATE(user_param->sizes, uint64_t, 1);
+			user_param->sizes[0] = user_param->size;
+			user_param->num_of_sizes = 1;
+			user_param->test_method = RUN_ALL;
+		}
+	}
+
+	if (user_param->test_method == RUN_ALL) {
+		/* -a sweeps the powers of 2 from 2 till 2^23. */
+		if (!user_param->sizes) {
+			ALLOCATE(user_param->sizes, uint64_t, MAX_SIZES_NUM);
+			for (i = 1; (1UL << i) <= MAX_SIZE; i++)
+				user_param->sizes[user_param->num_of_sizes++] = 1UL << i;
+		}
+
+		/* Each SGE carries at least a byte. */
+		if (user_param->sge > 1) {
+			int num_of_sizes = user_param->num_of_sizes;
+
+			user_param->num_of_sizes = 0;
+			for (i = 0; i < num_of_sizes; i++) {
+				if (user_param->sizes[i] >= user_param->sge)
+					user_param->sizes[user_param->num_of_sizes++] = user_param->sizes[i];
+			}
+			if (!user_param->num_of_sizes) {
+				fprintf(stderr, " The message size should be at least the number of SGEs\n");
+				exit(1);
+			}
+		}
+
+		/* The buffers are allocated for the largest size. */
+		user_param->size = 0;
+		for (i = 0; i < user_param->num_of_sizes; i++) {
+			if (user_param->sizes[i] > user_param->size)
+				user_param->size = user_param->sizes[i];
+		}
+
+		if (user_param->size > UINT_MAX / 2) {
+			fprintf(stderr, " Message Size should be between %d and %d\n", 1, UINT_MAX / 2);
+			exit(1);
+		}
+	}
+
+	if (user_param->size_dist.num) {
+		if (user_param->test_method != RUN_REGULAR) {
+			fprintf(stderr, " --size_dist can't be used with -a, --sizes or --run_infinitely\n");
+			exit(1);
+		}
+		if ((user_param->tst != BW && user_param->tst != LAT) ||
+				(user_param->verb != WRITE && user_param->verb != READ && user_param->verb != SEND) ||
+				user_param->connection_type == RawEth || user_param->aes_xts ||
+				user_param->conn_rate || user_param->reg_mr_rate) {
+			fprintf(stderr, " --size_dist is supported only in WRITE, READ and SEND BW and latency tests\n");
+			exit(1);
+		}
+		if (user_param->tst == BW && (user_param->post_list > 1 || user_param->duplex)) {
+			fprintf(stderr, " --size_dist is supported only in unidirectional BW tests without post list\n");
+			exit(1);
+		}
+		if (user_param->tst == LAT && user_param->test_type != ITERATIONS) {
+			fprintf(stderr, " --size_dist latency tests support iteration mode only\n");
+			exit(1);
+		}
+
+		/* The buffers are allocated for the largest class. */
+		user_param->size = 0;
+		for (i = 0; i < user_param->size_dist.num; i++) {
+			if (user_param->size_dist.sizes[i] > user_param->size)
+				user_param->size = user_param->size_dist.sizes[i];
+		}
+
+		if (user_param->size > UINT_MAX / 2) {
+			fprintf(stderr, " Message Size should be between %d and %d\n", 1, UINT_MAX / 2);
+			exit(1);
+		}
+
+		/* Both sides of a latency test draw the same sequence, so each side
+		 * knows the size of the message it waits for.
+		 */
+		if (user_param->tst == LAT) {
+			uint64_t iter;
+
+			ALLOCATE(user_param->size_dist.classes, uint8_t, user_param->iters);
+			for (iter = 0; iter < user_param->iters; iter++)
+				user_param->size_dist.classes[iter] = size_dist_draw(&user_param->size_dist);
+		}
+	}
+
+	if (user_param->verb == ATOMIC && user_param->size != DEF_SIZE_ATOMIC) {
+		printf(RESULT_LINE);
+		printf("Message size cannot be changed for Atomic tests \n");
+		exit (1);
 	}
 
 	if (user_param->use_srq && user_param->verb != SEND) {
@@ -1856,6 +2678,404 @@ static void force_dependecies(struct perftest_parameters *user_param)
 		user_param->rate_limit = user_param->rate_limit * 8 * 1024;
 	}
 
+	if (user_param->autotune) {
+		if (user_param->tst != BW || (user_param->verb != WRITE && user_param->verb != READ) ||
+				user_param->duplex || user_param->test_method != RUN_REGULAR) {
+			fprintf(stderr, " Autotune is supported only in unidirectional WRITE and READ BW tests of a single size\n");
+			exit(1);
+		}
+		if (user_param->rate_limit_type != DISABLE_RATE_LIMIT || user_param->use_event) {
+			fprintf(stderr, " Autotune can't be used with a rate limit or with events\n");
+			exit(1);
+		}
+	}
+
+	if (user_param->verb_mix.num) {
+		if (user_param->tst != BW || (user_param->verb != WRITE && user_param->verb != READ) ||
+				user_param->connection_type != RC || user_param->duplex || user_param->post_list > 1 ||
+				user_param->test_method != RUN_REGULAR) {
+			fprintf(stderr, " --verb_mix is supported only in unidirectional RC WRITE and READ BW tests of a single size, without post list\n");
+			exit(1);
+		}
+		if (user_param->size_dist.num || user_param->autotune || user_param->use_null_mr || user_param->aes_xts) {
+			fprintf(stderr, " --verb_mix can't be used with --size_dist, --autotune, --use_null_mr or encryption\n");
+			exit(1);
+		}
+	}
+
+	if (user_param->remote_pattern) {
+		if (user_param->tst != BW || user_param->verb == SEND || user_param->duplex ||
+				user_param->post_list > 1 || user_param->autotune || user_param->connection_type == RawEth) {
+			fprintf(stderr, " --remote_pattern is supported only in unidirectional WRITE, READ and atomic BW tests without post list\n");
+			exit(1);
+		}
+	} else if (user_param->remote_region) {
+		fprintf(stderr, " --remote_region is valid only with --remote_pattern\n");
+		exit(1);
+	}
+
+	if (user_param->remote_region && user_param->remote_region < user_param->size) {
+		fprintf(stderr, " The remote region should hold at least a message of %" PRIu64 " bytes\n", user_param->size);
+		exit(1);
+	}
+
+	if (user_param->page_policy != PAGE_POLICY_DEFAULT) {
+		if (user_param->memory_type != MEMORY_HOST) {
+			fprintf(stderr, " --page_policy is valid only with host memory\n");
+			exit(1);
+		}
+		if (user_param->page_policy == PAGE_POLICY_HUGETLBFS && !user_param->hugetlbfs_dir)
+			user_param->hugetlbfs_dir = strdup(DEF_HUGETLBFS_DIR);
+	}
+
+	if (user_param->working_set) {
+		if ((user_param->tst != BW && user_param->tst != LAT_BY_BW) || user_param->mac_fwd) {
+			fprintf(stderr, " --working_set is supported only in BW tests without MAC forwarding\n");
+			exit(1);
+		}
+		if (user_param->working_set < (uint64_t)user_param->size * 2 * user_param->num_of_qps) {
+			fprintf(stderr, " The working set should hold a message of each QP on both halves of the buffer\n");
+			exit(1);
+		}
+	}
+
+	if ((user_param->verb == WRITE || user_param->verb == WRITE_IMM) && user_param->tst == LAT &&
+	    !user_param->reg_mr_rate && !user_param->conn_rate) {
+		/* The latency test polls the last byte of the buffer for the incoming data. */
+		if (user_param->buf_init != BUF_INIT_AUTO && user_param->buf_init != BUF_INIT_ZERO) {
+			fprintf(stderr, " --buf_init=%s is not supported in WRITE latency tests, the buffer must start zeroed\n",
+				bufInitStr[user_param->buf_init]);
+			exit(1);
+		}
+		user_param->buf_init = BUF_INIT_ZERO;
+	} else if (user_param->buf_init == BUF_INIT_AUTO) {
+		user_param->buf_init = user_param->has_payload_modification ? BUF_INIT_PATTERN : BUF_INIT_RANDOM;
+	}
+
+	if (user_param->buf_init == BUF_INIT_PATTERN && !user_param->has_payload_modification) {
+		fprintf(stderr, " --buf_init=pattern requires --payload_file_path\n");
+		exit(1);
+	}
+
+	if (user_param->verify) {
+		if (user_param->tst != BW || user_param->connection_type != RC ||
+				(user_param->verb != SEND && user_param->verb != WRITE &&
+				 user_param->verb != WRITE_IMM && user_param->verb != READ)) {
+			fprintf(stderr, " --verify is supported only in RC SEND, WRITE, WRITE_IMM and READ BW tests\n");
+			exit(1);
+		}
+		if (user_param->duplex || user_param->test_method != RUN_REGULAR || user_param->test_type != ITERATIONS) {
+			fprintf(stderr, " --verify needs a unidirectional run of a single size in iterations mode\n");
+			exit(1);
+		}
+		if (user_param->use_srq || user_param->post_list > 1 || user_param->recv_post_list > 1 ||
+				user_param->flows > 1 || user_param->sge > 1 || user_param->remote_pattern ||
+				user_param->working_set || user_param->size_dist.num || user_param->verb_mix.num ||
+				user_param->autotune || user_param->use_null_mr || user_param->aes_xts ||
+				user_param->use_unsolicited_write) {
+			fprintf(stderr, " --verify can't be used with SRQ, post lists, flows, --sge, --remote_pattern, --working_set,\n");
+			fprintf(stderr, " --size_dist, --verb_mix, --autotune, --use_null_mr, encryption or unsolicited writes\n");
+			exit(1);
+		}
+		if (user_param->memory_type != MEMORY_HOST) {
+			fprintf(stderr, " --verify is valid only with host memory\n");
+			exit(1);
+		}
+		if (user_param->size < VERIFY_HDR_SIZE) {
+			fprintf(stderr, " --verify needs messages of at least %d bytes\n", VERIFY_HDR_SIZE);
+			exit(1);
+		}
+	}
+
+	if (user_param->copy_mode != COPY_MODE_NONE) {
+		if (user_param->tst != BW || user_param->connection_type == RawEth ||
+				(user_param->verb != SEND && user_param->verb != WRITE &&
+				 user_param->verb != WRITE_IMM && user_param->verb != READ)) {
+			fprintf(stderr, " --copy_mode is supported only in SEND, WRITE, WRITE_IMM and READ BW tests\n");
+			exit(1);
+		}
+		if (user_param->duplex || user_param->test_method == RUN_INFINITELY) {
+			fprintf(stderr, " --copy_mode is supported only in unidirectional tests, without --run_infinitely\n");
+			exit(1);
+		}
+		if (user_param->use_srq || user_param->post_list > 1 || user_param->recv_post_list > 1 ||
+				user_param->flows > 1 || user_param->sge > 1 || user_param->size_dist.num ||
+				user_param->verb_mix.num || user_param->autotune || user_param->use_null_mr ||
+				user_param->verify) {
+			fprintf(stderr, " --copy_mode can't be used with SRQ, post lists, flows, --sge, --size_dist, --verb_mix,\n");
+			fprintf(stderr, " --autotune, --use_null_mr or --verify\n");
+			exit(1);
+		}
+		if (user_param->copy_mode != COPY_MODE_MEMCPY && user_param->memory_type != MEMORY_HOST) {
+			fprintf(stderr, " --copy_mode=%s is valid only with host memory, use memcpy for the copy of the memory type\n",
+				copyModeStr[user_param->copy_mode]);
+			exit(1);
+		}
+	}
+
+	if (user_param->reg_mode != REG_MODE_STATIC) {
+		if (user_param->tst != BW || user_param->connection_type == RawEth ||
+				(user_param->verb != SEND && user_param->verb != WRITE &&
+				 user_param->verb != WRITE_IMM && user_param->verb != READ)) {
+			fprintf(stderr, " --reg_mode is supported only in SEND, WRITE, WRITE_IMM and READ BW tests\n");
+			exit(1);
+		}
+		if (user_param->duplex || user_param->test_method == RUN_INFINITELY) {
+			fprintf(stderr, " --reg_mode is supported only in unidirectional tests, without --run_infinitely\n");
+			exit(1);
+		}
+		if (user_param->post_list > 1 || user_param->flows > 1 || user_param->sge > 1 ||
+				user_param->size_dist.num || user_param->verb_mix.num || user_param->autotune ||
+				user_param->use_null_mr || user_param->verify || user_param->copy_mode != COPY_MODE_NONE ||
+				user_param->use_odp || user_param->aes_xts) {
+			fprintf(stderr, " --reg_mode can't be used with post lists, flows, --sge, --size_dist, --verb_mix, --autotune,\n");
+			fprintf(stderr, " --use_null_mr, --verify, --copy_mode, ODP or encryption\n");
+			exit(1);
+		}
+		if (user_param->memory_type != MEMORY_HOST) {
+			fprintf(stderr, " --reg_mode is valid only with host memory\n");
+			exit(1);
+		}
+		if (user_param->reg_mode == REG_MODE_CACHED && user_param->reg_cache_size < user_param->reg_pool &&
+				user_param->reg_cache_size < user_param->tx_depth * user_param->num_of_qps)
+			printf(" WARNING: the registration cache is smaller than the messages in flight, those in use are not evicted.\n");
+	}
+
+	if (user_param->touch != TOUCH_NONE) {
+		if (user_param->connection_type == RawEth ||
+				!((user_param->tst == BW && (user_param->verb == SEND || user_param->verb == WRITE ||
+							     user_param->verb == WRITE_IMM)) ||
+				  (user_param->tst == LAT && user_param->verb == SEND))) {
+			fprintf(stderr, " --touch is supported only in SEND, WRITE and WRITE_IMM BW tests and the SEND latency test\n");
+			exit(1);
+		}
+		if ((user_param->touch & TOUCH_RX_READ) && user_param->verb == WRITE) {
+			fprintf(stderr, " --touch=%s needs receive completions, RDMA WRITE has none\n", touchStr[user_param->touch]);
+			exit(1);
+		}
+		if (user_param->duplex || user_param->test_method == RUN_INFINITELY ||
+				(user_param->tst == LAT && user_param->test_type == DURATION)) {
+			fprintf(stderr, " --touch is supported only in unidirectional BW tests, without --run_infinitely,\n");
+			fprintf(stderr, " and in latency tests in iterations mode\n");
+			exit(1);
+		}
+		if (user_param->use_srq || user_param->post_list > 1 || user_param->recv_post_list > 1 ||
+				user_param->flows > 1 || user_param->sge > 1 || user_param->size_dist.num ||
+				user_param->verb_mix.num || user_param->verify) {
+			fprintf(stderr, " --touch can't be used with SRQ, post lists, flows, --sge, --size_dist, --verb_mix or --verify\n");
+			exit(1);
+		}
+		if (user_param->memory_type != MEMORY_HOST) {
+			fprintf(stderr, " --touch is valid only with host memory\n");
+			exit(1);
+		}
+	}
+
+	if (user_param->consumer_delay != CONSUMER_DELAY_NONE || user_param->use_credits) {
+		if (user_param->tst != BW || user_param->connection_type == RawEth ||
+				(user_param->verb != SEND && user_param->verb != WRITE_IMM) ||
+				(user_param->use_credits && user_param->verb != SEND)) {
+			fprintf(stderr, " --consumer_delay is supported only in SEND and WRITE_IMM BW tests, --credits in SEND BW tests\n");
+			exit(1);
+		}
+		if (user_param->duplex || user_param->test_method == RUN_INFINITELY) {
+			fprintf(stderr, " --consumer_delay and --credits are supported only in unidirectional tests, without --run_infinitely\n");
+			exit(1);
+		}
+		if (user_param->consumer_delay != CONSUMER_DELAY_NONE &&
+				(user_param->use_srq || user_param->recv_post_list > 1 || user_param->flows > 1 ||
+				 user_param->use_event || user_param->use_unsolicited_write)) {
+			fprintf(stderr, " --consumer_delay can't be used with SRQ, receive post lists, flows, events or unsolicited writes\n");
+			exit(1);
+		}
+	}
+
+	if (user_param->recv_classes) {
+		struct size_dist *dist = &user_param->size_dist;
+		double share[MAX_RECV_CLASSES] = {0};
+		int c;
+
+		if (user_param->tst != BW || user_param->verb != SEND || user_param->connection_type != RC ||
+				!dist->num) {
+			fprintf(stderr, " --recv_classes is supported only in SEND BW tests over RC, with --size_dist\n");
+			exit(1);
+		}
+		if (user_param->duplex || user_param->test_type != DURATION) {
+			fprintf(stderr, " --recv_classes is supported only in unidirectional duration (-D) tests\n");
+			exit(1);
+		}
+		if (user_param->use_srq || user_param->use_xrc || user_param->recv_post_list > 1 || user_param->flows > 1 ||
+				user_param->consumer_delay != CONSUMER_DELAY_NONE || user_param->use_credits ||
+				user_param->use_unsolicited_write) {
+			fprintf(stderr, " --recv_classes can't be used with SRQ, XRC, receive post lists, flows, --consumer_delay,\n");
+			fprintf(stderr, " --credits or unsolicited writes\n");
+			exit(1);
+		}
+		if (user_param->num_of_qps < user_param->recv_classes) {
+			fprintf(stderr, " --recv_classes needs a QP per class at least, use -q %d\n", user_param->recv_classes);
+			exit(1);
+		}
+
+		/* Each size goes to the smallest class that fits it, the classes get
+		 * receive WQEs out of --rx-depth by their share of the messages.
+		 */
+		for (i = 0; i < dist->num; i++) {
+			for (c = 0; c < user_param->recv_classes && dist->sizes[i] > user_param->recv_class_size[c]; c++);
+			if (c == user_param->recv_classes) {
+				fprintf(stderr, " The %lu bytes --size_dist size is larger than the receive classes\n",
+						(unsigned long)dist->sizes[i]);
+				exit(1);
+			}
+			dist->recv_class[i] = c;
+			share[c] += dist->weights[i];
+		}
+		for (c = 0; c < user_param->recv_classes; c++) {
+			user_param->recv_class_depth[c] = (int)ceil(user_param->rx_depth * share[c]);
+			if (user_param->recv_class_depth[c] < RECV_CLASS_MIN_DEPTH)
+				user_param->recv_class_depth[c] = RECV_CLASS_MIN_DEPTH;
+			user_param->recv_class_msgs[c] = 0;
+			user_param->recv_class_bytes[c] = 0;
+		}
+	}
+
+	if (user_param->seq_track) {
+		int flows = user_param->num_of_qps * user_param->flows;
+
+		if (user_param->tst != BW || user_param->verb != SEND ||
+				(user_param->connection_type != UD && user_param->connection_type != UC &&
+				 user_param->connection_type != RC && user_param->connection_type != RawEth) ||
+				user_param->use_xrc) {
+			fprintf(stderr, " --seq_track is supported only in SEND BW tests over UD, UC, RC and raw Ethernet\n");
+			exit(1);
+		}
+		if (user_param->duplex || user_param->test_method != RUN_REGULAR) {
+			fprintf(stderr, " --seq_track is supported only in unidirectional tests of a single size\n");
+			exit(1);
+		}
+		if (user_param->use_srq || user_param->post_list > 1 || user_param->recv_post_list > 1 ||
+				user_param->sge > 1 || user_param->size_dist.num || user_param->verify ||
+				user_param->copy_mode != COPY_MODE_NONE || user_param->touch != TOUCH_NONE ||
+				user_param->recv_classes || user_param->use_null_mr) {
+			fprintf(stderr, " --seq_track can't be used with SRQ, post lists, --sge, --size_dist, --verify, --copy_mode,\n");
+			fprintf(stderr, " --touch, --recv_classes or --use_null_mr\n");
+			exit(1);
+		}
+		if (user_param->memory_type != MEMORY_HOST) {
+			fprintf(stderr, " --seq_track is valid only with host memory\n");
+			exit(1);
+		}
+		/* The stamp follows the headers of a raw Ethernet frame, at its end. */
+		if (user_param->size < (user_param->connection_type == RawEth ? SEQ_TRACK_RAWETH_MIN_SIZE : SEQ_STAMP_SIZE)) {
+			fprintf(stderr, " --seq_track needs messages of %d bytes at least\n",
+				user_param->connection_type == RawEth ? SEQ_TRACK_RAWETH_MIN_SIZE : SEQ_STAMP_SIZE);
+			exit(1);
+		}
+
+		ALLOCATE(user_param->seq_tx, uint64_t, flows);
+		memset(user_param->seq_tx, 0, flows * sizeof(uint64_t));
+		ALLOCATE(user_param->seq_trackers, struct seq_tracker, flows);
+		memset(user_param->seq_trackers, 0, flows * sizeof(struct seq_tracker));
+	}
+
+	if (user_param->rfc2544) {
+		if (user_param->tst != BW || user_param->verb != SEND ||
+				(user_param->connection_type != UD && user_param->connection_type != RawEth)) {
+			fprintf(stderr, " --rfc2544 is supported only in SEND BW tests over UD and raw Ethernet\n");
+			exit(1);
+		}
+		if (user_param->duplex || user_param->test_method != RUN_REGULAR || user_param->test_type != DURATION) {
+			fprintf(stderr, " --rfc2544 is supported only in unidirectional tests of a single size, -D sets the trial duration\n");
+			exit(1);
+		}
+		if (user_param->mac_fwd || user_param->connectionless || user_param->seq_track) {
+			fprintf(stderr, " --rfc2544 can't be used with --mac_fwd, --connectionless or --seq_track\n");
+			exit(1);
+		}
+		if (user_param->rate_limit_type == HW_RATE_LIMIT || user_param->rate_limit_type == PP_RATE_LIMIT) {
+			fprintf(stderr, " --rfc2544 drives the SW rate limiter, a --rate_limit of it caps the search\n");
+			exit(1);
+		}
+		/* Raw Ethernet has no control connection of its own, the receive counts need one. */
+		if (user_param->connection_type == RawEth && user_param->machine == CLIENT && !user_param->servername) {
+			fprintf(stderr, " --rfc2544 over raw Ethernet needs the server host name for the control connection\n");
+			exit(1);
+		}
+	}
+
+	if (user_param->object_size) {
+		if (user_param->tst != BW || (user_param->verb != WRITE && user_param->verb != READ) ||
+				user_param->duplex || user_param->test_type != ITERATIONS ||
+				user_param->test_method == RUN_INFINITELY || user_param->time_per_size) {
+			fprintf(stderr, " --object_size is supported only in unidirectional WRITE and READ BW tests with -n objects\n");
+			exit(1);
+		}
+		if (user_param->post_list > 1 || user_param->sge > 1 || user_param->flows > 1 || user_param->use_event ||
+				user_param->rate_limit_type != DISABLE_RATE_LIMIT || user_param->autotune ||
+				user_param->size_dist.num || user_param->verb_mix.num || user_param->remote_pattern) {
+			fprintf(stderr, " --object_size can't be used with post list, --sge, flows, events, a rate limit, --autotune,\n");
+			fprintf(stderr, " --size_dist, --verb_mix or --remote_pattern\n");
+			exit(1);
+		}
+		if (user_param->verify || user_param->copy_mode != COPY_MODE_NONE || user_param->touch != TOUCH_NONE ||
+				user_param->reg_mode != REG_MODE_STATIC || user_param->aes_xts) {
+			fprintf(stderr, " --object_size can't be used with --verify, --copy_mode, --touch, --reg_mode or encryption\n");
+			exit(1);
+		}
+		/* The objects are timed as a whole, not per chunk. */
+		if (user_param->noPeak == OFF)
+			printf(" WARNING: BW peak won't be measured in this run.\n");
+		user_param->noPeak = ON;
+	}
+
+	if (user_param->map_populate) {
+		#if defined(__FreeBSD__)
+		fprintf(stderr, " --map_populate is not supported on this platform\n");
+		exit(1);
+		#endif
+		if (user_param->memory_type != MEMORY_HOST) {
+			fprintf(stderr, " --map_populate is valid only with host memory\n");
+			exit(1);
+		}
+		if (user_param->page_policy == PAGE_POLICY_SHM || user_param->page_policy == PAGE_POLICY_THP ||
+		    user_param->page_policy == PAGE_POLICY_4K) {
+			fprintf(stderr, " --map_populate is not supported with --page_policy=%s\n",
+				page_policy_str(user_param->page_policy));
+			exit(1);
+		}
+	}
+
+	if (user_param->cm_inflight && !user_param->work_rdma_cm) {
+		fprintf(stderr, " --cm_inflight is valid only with RDMA CM (-R)\n");
+		exit(1);
+	}
+
+	if (user_param->reg_mr_rate) {
+		if (user_param->test_type == DURATION) {
+			fprintf(stderr, "Memory registration rate test is currently support iteration mode only.\n");
+			exit(1);
+		}
+		if (user_param->memory_type != MEMORY_HOST && user_param->memory_type != MEMORY_MMAP) {
+			fprintf(stderr, "Memory registration rate test supports only host and mmap memory\n");
+			exit(1);
+		}
+	}
+
+	if (user_param->conn_rate) {
+		if (user_param->test_type == DURATION) {
+			fprintf(stderr, "Connection rate test is currently support iteration mode only.\n");
+			exit(1);
+		}
+		if (user_param->use_xrc || user_param->connection_type == DC ||
+			user_param->connection_type == SRD || user_param->connection_type == RawEth) {
+			fprintf(stderr, "Connection rate test supports only RC, UC and UD connections\n");
+			exit(1);
+		}
+		if (user_param->work_rdma_cm && user_param->connection_type != RC) {
+			fprintf(stderr, "Connection rate test over RDMA CM supports only RC connection\n");
+			exit(1);
+		}
+	}
+
 	if (user_param->tst == LAT_BY_BW) {
 		if ( user_param->test_type == DURATION) {
 			fprintf(stderr, "Latency under load test is currently support iteration mode only.\n");
@@ -2026,6 +3246,11 @@ const char *transport_str(enum ibv_transport_type type)
 /******************************************************************************
  * Try to map verbs' link layer types to a descriptive string or "Unknown"
  ******************************************************************************/
+const char *page_policy_str(int page_policy)
+{
+	return pagePolicyStr[page_policy];
+}
+
 const char *link_layer_str(int8_t link_layer)
 {
 	switch (link_layer) {
@@ -2458,6 +3683,7 @@ int parser(struct perftest_parameters *user_param,char *argv[], int argc)
 {
 	int c,size_len;
 	int size_factor = 1;
+	int i, sge_sizes_num = 0;
 	static int run_inf_flag = 0;
 	static int report_fmt_flag = 0;
 	static int srq_flag = 0;
@@ -2559,6 +3785,39 @@ int parser(struct perftest_parameters *user_param,char *argv[], int argc)
 	#endif
 	static int connectionless_flag = 0;
 	static int cqe_poll_flag = 0;
+	static int perf_events_flag = 0;
+	static int qp_threads_flag = 0;
+	static int reg_sizes_flag = 0;
+	static int cm_inflight_flag = 0;
+	static int report_setup_flag = 0;
+	static int sizes_flag = 0;
+	static int time_per_size_flag = 0;
+	static int autotune_flag = 0;
+	static int size_dist_flag = 0;
+	static int verb_mix_flag = 0;
+	static int sge_flag = 0;
+	static int sge_sizes_flag = 0;
+	static int sge_layout_flag = 0;
+	static int remote_pattern_flag = 0;
+	static int remote_region_flag = 0;
+	static int page_policy_flag = 0;
+	static int working_set_flag = 0;
+	static int buf_init_flag = 0;
+	static int map_populate_flag = 0;
+	static int verify_flag = 0;
+	static int copy_mode_flag = 0;
+	static int reg_mode_flag = 0;
+	static int reg_cache_size_flag = 0;
+	static int reg_pool_flag = 0;
+	static int touch_flag = 0;
+	static int touch_fraction_flag = 0;
+	static int touch_stride_flag = 0;
+	static int consumer_delay_flag = 0;
+	static int credits_flag = 0;
+	static int recv_classes_flag = 0;
+	static int seq_track_flag = 0;
+	static int rfc2544_flag = 0;
+	static int object_size_flag = 0;
 
 	char *server_ip = NULL;
 	char *client_ip = NULL;
@@ -2737,6 +3996,39 @@ int parser(struct perftest_parameters *user_param,char *argv[], int argc)
 			#endif
 			{.name = "connectionless", .has_arg = 0, .flag = &connectionless_flag, .val = 1 },
 			{.name = "cqe_poll", .has_arg = 1, .flag = &cqe_poll_flag, .val = 1 },
+			{.name = "perf_events", .has_arg = 1, .flag = &perf_events_flag, .val = 1 },
+			{.name = "qp_threads", .has_arg = 1, .flag = &qp_threads_flag, .val = 1 },
+			{.name = "reg_sizes", .has_arg = 1, .flag = &reg_sizes_flag, .val = 1 },
+			{.name = "cm_inflight", .has_arg = 1, .flag = &cm_inflight_flag, .val = 1 },
+			{.name = "report_setup", .has_arg = 0, .flag = &report_setup_flag, .val = 1 },
+			{.name = "sizes", .has_arg = 1, .flag = &sizes_flag, .val = 1 },
+			{.name = "time_per_size", .has_arg = 1, .flag = &time_per_size_flag, .val = 1 },
+			{.name = "autotune", .has_arg = 0, .flag = &autotune_flag, .val = 1 },
+			{.name = "size_dist", .has_arg = 1, .flag = &size_dist_flag, .val = 1 },
+			{.name = "verb_mix", .has_arg = 1, .flag = &verb_mix_flag, .val = 1 },
+			{.name = "sge", .has_arg = 1, .flag = &sge_flag, .val = 1 },
+			{.name = "sge_sizes", .has_arg = 1, .flag = &sge_sizes_flag, .val = 1 },
+			{.name = "sge_layout", .has_arg = 1, .flag = &sge_layout_flag, .val = 1 },
+			{.name = "remote_pattern", .has_arg = 1, .flag = &remote_pattern_flag, .val = 1 },
+			{.name = "remote_region", .has_arg = 1, .flag = &remote_region_flag, .val = 1 },
+			{.name = "page_policy", .has_arg = 1, .flag = &page_policy_flag, .val = 1 },
+			{.name = "working_set", .has_arg = 1, .flag = &working_set_flag, .val = 1 },
+			{.name = "buf_init", .has_arg = 1, .flag = &buf_init_flag, .val = 1 },
+			{.name = "map_populate", .has_arg = 0, .flag = &map_populate_flag, .val = 1 },
+			{.name = "verify", .has_arg = 0, .flag = &verify_flag, .val = 1 },
+			{.name = "copy_mode", .has_arg = 1, .flag = &copy_mode_flag, .val = 1 },
+			{.name = "reg_mode", .has_arg = 1, .flag = &reg_mode_flag, .val = 1 },
+			{.name = "reg_cache_size", .has_arg = 1, .flag = &reg_cache_size_flag, .val = 1 },
+			{.name = "reg_pool", .has_arg = 1, .flag = &reg_pool_flag, .val = 1 },
+			{.name = "touch", .has_arg = 1, .flag = &touch_flag, .val = 1 },
+			{.name = "touch_fraction", .has_arg = 1, .flag = &touch_fraction_flag, .val = 1 },
+			{.name = "touch_stride", .has_arg = 1, .flag = &touch_stride_flag, .val = 1 },
+			{.name = "consumer_delay", .has_arg = 1, .flag = &consumer_delay_flag, .val = 1 },
+			{.name = "credits", .has_arg = 0, .flag = &credits_flag, .val = 1 },
+			{.name = "recv_classes", .has_arg = 1, .flag = &recv_classes_flag, .val = 1 },
+			{.name = "seq_track", .has_arg = 0, .flag = &seq_track_flag, .val = 1 },
+			{.name = "rfc2544", .has_arg = 1, .flag = &rfc2544_flag, .val = 1 },
+			{.name = "object_size", .has_arg = 1, .flag = &object_size_flag, .val = 1 },
 			{0}
 		};
 		if (!duplicates_checker) {
@@ -3497,48 +4789,257 @@ int parser(struct perftest_parameters *user_param,char *argv[], int argc)
 					user_param->use_cqe_poll = ON;
 					cqe_poll_flag = 0;
 				}
-				break;
-			default:
-				  fprintf(stderr," Invalid Command or flag.\n");
-				  fprintf(stderr," Please check command line and run again.\n\n");
-				  usage(argv[0], user_param->verb, user_param->tst, user_param->connection_type);
-				  if(user_param->connection_type == RawEth) {
-					  usage_raw_ethernet(user_param->tst);
-				  }
-				  free(duplicates_checker);
-				  return FAILURE;
-		}
-
-	}
-	free(duplicates_checker);
-
-#ifdef HAVE_DCS
-	if (!log_active_dci_streams_flag_was_ever_set) {
-		user_param->log_active_dci_streams = user_param->log_dci_streams;
-	}
-#endif
-	if (tcp_flag) {
-		user_param->tcp = 1;
-	}
-	if (run_inf_flag) {
-		user_param->test_method = RUN_INFINITELY;
-	}
-
-	if (srq_flag) {
-		user_param->use_srq = 1;
-	}
-
-	#ifdef HAVE_TD_API
-	if (no_lock_flag) {
-		user_param->no_lock = 1;
-	}
-	#endif
-
-	#ifdef HAVE_OOO_RECV_WRS
-	if (no_ddp_flag) {
-		user_param->no_ddp = 1;
-	}
-	#endif
+				if (perf_events_flag) {
+					if (perf_events_alloc(optarg, &user_param->perf_events_ctx)) {
+						fprintf(stderr, "Failed to parse the perf events list\n");
+						free(duplicates_checker);
+						return FAILURE;
+					}
+					perf_events_flag = 0;
+				}
+				if (qp_threads_flag) {
+					CHECK_VALUE_IN_RANGE(user_param->qp_threads,int,1,MAX_QP_THREADS,"QP threads",not_int_ptr);
+					user_param->report_qp_rate = ON;
+					qp_threads_flag = 0;
+				}
+				if (reg_sizes_flag) {
+					char *max_str = strchr(optarg, ':');
+
+					if (parse_size_from_str(optarg, &user_param->reg_min_size) ||
+						(max_str && parse_size_from_str(max_str + 1, &user_param->reg_max_size))) {
+						fprintf(stderr, " Invalid registration sizes %s\n", optarg);
+						free(duplicates_checker);
+						return FAILURE;
+					}
+					if (!max_str)
+						user_param->reg_max_size = user_param->reg_min_size;
+					if (user_param->reg_min_size > user_param->reg_max_size) {
+						fprintf(stderr, " Minimal registration size is larger than the maximal\n");
+						free(duplicates_checker);
+						return FAILURE;
+					}
+					reg_sizes_flag = 0;
+				}
+				if (cm_inflight_flag) {
+					CHECK_VALUE_IN_RANGE(user_param->cm_inflight,int,1,MAX_QP_NUM,"RDMA CM connects in flight",not_int_ptr);
+					user_param->report_cm_setup = ON;
+					cm_inflight_flag = 0;
+				}
+				if (sizes_flag) {
+					if (parse_sizes_from_str(user_param, optarg)) {
+						fprintf(stderr, " Invalid sizes list %s\n", optarg);
+						free(duplicates_checker);
+						return FAILURE;
+					}
+					user_param->test_method = RUN_ALL;
+					sizes_flag = 0;
+				}
+				if (time_per_size_flag) {
+					CHECK_VALUE_IN_RANGE(user_param->time_per_size,int,1,3600000,"Time per size",not_int_ptr);
+					user_param->test_method = RUN_ALL;
+					time_per_size_flag = 0;
+				}
+				if (size_dist_flag) {
+					if (parse_size_dist_from_str(user_param, optarg)) {
+						fprintf(stderr, " Invalid size distribution %s\n", optarg);
+						free(duplicates_checker);
+						return FAILURE;
+					}
+					size_dist_flag = 0;
+				}
+				if (verb_mix_flag) {
+					if (parse_verb_mix_from_str(user_param, optarg)) {
+						fprintf(stderr, " Invalid verb mix %s\n", optarg);
+						free(duplicates_checker);
+						return FAILURE;
+					}
+					verb_mix_flag = 0;
+				}
+				if (sge_flag) {
+					CHECK_VALUE_IN_RANGE(user_param->sge,int,1,MAX_SGE_NUM,"Number of SGEs",not_int_ptr);
+					sge_flag = 0;
+				}
+				if (sge_sizes_flag) {
+					sge_sizes_num = parse_sge_sizes_from_str(user_param, optarg);
+					if (!sge_sizes_num) {
+						fprintf(stderr, " Invalid SGE sizes %s\n", optarg);
+						free(duplicates_checker);
+						return FAILURE;
+					}
+					sge_sizes_flag = 0;
+				}
+				if (sge_layout_flag) {
+					for (i = 0; i <= SGE_MR; i++) {
+						if (strcmp(sgeLayoutStr[i], optarg) == 0)
+							break;
+					}
+					if (i > SGE_MR) {
+						fprintf(stderr, " Invalid SGE layout %s, use contiguous, scatter or mr\n", optarg);
+						free(duplicates_checker);
+						return FAILURE;
+					}
+					user_param->sge_layout = i;
+					sge_layout_flag = 0;
+				}
+				if (remote_pattern_flag) {
+					if (parse_remote_pattern_from_str(user_param, optarg)) {
+						fprintf(stderr, " Invalid remote pattern %s\n", optarg);
+						free(duplicates_checker);
+						return FAILURE;
+					}
+					remote_pattern_flag = 0;
+				}
+				if (remote_region_flag) {
+					if (parse_size_from_str(optarg, &user_param->remote_region) || strchr(optarg, ',') || strchr(optarg, ':')) {
+						fprintf(stderr, " Invalid remote region %s\n", optarg);
+						free(duplicates_checker);
+						return FAILURE;
+					}
+					remote_region_flag = 0;
+				}
+				if (page_policy_flag) {
+					if (parse_page_policy_from_str(user_param, optarg)) {
+						fprintf(stderr, " Invalid page policy %s\n", optarg);
+						free(duplicates_checker);
+						return FAILURE;
+					}
+					page_policy_flag = 0;
+				}
+				if (working_set_flag) {
+					if (parse_size_from_str(optarg, &user_param->working_set) || strchr(optarg, ',') || strchr(optarg, ':')) {
+						fprintf(stderr, " Invalid working set %s\n", optarg);
+						free(duplicates_checker);
+						return FAILURE;
+					}
+					working_set_flag = 0;
+				}
+				if (buf_init_flag) {
+					if (parse_buf_init_from_str(user_param, optarg)) {
+						fprintf(stderr, " Invalid buffer init %s\n", optarg);
+						free(duplicates_checker);
+						return FAILURE;
+					}
+					buf_init_flag = 0;
+				}
+				if (copy_mode_flag) {
+					if (parse_copy_mode_from_str(user_param, optarg)) {
+						fprintf(stderr, " Invalid copy mode %s\n", optarg);
+						free(duplicates_checker);
+						return FAILURE;
+					}
+					copy_mode_flag = 0;
+				}
+				if (reg_mode_flag) {
+					if (parse_reg_mode_from_str(user_param, optarg)) {
+						fprintf(stderr, " Invalid registration mode %s\n", optarg);
+						free(duplicates_checker);
+						return FAILURE;
+					}
+					reg_mode_flag = 0;
+				}
+				if (reg_cache_size_flag) {
+					CHECK_VALUE_IN_RANGE(user_param->reg_cache_size,int,1,MAX_REG_CACHE_SIZE,"Registration cache size",not_int_ptr);
+					reg_cache_size_flag = 0;
+				}
+				if (reg_pool_flag) {
+					if (parse_reg_pool_from_str(user_param, optarg)) {
+						fprintf(stderr, " Invalid registration pool %s\n", optarg);
+						free(duplicates_checker);
+						return FAILURE;
+					}
+					reg_pool_flag = 0;
+				}
+				if (touch_flag) {
+					if (parse_touch_from_str(user_param, optarg)) {
+						fprintf(stderr, " Invalid touch %s\n", optarg);
+						free(duplicates_checker);
+						return FAILURE;
+					}
+					touch_flag = 0;
+				}
+				if (touch_fraction_flag) {
+					CHECK_VALUE_IN_RANGE(user_param->touch_fraction,int,1,100,"Touch fraction",not_int_ptr);
+					touch_fraction_flag = 0;
+				}
+				if (touch_stride_flag) {
+					CHECK_VALUE_IN_RANGE(user_param->touch_stride,int,8,MAX_TOUCH_STRIDE,"Touch stride",not_int_ptr);
+					touch_stride_flag = 0;
+				}
+				if (consumer_delay_flag) {
+					if (parse_consumer_delay_from_str(user_param, optarg)) {
+						fprintf(stderr, " Invalid consumer delay %s\n", optarg);
+						free(duplicates_checker);
+						return FAILURE;
+					}
+					consumer_delay_flag = 0;
+				}
+				if (recv_classes_flag) {
+					if (parse_recv_classes_from_str(user_param, optarg)) {
+						fprintf(stderr, " Invalid receive classes %s\n", optarg);
+						free(duplicates_checker);
+						return FAILURE;
+					}
+					recv_classes_flag = 0;
+				}
+				if (rfc2544_flag) {
+					if (parse_rfc2544_from_str(user_param, optarg)) {
+						fprintf(stderr, " Invalid RFC 2544 search %s\n", optarg);
+						free(duplicates_checker);
+						return FAILURE;
+					}
+					rfc2544_flag = 0;
+				}
+				if (object_size_flag) {
+					if (parse_size_from_str(optarg, &user_param->object_size) || !user_param->object_size ||
+							strchr(optarg, ',') || strchr(optarg, ':')) {
+						fprintf(stderr, " Invalid object size %s\n", optarg);
+						free(duplicates_checker);
+						return FAILURE;
+					}
+					object_size_flag = 0;
+				}
+				break;
+			default:
+				  fprintf(stderr," Invalid Command or flag.\n");
+				  fprintf(stderr," Please check command line and run again.\n\n");
+				  usage(argv[0], user_param->verb, user_param->tst, user_param->connection_type);
+				  if(user_param->connection_type == RawEth) {
+					  usage_raw_ethernet(user_param->tst);
+				  }
+				  free(duplicates_checker);
+				  return FAILURE;
+		}
+
+	}
+	free(duplicates_checker);
+
+#ifdef HAVE_DCS
+	if (!log_active_dci_streams_flag_was_ever_set) {
+		user_param->log_active_dci_streams = user_param->log_dci_streams;
+	}
+#endif
+	if (tcp_flag) {
+		user_param->tcp = 1;
+	}
+	if (run_inf_flag) {
+		user_param->test_method = RUN_INFINITELY;
+	}
+
+	if (srq_flag) {
+		user_param->use_srq = 1;
+	}
+
+	#ifdef HAVE_TD_API
+	if (no_lock_flag) {
+		user_param->no_lock = 1;
+	}
+	#endif
+
+	#ifdef HAVE_OOO_RECV_WRS
+	if (no_ddp_flag) {
+		user_param->no_ddp = 1;
+	}
+	#endif
 
 	if (connectionless_flag) {
 		user_param->connectionless = 1;
@@ -3572,6 +5073,23 @@ int parser(struct perftest_parameters *user_param,char *argv[], int argc)
 		user_param->cpu_util = 1;
 	}
 
+	if (report_setup_flag) {
+		user_param->report_setup = ON;
+	}
+
+	if (autotune_flag) {
+		user_param->autotune = ON;
+	}
+
+	/* --sge_sizes implies the number of SGEs, --sge should agree with it. */
+	if (sge_sizes_num) {
+		if (user_param->sge > 1 && user_param->sge != sge_sizes_num) {
+			fprintf(stderr, " --sge_sizes lists %d SGEs but --sge is %d\n", sge_sizes_num, user_param->sge);
+			return FAILURE;
+		}
+		user_param->sge = sge_sizes_num;
+	}
+
 	if (out_json_flag) {
 		user_param->out_json = 1;
 	}
@@ -3658,6 +5176,23 @@ int parser(struct perftest_parameters *user_param,char *argv[], int argc)
 
 	if(hugepages_flag) {
 		user_param->use_hugepages = 1;
+		user_param->page_policy = PAGE_POLICY_SHM;
+	}
+
+	if (map_populate_flag) {
+		user_param->map_populate = 1;
+	}
+
+	if (verify_flag) {
+		user_param->verify = 1;
+	}
+
+	if (credits_flag) {
+		user_param->use_credits = 1;
+	}
+
+	if (seq_track_flag) {
+		user_param->seq_track = 1;
 	}
 
 	if(old_post_send_flag) {
@@ -3722,6 +5257,24 @@ int parser(struct perftest_parameters *user_param,char *argv[], int argc)
 }
 
 
+/******************************************************************************
+ *
+ ******************************************************************************/
+void trim_sizes(struct perftest_parameters *user_param, uint64_t max_size)
+{
+	int i, num_of_sizes = 0;
+
+	for (i = 0; i < user_param->num_of_sizes; i++) {
+		if (user_param->sizes[i] <= max_size)
+			user_param->sizes[num_of_sizes++] = user_param->sizes[i];
+	}
+
+	if (!num_of_sizes)
+		user_param->sizes[num_of_sizes++] = max_size;
+
+	user_param->num_of_sizes = num_of_sizes;
+}
+
 /******************************************************************************
  *
  ******************************************************************************/
@@ -3763,7 +5316,7 @@ int check_link_and_mtu(struct ibv_context *context,struct perftest_parameters *u
 	/* Compute Max inline size with pre found statistics values */
 	ctx_set_max_inline(context,user_param);
 
-	if (user_param->verb == READ || user_param->verb == ATOMIC)
+	if (USES_VERB(user_param, READ) || USES_VERB(user_param, ATOMIC))
 		user_param->out_reads = ctx_set_out_reads(context,user_param);
 	else
 		user_param->out_reads = 1;
@@ -3773,6 +5326,7 @@ int check_link_and_mtu(struct ibv_context *context,struct perftest_parameters *u
 		if (user_param->test_method == RUN_ALL) {
 			fprintf(stderr," Max msg size in UD is MTU %lu\n",MTU_SIZE(user_param->curr_mtu));
 			fprintf(stderr," Changing to this MTU\n");
+			trim_sizes(user_param, MTU_SIZE(user_param->curr_mtu));
 		}
 		user_param->size = MTU_SIZE(user_param->curr_mtu);
 	}
@@ -3829,7 +5383,7 @@ int check_link(struct ibv_context *context,struct perftest_parameters *user_para
 	/* Compute Max inline size with pre found statistics values */
 	ctx_set_max_inline(context,user_param);
 
-	if (user_param->verb == READ || user_param->verb == ATOMIC)
+	if (USES_VERB(user_param, READ) || USES_VERB(user_param, ATOMIC))
 		user_param->out_reads = ctx_set_out_reads(context,user_param);
 	else
 		user_param->out_reads = 1;
@@ -3871,7 +5425,7 @@ void ctx_print_test_info(struct perftest_parameters *user_param)
 		printf("BW ");
 
 	} else if (user_param->tst == LAT) {
-		printf("Latency ");
+		printf(user_param->conn_rate ? "Connection Rate " : "Latency ");
 	}
 
 	if (user_param->mac_fwd) {
@@ -3953,7 +5507,7 @@ void ctx_print_test_info(struct perftest_parameters *user_param)
 
 	/* we use the receive buffer only for mac forwarding. */
 	if (user_param->mac_fwd == ON)
-		printf(" Buffer size     : %d[B]\n" ,user_param->buff_size/2);
+		printf(" Buffer size     : %" PRIu64 "[B]\n" ,user_param->buff_size/2);
 
 	if (user_param->gid_index != DEF_GID_INDEX)
 		printf(" GID index       : %d\n", user_param->gid_index);
@@ -3966,6 +5520,63 @@ void ctx_print_test_info(struct perftest_parameters *user_param)
 	else
 		printf(" Outstand reads  : %d\n",user_param->out_reads);
 
+	if (user_param->page_policy != PAGE_POLICY_DEFAULT)
+		printf(" Page policy     : %s\n", page_policy_str(user_param->page_policy));
+
+	if (user_param->verify)
+		printf(" Data verify     : CRC32C (%s)\n", perftest_crc32c_impl());
+
+	if (user_param->copy_mode != COPY_MODE_NONE)
+		printf(" Copy mode       : %s\n", copyModeStr[user_param->copy_mode]);
+
+	if (user_param->reg_mode == REG_MODE_CACHED)
+		printf(" Reg mode        : %s, %d entries, pool %d:%s\n", regModeStr[user_param->reg_mode],
+			user_param->reg_cache_size, user_param->reg_pool, user_param->reg_pool_random ? "random" : "seq");
+	else if (user_param->reg_mode == REG_MODE_PER_OP)
+		printf(" Reg mode        : %s, pool %d:%s\n", regModeStr[user_param->reg_mode],
+			user_param->reg_pool, user_param->reg_pool_random ? "random" : "seq");
+
+	if (user_param->touch != TOUCH_NONE)
+		printf(" Touch           : %s, %d%% of the payload, stride %d[B]\n", touchStr[user_param->touch],
+			user_param->touch_fraction, user_param->touch_stride);
+
+	if (user_param->consumer_delay == CONSUMER_DELAY_UNIFORM)
+		printf(" Consumer delay  : %s %.2f-%.2f usec\n", consumerDelayStr[user_param->consumer_delay],
+			user_param->consumer_delay_usec, user_param->consumer_delay_max_usec);
+	else if (user_param->consumer_delay != CONSUMER_DELAY_NONE)
+		printf(" Consumer delay  : %s %.2f usec\n", consumerDelayStr[user_param->consumer_delay],
+			user_param->consumer_delay_usec);
+
+	if (user_param->use_credits)
+		printf(" Receive credits : ON\n");
+
+	if (user_param->recv_classes) {
+		int c;
+
+		printf(" Receive classes :");
+		for (c = 0; c < user_param->recv_classes; c++)
+			printf(" %lu[B]x%d", (unsigned long)user_param->recv_class_size[c], user_param->recv_class_depth[c]);
+		printf("\n");
+	}
+
+	if (user_param->seq_track)
+		printf(" Seq tracking    : ON, reorder window %d\n", SEQ_TRACK_WINDOW);
+
+	if (user_param->rfc2544)
+		printf(" RFC 2544 search : max loss %.4f%%, resolution %.2f%%, %d sec trials\n",
+			user_param->rfc2544_loss, user_param->rfc2544_res, user_param->duration);
+
+	if (user_param->object_size)
+		printf(" Object size     : %" PRIu64 "[B] striped over %d QPs%s\n", user_param->object_size,
+			user_param->num_of_qps, user_param->dualport ? " of both ports" : "");
+
+	if (user_param->remote_pattern == REMOTE_PATTERN_STRIDE)
+		printf(" Remote pattern  : %s:%" PRIu64 "\n", remotePatternStr[user_param->remote_pattern], user_param->remote_stride);
+	else if (user_param->remote_pattern == REMOTE_PATTERN_ZIPF)
+		printf(" Remote pattern  : %s:%.2f\n", remotePatternStr[user_param->remote_pattern], user_param->remote_zipf_theta);
+	else if (user_param->remote_pattern)
+		printf(" Remote pattern  : %s\n", remotePatternStr[user_param->remote_pattern]);
+
 	printf(" rdma_cm QPs	 : %s\n",qp_state[user_param->work_rdma_cm]);
 
 	if (user_param->use_rdma_cm)
@@ -4007,6 +5618,273 @@ static float calc_cpu_util (struct perftest_parameters *user_param)
 		return 0;
 }
 
+/******************************************************************************
+ *
+ ******************************************************************************/
+static double size_dist_mean(struct perftest_parameters *user_param)
+{
+	struct size_dist *dist = &user_param->size_dist;
+	double bytes = 0, mean = 0;
+	uint64_t msgs = 0;
+	int i;
+
+	for (i = 0; i < dist->num; i++) {
+		msgs += dist->msgs[i];
+		bytes += (double)dist->msgs[i] * dist->sizes[i];
+		mean += dist->weights[i] * dist->sizes[i];
+	}
+
+	/* The passive side doesn't post, it expects the mean of the distribution. */
+	return msgs ? bytes / msgs : mean;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static uint32_t verb_mix_size(struct perftest_parameters *user_param, VerbType verb)
+{
+	return (verb == ATOMIC) ? DEF_SIZE_ATOMIC : user_param->size;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static double verb_mix_mean(struct perftest_parameters *user_param)
+{
+	struct verb_mix *mix = &user_param->verb_mix;
+	double bytes = 0, mean = 0;
+	uint64_t msgs = 0;
+	int i;
+
+	for (i = 0; i < mix->num; i++) {
+		msgs += mix->msgs[i];
+		bytes += (double)mix->msgs[i] * verb_mix_size(user_param, mix->verbs[i]);
+		mean += mix->weights[i] * verb_mix_size(user_param, mix->verbs[i]);
+	}
+
+	/* The passive side doesn't post, it expects the mean of the mix. */
+	return msgs ? bytes / msgs : mean;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static void print_report_verb_mix_bw(struct perftest_parameters *user_param, double bw_avg, double msgRate_avg)
+{
+	struct verb_mix *mix = &user_param->verb_mix;
+	double bytes = 0, msg_share, bytes_share;
+	uint64_t msgs = 0;
+	int i;
+
+	for (i = 0; i < mix->num; i++) {
+		msgs += mix->msgs[i];
+		bytes += (double)mix->msgs[i] * verb_mix_size(user_param, mix->verbs[i]);
+	}
+
+	if (!msgs)
+		return;
+
+	printf(RESULT_LINE);
+	printf(RESULT_FMT_VERB_MIX, (user_param->report_fmt == MBS) ? "MiB/sec" : "Gb/sec");
+	for (i = 0; i < mix->num; i++) {
+		msg_share = (double)mix->msgs[i] / msgs;
+		bytes_share = (double)mix->msgs[i] * verb_mix_size(user_param, mix->verbs[i]) / bytes;
+		printf(REPORT_FMT_VERB_MIX, testsStr[mix->verbs[i]], msg_share * 100, bytes_share * 100,
+				mix->msgs[i], bw_avg * bytes_share, msgRate_avg * msg_share);
+	}
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static void print_seq_track_hist(const char *name, const uint64_t *hist)
+{
+	int b;
+
+	printf(" %s:", name);
+	for (b = 0; b < SEQ_TRACK_HIST; b++) {
+		if (!hist[b])
+			continue;
+		if (b == SEQ_TRACK_HIST - 1)
+			printf(" >=%llu:%" PRIu64, 1ULL << b, hist[b]);
+		else if (b == 0)
+			printf(" 1:%" PRIu64, hist[b]);
+		else
+			printf(" %llu-%llu:%" PRIu64, 1ULL << b, (2ULL << b) - 1, hist[b]);
+	}
+	printf("\n");
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static void print_report_seq_track(struct perftest_parameters *user_param)
+{
+	struct seq_tracker *tracker;
+	uint64_t reorder_hist[SEQ_TRACK_HIST] = {0}, burst_hist[SEQ_TRACK_HIST] = {0};
+	uint64_t received = 0;
+	int i, b;
+
+	for (i = 0; i < user_param->num_of_qps * user_param->flows; i++)
+		received += user_param->seq_trackers[i].received;
+
+	/* The sending side has nothing to report. */
+	if (!received && !user_param->seq_unstamped)
+		return;
+
+	printf(RESULT_LINE);
+	printf(RESULT_FMT_SEQ_TRACK);
+	for (i = 0; i < user_param->num_of_qps * user_param->flows; i++) {
+		tracker = &user_param->seq_trackers[i];
+		if (!tracker->received)
+			continue;
+
+		seq_tracker_flush(tracker);
+		printf(REPORT_FMT_SEQ_TRACK, i / user_param->flows, i % user_param->flows, tracker->received, tracker->lost,
+				tracker->base ? 100.0 * tracker->lost / tracker->base : 0, tracker->duplicates, tracker->late,
+				tracker->reordered, tracker->max_reorder, tracker->max_burst);
+		for (b = 0; b < SEQ_TRACK_HIST; b++) {
+			reorder_hist[b] += tracker->reorder_hist[b];
+			burst_hist[b] += tracker->burst_hist[b];
+		}
+	}
+
+	print_seq_track_hist("Reorder distance", reorder_hist);
+	print_seq_track_hist("Loss burst length", burst_hist);
+	if (user_param->seq_unstamped)
+		printf(" Messages without a valid stamp: %" PRIu64 "\n", user_param->seq_unstamped);
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static void print_report_recv_pool_bw(struct perftest_parameters *user_param)
+{
+	double pool_used = 0, max_size_used = 0;
+	uint64_t msgs = 0, bytes = 0, depth = 0;
+	int c;
+
+	for (c = 0; c < user_param->recv_classes; c++) {
+		msgs += user_param->recv_class_msgs[c];
+		bytes += user_param->recv_class_bytes[c];
+		depth += user_param->recv_class_depth[c];
+		pool_used += (double)user_param->recv_class_msgs[c] * user_param->recv_class_size[c];
+	}
+
+	if (!msgs)
+		return;
+
+	/* The same receive WQEs, each with a buffer of the largest message size. */
+	max_size_used = (double)msgs * user_param->size;
+
+	printf(RESULT_LINE);
+	printf(RESULT_FMT_RECV_CLASS);
+	for (c = 0; c < user_param->recv_classes; c++) {
+		printf(REPORT_FMT_RECV_CLASS, (unsigned long)user_param->recv_class_size[c], user_param->recv_class_depth[c],
+				(double)user_param->recv_class_size[c] * user_param->recv_class_depth[c] / 1024,
+				user_param->recv_class_msgs[c],
+				user_param->recv_class_msgs[c] ? 100.0 * user_param->recv_class_bytes[c] /
+				((double)user_param->recv_class_msgs[c] * user_param->recv_class_size[c]) : 0);
+		user_param->recv_class_msgs[c] = 0;
+		user_param->recv_class_bytes[c] = 0;
+	}
+	printf(REPORT_FMT_RECV_POOL, (double)user_param->recv_pool_footprint / (1024 * 1024), 100.0 * bytes / pool_used,
+			(double)depth * user_param->size / (1024 * 1024), 100.0 * bytes / max_size_used);
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static void print_report_size_dist_bw(struct perftest_parameters *user_param, double bw_avg, double msgRate_avg)
+{
+	struct size_dist *dist = &user_param->size_dist;
+	double bytes = 0, msg_share, bytes_share;
+	uint64_t msgs = 0;
+	int i;
+
+	for (i = 0; i < dist->num; i++) {
+		msgs += dist->msgs[i];
+		bytes += (double)dist->msgs[i] * dist->sizes[i];
+	}
+
+	if (!msgs)
+		return;
+
+	printf(RESULT_LINE);
+	printf(RESULT_FMT_SIZE_DIST_BW, (user_param->report_fmt == MBS) ? "MiB/sec" : "Gb/sec");
+	for (i = 0; i < dist->num; i++) {
+		msg_share = (double)dist->msgs[i] / msgs;
+		bytes_share = (double)dist->msgs[i] * dist->sizes[i] / bytes;
+		printf(REPORT_FMT_SIZE_DIST_BW, (unsigned long)dist->sizes[i], msg_share * 100, bytes_share * 100,
+				dist->msgs[i], bw_avg * bytes_share, msgRate_avg * msg_share);
+	}
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+// cppcheck-suppress constParameter
+static inline cycles_t get_median(int n, cycles_t delta[])
+{
+	if ((n - 1) % 2)
+		return(delta[n / 2] + delta[n / 2 - 1]) / 2;
+	else
+		return delta[n / 2];
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static int cycles_compare(const void *aptr, const void *bptr)
+{
+	const cycles_t *a = aptr;
+	const cycles_t *b = bptr;
+	if (*a < *b) return -1;
+	if (*a > *b) return 1;
+
+	return 0;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static void print_report_object(struct perftest_parameters *user_param, double cycles_to_units)
+{
+	uint64_t objects = user_param->iters, i;
+	long format_factor = (user_param->report_fmt == MBS) ? 0x100000 : 125000000;
+	double sum = 0, tail_sum = 0, avg_usec, tail_usec;
+	int port;
+
+	if (!objects)
+		return;
+
+	for (i = 0; i < objects; i++) {
+		sum += user_param->object_cycles[i];
+		tail_sum += user_param->object_tail_cycles[i];
+	}
+	avg_usec = sum * 1000000 / cycles_to_units / objects;
+	tail_usec = tail_sum * 1000000 / cycles_to_units / objects;
+
+	qsort(user_param->object_cycles, objects, sizeof(cycles_t), cycles_compare);
+	printf(RESULT_LINE);
+	printf(RESULT_FMT_OBJECT, (user_param->report_fmt == MBS) ? "MiB/sec" : "Gb/sec");
+	printf(REPORT_FMT_OBJECT, (unsigned long)user_param->size, objects,
+			(double)user_param->object_size / 0x100000, avg_usec,
+			get_median(objects, user_param->object_cycles) * 1000000 / cycles_to_units,
+			user_param->object_cycles[objects * 99 / 100] * 1000000 / cycles_to_units,
+			user_param->object_cycles[objects - 1] * 1000000 / cycles_to_units,
+			(double)user_param->object_size * objects * cycles_to_units / (sum * format_factor),
+			tail_usec, 100 * tail_usec / avg_usec);
+
+	/* The stripes of the QPs of each port, the slower port bounds the objects. */
+	for (port = 0; port < 2 && user_param->dualport; port++) {
+		if (user_param->object_port_stripes[port])
+			printf(REPORT_FMT_OBJECT_PORT, port + 1, user_param->object_port_stripes[port],
+					(double)user_param->object_port_cycles[port] * 1000000 / cycles_to_units /
+					user_param->object_port_stripes[port]);
+	}
+}
+
 /******************************************************************************
  *
  ******************************************************************************/
@@ -4020,6 +5898,7 @@ void print_report_bw (struct perftest_parameters *user_param, struct bw_report_d
 	int num_of_qps = user_param->num_of_qps;
 	long format_factor;
 	uint64_t num_of_calculated_iters = user_param->iters;
+	double avg_size;
 
 	int free_my_bw_rep = 0;
 	if (user_param->test_method == RUN_INFINITELY) {
@@ -4068,20 +5947,30 @@ void print_report_bw (struct perftest_parameters *user_param, struct bw_report_d
 
 	run_inf_bi_factor = (user_param->duplex && user_param->test_method == RUN_INFINITELY) ? (user_param->verb == SEND ? 1 : 2) : 1 ;
 	tsize = run_inf_bi_factor * user_param->size;
+	avg_size = tsize;
+	if (user_param->size_dist.num || user_param->verb_mix.num) {
+		avg_size = user_param->size_dist.num ? size_dist_mean(user_param) : verb_mix_mean(user_param);
+		tsize = (cycles_t)(avg_size + 0.5);
+	}
 	num_of_calculated_iters *= (user_param->test_type == DURATION) ? 1 : num_of_qps;
+	/* The chunks of the objects, a partial last chunk is averaged over them. */
+	if (user_param->object_size) {
+		num_of_calculated_iters = user_param->iters * OBJECT_CHUNKS(user_param);
+		avg_size = (double)user_param->object_size / OBJECT_CHUNKS(user_param);
+	}
 	location_arr = (user_param->noPeak) ? 0 : num_of_calculated_iters - 1;
 	/* support in GBS format */
 	format_factor = (user_param->report_fmt == MBS) ? 0x100000 : 125000000;
 
 	sum_of_test_cycles = ((double)(user_param->tcompleted[location_arr] - user_param->tposted[0]));
 
-	double bw_avg = ((double)tsize*num_of_calculated_iters * cycles_to_units) / (sum_of_test_cycles * format_factor);
+	double bw_avg = (avg_size*num_of_calculated_iters * cycles_to_units) / (sum_of_test_cycles * format_factor);
 	double msgRate_avg = ((double)num_of_calculated_iters * cycles_to_units * run_inf_bi_factor) / (sum_of_test_cycles * 1000000);
 
-	double bw_avg_p1 = ((double)tsize*user_param->iters_per_port[0] * cycles_to_units) / (sum_of_test_cycles * format_factor);
+	double bw_avg_p1 = (avg_size*user_param->iters_per_port[0] * cycles_to_units) / (sum_of_test_cycles * format_factor);
 	double msgRate_avg_p1 = ((double)user_param->iters_per_port[0] * cycles_to_units * run_inf_bi_factor) / (sum_of_test_cycles * 1000000);
 
-	double bw_avg_p2 = ((double)tsize*user_param->iters_per_port[1] * cycles_to_units) / (sum_of_test_cycles * format_factor);
+	double bw_avg_p2 = (avg_size*user_param->iters_per_port[1] * cycles_to_units) / (sum_of_test_cycles * format_factor);
 	double msgRate_avg_p2 = ((double)user_param->iters_per_port[1] * cycles_to_units * run_inf_bi_factor) / (sum_of_test_cycles * 1000000);
 
 	peak_up = !(user_param->noPeak)*(cycles_t)tsize*(cycles_t)cycles_to_units;
@@ -4093,7 +5982,7 @@ void print_report_bw (struct perftest_parameters *user_param, struct bw_report_d
 		memset(my_bw_rep, 0, sizeof(struct bw_report_data));
 	}
 
-	my_bw_rep->size = (unsigned long)user_param->size;
+	my_bw_rep->size = (user_param->size_dist.num || user_param->verb_mix.num) ? (unsigned long)tsize : (unsigned long)user_param->size;
 	my_bw_rep->iters = num_of_calculated_iters;
 	my_bw_rep->bw_peak = (double)peak_up/peak_down;
 	my_bw_rep->bw_avg = bw_avg;
@@ -4103,11 +5992,111 @@ void print_report_bw (struct perftest_parameters *user_param, struct bw_report_d
 	my_bw_rep->bw_avg_p2 = bw_avg_p2;
 	my_bw_rep->msgRate_avg_p2 = msgRate_avg_p2;
 	my_bw_rep->sl = user_param->sl;
+	my_bw_rep->cpu_util = user_param->cpu_util_data.enable ? calc_cpu_util(user_param) : 0;
+
+	/* The single SGE pass of --sge is kept as the reference of the next pass. */
+	if (user_param->sge_ref_pass) {
+		user_param->sge_ref_msg_rate = msgRate_avg;
+		if (free_my_bw_rep == 1)
+			free(my_bw_rep);
+		return;
+	}
 
 	if (!user_param->duplex || ((user_param->verb == SEND || user_param->verb == WRITE_IMM) && user_param->test_type == DURATION)
 			|| user_param->test_method == RUN_INFINITELY || user_param->connection_type == RawEth)
 		print_full_bw_report(user_param, my_bw_rep, NULL);
 
+	if (user_param->size_dist.num && user_param->output == FULL_VERBOSITY)
+		print_report_size_dist_bw(user_param, bw_avg, msgRate_avg);
+
+	if (user_param->verb_mix.num && user_param->output == FULL_VERBOSITY)
+		print_report_verb_mix_bw(user_param, bw_avg, msgRate_avg);
+
+	if (user_param->num_sge > 1 && user_param->output == FULL_VERBOSITY && msgRate_avg > 0 && user_param->sge_ref_msg_rate > 0) {
+		double wr_nsec = 1000 / msgRate_avg;
+		double ref_wr_nsec = 1000 / user_param->sge_ref_msg_rate;
+
+		printf(REPORT_FMT_SGE, user_param->num_sge, sgeLayoutStr[user_param->sge_layout], wr_nsec, ref_wr_nsec,
+				wr_nsec - ref_wr_nsec, (wr_nsec - ref_wr_nsec) / (user_param->num_sge - 1));
+	}
+
+	if (user_param->copy_mode != COPY_MODE_NONE && user_param->copy_msgs) {
+		double copy_nsec = user_param->copy_cycles * 1e9 / cycles_to_units;
+		double msg_nsec = copy_nsec / user_param->copy_msgs;
+
+		if (user_param->output == FULL_VERBOSITY)
+			printf(REPORT_FMT_COPY, copyModeStr[user_param->copy_mode],
+					copy_nsec > 0 ? user_param->copy_bytes / copy_nsec : 0,
+					copy_nsec / user_param->copy_bytes, msg_nsec,
+					msgRate_avg > 0 ? msg_nsec * msgRate_avg / 10 : 0);
+
+		/* The copies are accounted per message size. */
+		user_param->copy_msgs = 0;
+		user_param->copy_bytes = 0;
+		user_param->copy_cycles = 0;
+	}
+
+	if (user_param->reg_mode != REG_MODE_STATIC && user_param->reg_msgs) {
+		double msg_nsec = user_param->reg_cycles * 1e9 / cycles_to_units / user_param->reg_msgs;
+
+		if (user_param->output == FULL_VERBOSITY)
+			printf(REPORT_FMT_REG, regModeStr[user_param->reg_mode],
+					100.0 * user_param->reg_hits / (user_param->reg_hits + user_param->reg_misses),
+					user_param->reg_misses, user_param->reg_evictions, msg_nsec,
+					msgRate_avg > 0 ? msg_nsec * msgRate_avg / 10 : 0);
+
+		user_param->reg_msgs = 0;
+		user_param->reg_hits = 0;
+		user_param->reg_misses = 0;
+		user_param->reg_evictions = 0;
+		user_param->reg_cycles = 0;
+	}
+
+	if (user_param->touch != TOUCH_NONE && user_param->touch_msgs) {
+		double touch_nsec = user_param->touch_cycles * 1e9 / cycles_to_units;
+		double msg_nsec = touch_nsec / user_param->touch_msgs;
+
+		if (user_param->output == FULL_VERBOSITY)
+			printf(REPORT_FMT_TOUCH, touchStr[user_param->touch], msg_nsec,
+					user_param->touch_bytes ? touch_nsec / user_param->touch_bytes : 0,
+					msgRate_avg > 0 ? msg_nsec * msgRate_avg / 10 : 0, "WR time");
+
+		user_param->touch_msgs = 0;
+		user_param->touch_bytes = 0;
+		user_param->touch_cycles = 0;
+	}
+
+	if (user_param->consumer_delay != CONSUMER_DELAY_NONE || user_param->use_credits) {
+		char rnr_str[64] = "n/a (no " CONSUMER_RNR_COUNTER ")";
+
+		if (user_param->consumer_released && user_param->output == FULL_VERBOSITY) {
+			if (user_param->consumer_rnr_naks >= 0)
+				snprintf(rnr_str, sizeof(rnr_str), "%" PRId64 " (%.4f per message)", user_param->consumer_rnr_naks,
+					 (double)user_param->consumer_rnr_naks / user_param->consumer_released);
+			printf(REPORT_FMT_CONSUMER, consumerDelayStr[user_param->consumer_delay], user_param->consumer_released,
+					user_param->consumer_hold_cycles * 1e6 / cycles_to_units / user_param->consumer_released, rnr_str);
+		}
+		if (user_param->sender_stalls && user_param->output == FULL_VERBOSITY)
+			printf(REPORT_FMT_SENDER_STALLS, user_param->sender_stalls,
+					opt_delta ? 100.0 * user_param->sender_stall_cycles / opt_delta : 0,
+					user_param->use_credits ? ", waiting for credits" : "");
+
+		user_param->consumer_released = 0;
+		user_param->consumer_hold_cycles = 0;
+		user_param->consumer_rnr_naks = -1;
+		user_param->sender_stalls = 0;
+		user_param->sender_stall_cycles = 0;
+	}
+
+	if (user_param->recv_pool_footprint && user_param->output == FULL_VERBOSITY)
+		print_report_recv_pool_bw(user_param);
+
+	if (user_param->seq_track && user_param->output == FULL_VERBOSITY)
+		print_report_seq_track(user_param);
+
+	if (user_param->object_cycles && user_param->output == FULL_VERBOSITY)
+		print_report_object(user_param, cycles_to_units);
+
 	if (free_my_bw_rep == 1) {
 		free(my_bw_rep);
 	}
@@ -4191,7 +6180,7 @@ static void write_test_info_to_file(int out_json_fds, struct perftest_parameters
 
 	/* we use the receive buffer only for mac forwarding. */
 	if (user_param->mac_fwd == ON)
-		dprintf(out_json_fds, "\"Buffer_size\": %d,\n" ,user_param->buff_size/2);
+		dprintf(out_json_fds, "\"Buffer_size\": %" PRIu64 ",\n" ,user_param->buff_size/2);
 
 	if (user_param->gid_index != DEF_GID_INDEX)
 		dprintf(out_json_fds, "\"GID_index\": %d,\n", user_param->gid_index);
@@ -4313,35 +6302,59 @@ void print_full_bw_report (struct perftest_parameters *user_param, struct bw_rep
 		fflush(stdout);
 		fprintf(stdout, user_param->cpu_util_data.enable ? REPORT_EXT_CPU_UTIL : REPORT_EXT , calc_cpu_util(user_param));
 	}
+	/* Only filled in when the remote side sent it over the control message protocol */
+	if (rem_bw_rep != NULL && rem_bw_rep->cpu_util > 0)
+		printf(REPORT_REMOTE_CPU_UTIL, rem_bw_rep->cpu_util);
 	if (user_param->counter_ctx) {
 		counters_print(user_param->counter_ctx);
 	}
-}
-/******************************************************************************
- *
- ******************************************************************************/
-// cppcheck-suppress constParameter
-static inline cycles_t get_median(int n, cycles_t delta[])
-{
-	if ((n - 1) % 2)
-		return(delta[n / 2] + delta[n / 2 - 1]) / 2;
-	else
-		return delta[n / 2];
+	if (user_param->perf_events_ctx) {
+		perf_events_print(user_param->perf_events_ctx, my_bw_rep->iters,
+				my_bw_rep->iters * my_bw_rep->size);
+	}
 }
 
 /******************************************************************************
  *
  ******************************************************************************/
-static int cycles_compare(const void *aptr, const void *bptr)
+static void print_report_size_dist_lat(struct perftest_parameters *user_param, double cycles_rtt_quotient)
 {
-	const cycles_t *a = aptr;
-	const cycles_t *b = bptr;
-	if (*a < *b) return -1;
-	if (*a > *b) return 1;
+	struct size_dist *dist = &user_param->size_dist;
+	int measure_cnt = user_param->iters - 1;
+	cycles_t *delta = NULL;
+	double sum;
+	int c, i, n;
 
-	return 0;
-}
+	if (measure_cnt < 1)
+		return;
+
+	ALLOCATE(delta, cycles_t, measure_cnt);
+	printf(RESULT_LINE);
+	printf("%s\n", RESULT_FMT_SIZE_DIST_LAT);
+	for (c = 0; c < dist->num; c++) {
+		n = 0;
+		sum = 0;
+		for (i = 0; i < measure_cnt; i++) {
+			if (dist->classes[i] != c)
+				continue;
+			delta[n] = user_param->tposted[i + 1] - user_param->tposted[i];
+			sum += delta[n++];
+		}
+
+		if (!n)
+			continue;
+
+		qsort(delta, n, sizeof *delta, cycles_compare);
+		printf(REPORT_FMT_SIZE_DIST_LAT, (unsigned long)dist->sizes[c], (double)n * 100 / measure_cnt, (uint64_t)n,
+				delta[0] / cycles_rtt_quotient,
+				get_median(n, delta) / cycles_rtt_quotient,
+				sum / n / cycles_rtt_quotient,
+				delta[n * 99 / 100] / cycles_rtt_quotient,
+				delta[n - 1] / cycles_rtt_quotient);
+	}
 
+	free(delta);
+}
 
 void write_report_lat_to_file(int out_json_fd, struct perftest_parameters *user_param,
 		double latency, double stdev, double average_sum, double average, double stdev_sum,
@@ -4484,9 +6497,29 @@ void print_report_lat (struct perftest_parameters *user_param)
 		printf( user_param->cpu_util_data.enable ? REPORT_EXT_CPU_UTIL : REPORT_EXT , calc_cpu_util(user_param));
 	}
 
+	if (user_param->size_dist.num && user_param->tst == LAT && user_param->output == FULL_VERBOSITY)
+		print_report_size_dist_lat(user_param, cycles_rtt_quotient);
+
+	/* Both sides touch their messages, a one way latency holds the sender and the receiver touches. */
+	if (user_param->touch != TOUCH_NONE && user_param->touch_msgs && user_param->output == FULL_VERBOSITY) {
+		double touch_nsec = user_param->touch_cycles * 1000 / get_cpu_mhz(user_param->cpu_freq_f);
+
+		printf(REPORT_FMT_TOUCH, touchStr[user_param->touch], touch_nsec / user_param->touch_msgs,
+				user_param->touch_bytes ? touch_nsec / user_param->touch_bytes : 0,
+				median ? 100.0 * user_param->touch_cycles / user_param->iters / ((double)median / rtt_factor) : 0,
+				"typical latency");
+	}
+	user_param->touch_msgs = 0;
+	user_param->touch_bytes = 0;
+	user_param->touch_cycles = 0;
+
 	if (user_param->counter_ctx) {
 		counters_print(user_param->counter_ctx);
 	}
+	if (user_param->perf_events_ctx) {
+		perf_events_print(user_param->perf_events_ctx, user_param->iters,
+				user_param->iters * user_param->size);
+	}
 
 	free(delta);
 }
@@ -4553,6 +6586,10 @@ void print_report_lat_duration (struct perftest_parameters *user_param)
 	if (user_param->counter_ctx) {
 		counters_print(user_param->counter_ctx);
 	}
+	if (user_param->perf_events_ctx) {
+		perf_events_print(user_param->perf_events_ctx, user_param->iters,
+				user_param->iters * user_param->size);
+	}
 }
 
 void print_report_fs_rate (struct perftest_parameters *user_param)
@@ -4644,6 +6681,189 @@ void print_report_fs_rate (struct perftest_parameters *user_param)
 
 	free(delta);
 }
+/******************************************************************************
+ *
+ ******************************************************************************/
+void print_report_conn_rate (struct perftest_parameters *user_param)
+{
+	const char *verbs_steps[CONN_STEPS] = {"create", "INIT", "RTR", "RTS", "destroy", "total"};
+	const char *cm_steps[CONN_CM_STEPS] = {"disconnect", "destroy", "connect", "total"};
+	const char **steps = user_param->work_rdma_cm ? cm_steps : verbs_steps;
+	int num_of_steps = user_param->work_rdma_cm ? CONN_CM_STEPS : CONN_STEPS;
+	int measure_cnt = user_param->iters;
+	int i, j, iters_99, iters_99_9;
+	int num_threads = user_param->qp_threads < measure_cnt ? user_param->qp_threads : measure_cnt;
+	uint64_t connections = user_param->iters;
+	double cycles_to_units, average_sum, msec;
+	cycles_t *delta = NULL;
+
+	if (!user_param->conn_step_cycles || measure_cnt <= 0)
+		return;
+
+	ALLOCATE(delta, cycles_t, measure_cnt);
+
+	cycles_to_units = get_cpu_mhz(user_param->cpu_freq_f);
+	iters_99 = ceil(measure_cnt * 0.99) - 1;
+	iters_99_9 = ceil(measure_cnt * 0.999) - 1;
+
+	if (user_param->output == FULL_VERBOSITY) {
+		printf(RESULT_LINE);
+		printf("%s\n", RESULT_FMT_CONN_RATE);
+	}
+
+	for (i = 0; i < num_of_steps; i++) {
+		average_sum = 0;
+		for (j = 0; j < measure_cnt; j++) {
+			delta[j] = user_param->conn_step_cycles[j * CONN_STEPS + i];
+			average_sum += delta[j];
+		}
+
+		qsort(delta, measure_cnt, sizeof *delta, cycles_compare);
+
+		printf(REPORT_FMT_CONN_RATE,
+				steps[i],
+				user_param->iters,
+				delta[0] / cycles_to_units,
+				average_sum / measure_cnt / cycles_to_units,
+				get_median(measure_cnt, delta) / cycles_to_units,
+				delta[iters_99] / cycles_to_units,
+				delta[iters_99_9] / cycles_to_units,
+				delta[measure_cnt - 1] / cycles_to_units);
+	}
+
+	/* Each RDMA CM round reconnects all the QPs. */
+	if (user_param->work_rdma_cm)
+		connections *= user_param->num_of_qps;
+
+	msec = user_param->conn_rate_cycles / cycles_to_units / 1000;
+	printf(RESULT_LINE);
+	printf(REPORT_FMT_CONN_RATE_SUMMARY, connections,
+			user_param->work_rdma_cm ? 1 : num_threads,
+			msec, msec > 0 ? connections * 1000 / msec : 0);
+
+	if (user_param->counter_ctx) {
+		counters_print(user_param->counter_ctx);
+	}
+	if (user_param->perf_events_ctx) {
+		perf_events_print(user_param->perf_events_ctx, connections, 0);
+	}
+
+	free(delta);
+}
+/******************************************************************************
+ *
+ ******************************************************************************/
+void print_report_reg_mr_rate (struct perftest_parameters *user_param)
+{
+	int measure_cnt = user_param->reg_mr_iters * user_param->reg_mr_threads;
+	double cycles_to_units, reg_avg = 0, dereg_avg = 0, sec;
+	cycles_t *reg_cycles = user_param->reg_mr_cycles;
+	cycles_t *dereg_cycles = user_param->reg_mr_cycles + measure_cnt;
+	int i, iters_99;
+
+	if (!user_param->reg_mr_cycles || measure_cnt <= 0)
+		return;
+
+	cycles_to_units = get_cpu_mhz(user_param->cpu_freq_f);
+	iters_99 = ceil(measure_cnt * 0.99) - 1;
+
+	for (i = 0; i < measure_cnt; i++) {
+		reg_avg += reg_cycles[i];
+		dereg_avg += dereg_cycles[i];
+	}
+	reg_avg /= measure_cnt * cycles_to_units;
+	dereg_avg /= measure_cnt * cycles_to_units;
+
+	qsort(reg_cycles, measure_cnt, sizeof *reg_cycles, cycles_compare);
+	qsort(dereg_cycles, measure_cnt, sizeof *dereg_cycles, cycles_compare);
+
+	sec = user_param->reg_mr_total_cycles / cycles_to_units / 1000000;
+
+	printf(REPORT_FMT_REG_MR_RATE,
+			user_param->size,
+			user_param->reg_mr_threads,
+			(uint64_t)measure_cnt,
+			sec > 0 ? measure_cnt / sec : 0,
+			sec > 0 ? (double)measure_cnt * user_param->size / sec / 1e9 : 0,
+			reg_avg,
+			reg_cycles[iters_99] / cycles_to_units,
+			dereg_avg,
+			dereg_cycles[iters_99] / cycles_to_units);
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+void print_report_verify (struct perftest_parameters *user_param)
+{
+	double cycles_to_units, usec;
+
+	if (!user_param->verify || !user_param->verify_msgs)
+		return;
+
+	cycles_to_units = get_cpu_mhz(user_param->cpu_freq_f);
+	usec = user_param->verify_cycles / cycles_to_units;
+
+	printf(" Verified %" PRIu64 " messages, %" PRIu64 " mismatches\n",
+			user_param->verify_msgs, user_param->verify_errors);
+	printf(" Verify CPU cost : %.1f nsec/msg, %.2f GB/s checked\n",
+			usec * 1000 / user_param->verify_msgs,
+			usec > 0 ? user_param->verify_bytes / usec / 1000 : 0);
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+void setup_phase_add(struct setup_report *report, enum setup_phase phase, cycles_t start_cycles)
+{
+	if (!report)
+		return;
+
+	report->cycles[phase] += get_cycles() - start_cycles;
+	report->calls[phase]++;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+void print_report_setup (struct perftest_parameters *user_param)
+{
+	/* The phases run inside ctx_init are indented under it. */
+	const char *phase_str[] = {"open device", "ctx_init", "  alloc PD", "  buffer init",
+		"  create MR", "  create CQs", "  create QPs", "set_up_connection",
+		"hand shake", "connect", "destroy_ctx"};
+	const char *phase_json[] = {"open_device", "ctx_init", "alloc_pd", "buffer_init",
+		"create_mr", "create_cqs", "create_qps", "set_up_connection",
+		"hand_shake", "connect", "destroy_ctx"};
+	struct setup_report *report = &user_param->setup;
+	double cycles_to_units = get_cpu_mhz(user_param->cpu_freq_f);
+	double msec[SETUP_PHASES], avg[SETUP_PHASES];
+	int i;
+
+	for (i = 0; i < SETUP_PHASES; i++) {
+		msec[i] = report->cycles[i] / cycles_to_units / 1000;
+		avg[i] = report->calls[i] ? report->cycles[i] / cycles_to_units / report->calls[i] : 0;
+	}
+
+	printf(RESULT_LINE);
+	printf("%s\n", RESULT_FMT_SETUP);
+	for (i = 0; i < SETUP_PHASES; i++)
+		printf(REPORT_FMT_SETUP, phase_str[i], report->calls[i], msec[i], avg[i]);
+	printf(RESULT_LINE);
+
+	if (user_param->out_json) {
+		int out_json_fd = open_file_write(DEFAULT_SETUP_JSON_FILE_NAME);
+		if (out_json_fd >= 0) {
+			dprintf(out_json_fd, "{\n\"setup\": {\n");
+			for (i = 0; i < SETUP_PHASES; i++)
+				dprintf(out_json_fd, REPORT_FMT_SETUP_JSON, phase_json[i],
+					report->calls[i], msec[i], avg[i], i < SETUP_PHASES - 1 ? "," : "");
+			dprintf(out_json_fd, "}\n}\n");
+			close(out_json_fd);
+		}
+	}
+}
+
 /******************************************************************************
  * End
  ******************************************************************************/
@@ -61,6 +61,7 @@
 #endif
 #include "get_clock.h"
 #include "perftest_counters.h"
+#include "perftest_perf_events.h"
 #include "memory.h"
 
 #ifdef HAVE_CONFIG_H
@@ -123,6 +124,49 @@
 #define DEF_CACHE_LINE_SIZE (64)
 #define DEF_PAGE_SIZE (4096)
 #define DEF_FLOWS (1)
+#define DEF_QP_THREADS (1)
+#define DEF_REG_MR_MIN_SIZE (4096)
+#define DEF_REG_MR_MAX_SIZE (1073741824UL)
+#define REG_MR_BYTES_PER_SIZE (17179869184UL)
+#define REG_MR_MIN_ITERS (16)
+#define MAX_SIZES_NUM (1024)
+#define DEF_SIZES_FACTOR (2.0)
+#define SIZE_PROBE_ITERS (100)
+#define AUTOTUNE_MAX_POST_LIST (32)
+#define AUTOTUNE_PROBE_ITERS (10000)
+#define AUTOTUNE_SAMPLE_MSEC (100)
+#define MAX_SIZE_DIST_CLASSES (256)
+#define SIZE_DIST_SEED (0x9E3779B97F4A7C15ULL)
+#define VERB_MIX_MAX (3)
+#define VERB_MIX_SEED (0xD1B54A32D192ED03ULL)
+#define MAX_SGE_NUM (32)
+#define REMOTE_PATTERN_MAX_LEN (1 << 20)
+#define REMOTE_PATTERN_SEED (0xBF58476D1CE4E5B9ULL)
+#define DEF_HUGETLBFS_DIR "/dev/hugepages"
+#define VERIFY_HDR_SIZE (16)
+#define VERIFY_SEED (0x94D049BB133111EBULL)
+#define VERIFY_MAX_REPORTS (10)
+#define VERIFY_SEQ_UNSENT (UINT64_MAX)
+#define DEF_REG_CACHE_SIZE (64)
+#define MAX_REG_CACHE_SIZE (1 << 20)
+#define DEF_REG_POOL (16)
+#define MAX_REG_POOL (1 << 20)
+#define DEF_TOUCH_STRIDE (64)
+#define MAX_TOUCH_STRIDE (1 << 20)
+#define CONSUMER_DELAY_SEED (0xC2B2AE3D27D4EB4FULL)
+#define CONSUMER_RNR_COUNTER "hw_counters/out_of_buffer"
+#define MAX_RECV_CLASSES (8)
+#define RECV_CLASS_MIN_DEPTH (16)
+#define SEQ_STAMP_SIZE (16)
+#define SEQ_STAMP_MAGIC (0x51455350)
+#define SEQ_TRACK_RAWETH_MIN_SIZE (96)
+#define RFC2544_DEF_RESOLUTION (1.0)
+#define RFC2544_MAX_TRIALS (32)
+#define RFC2544_PROBE_ITERS (10000)
+#define RFC2544_DRAIN_SEC (1)
+
+/* The chunks of an --object_size object, -s bytes each but the last. */
+#define OBJECT_CHUNKS(param) (((param)->object_size + (param)->size - 1) / (param)->size)
 #define RATE_VALUES_COUNT (22)
 #define DISABLED_CQ_MOD_VALUE    (1)
 #define MSG_SIZE_CQ_MOD_LIMIT (8192)
@@ -165,6 +209,7 @@
 #define MAX_GID_IX    (64)
 #define MIN_QP_NUM    (1)
 #define MAX_QP_NUM    (16384)
+#define MAX_QP_THREADS (256)
 #define MIN_QP_MCAST  (1)
 #define MAX_QP_MCAST  (56)
 #define MIN_RX	      (1)
@@ -216,6 +261,34 @@
 
 #define RESULT_FMT_FS_RATE_DUR " #flows		fs_avg_time[usec]    	fps[flow per sec]"
 
+#define RESULT_FMT_QP_RATE " QP control path   #threads    #QPs       time[msec]     QPs/sec"
+
+#define RESULT_FMT_REG_MR_RATE " #bytes          #threads  #regs      regs/sec      GB/sec      reg_avg[usec]  reg_99""%""[usec]  dereg_avg[usec]  dereg_99""%""[usec]"
+
+#define RESULT_FMT_CM_SETUP " RDMA CM setup     avg[msec]     max[msec]"
+
+#define RESULT_FMT_SETUP " Setup phase          #calls    total[msec]    avg[usec]"
+
+#define RESULT_FMT_SIZE_DIST_BW " #bytes     msgs[%%]    bytes[%%]   #messages      goodput[%s]   MsgRate[Mpps]\n"
+
+#define RESULT_FMT_SIZE_DIST_LAT " #bytes     share[%]   #iterations   t_min[usec]   t_median[usec]   t_avg[usec]   99""%"" percentile[usec]   t_max[usec]"
+
+#define RESULT_FMT_SEQ_TRACK " QP    flow   #received    #lost        lost[%%]    #dup       #late        #reordered   max_dist  max_burst\n"
+
+#define RESULT_FMT_RECV_CLASS " #bytes     depth    arena[KiB]  #messages      used[%%]\n"
+
+#define RESULT_FMT_VERB_MIX " verb            msgs[%%]    bytes[%%]   #messages      BW[%s]   MsgRate[Mpps]\n"
+
+#define RESULT_FMT_RFC2544_TRIAL " trial  offered[Mpps]  sent[Mpps]   #sent          #received      loss[%%]     result\n"
+
+#define RESULT_FMT_RFC2544 " #bytes     #trials  max_loss[%%]  max_rate[Mpps]  throughput[Mpps]  BW[%s]      loss[%%]\n"
+
+#define RESULT_FMT_OBJECT " #bytes     #objects   object[MiB]  t_avg[usec]    t_p50[usec]    t_p99[usec]    t_max[usec]    BW[%s]      tail[usec]  tail[%%]\n"
+
+#define RESULT_FMT_AUTOTUNE " post_list  cq_mod  tx_depth  inline  cqe_poll  MsgRate[Mpps]"
+
+#define RESULT_FMT_CONN_RATE " step          #samples    t_min[usec]    t_avg[usec]    t_median[usec]    99""%"" percentile[usec]   99.9""%"" percentile[usec]   t_max[usec]"
+
 /* Result print format */
 #define REPORT_FMT " %-7lu    %-10" PRIu64 "       %-7.2lf            %-7.2lf		     %-7.6lf"
 
@@ -232,6 +305,57 @@
 
 #define REPORT_EXT_CPU_UTIL	"	    %-3.2f\n"
 #define REPORT_EXT_CPU_UTIL_JSON ",\n\"CPU_util\": %.2f\n"
+#define REPORT_REMOTE_CPU_UTIL	" Remote CPU_Util[%%]: %-3.2f\n"
+
+#define REPORT_FMT_QP_RATE " %-16s  %-8d    %-8d   %-10.3lf     %-10.2lf\n"
+
+#define REPORT_FMT_REG_MR_RATE " %-14" PRIu64 "  %-8d  %-9" PRIu64 "  %-12.2f  %-10.2f  %-13.2f  %-13.2f  %-15.2f  %-15.2f\n"
+
+#define REPORT_FMT_CM_SETUP " %-16s  %-10.3f    %-10.3f\n"
+
+#define REPORT_FMT_CM_SETUP_TOTAL " Connections: %d\tIn flight: %d\tTime[msec]: %.3f\tRate[conn/sec]: %.2f\n"
+
+#define REPORT_FMT_SETUP " %-19s  %-8" PRIu64 "  %-12.3f   %-10.2f\n"
+
+#define REPORT_FMT_SETUP_JSON "\"%s\": {\"calls\": %" PRIu64 ", \"total_msec\": %.3f, \"avg_usec\": %.2f}%s\n"
+
+#define REPORT_FMT_SIZE_DIST_BW " %-9lu  %-7.2f    %-7.2f    %-12" PRIu64 "   %-16.2f   %-10.6f\n"
+
+#define REPORT_FMT_SIZE_DIST_LAT " %-9lu  %-7.2f    %-12" PRIu64 "  %-7.2f       %-7.2f          %-7.2f       %-7.2f                %-7.2f\n"
+
+#define REPORT_FMT_VERB_MIX " %-14s  %-7.2f    %-7.2f    %-12" PRIu64 "   %-12.2f   %-10.6f\n"
+
+#define REPORT_FMT_SGE " %d SGEs %s: WR[nsec] %.2f  1 SGE WR[nsec] %.2f  overhead/WR[nsec] %.2f  overhead/SGE[nsec] %.2f\n"
+
+#define REPORT_FMT_COPY " Copy %s: %.2f GB/s  %.3f nsec/byte  %.2f nsec/msg  %.1f%% of WR time\n"
+
+#define REPORT_FMT_REG " Registration %s: hit rate %.2f%%  misses %" PRIu64 "  evictions %" PRIu64 "  %.2f nsec/msg  %.1f%% of WR time\n"
+
+#define REPORT_FMT_TOUCH " Touch %s: %.2f nsec/msg  %.3f nsec/byte  %.1f%% of the %s\n"
+
+#define REPORT_FMT_CONSUMER " Consumer delay %s: %" PRIu64 " buffers held %.2f usec avg  RNR NAKs %s\n"
+
+#define REPORT_FMT_SENDER_STALLS " Sender stalls: %" PRIu64 ", %.1f%% of the run%s\n"
+
+#define REPORT_FMT_SEQ_TRACK " %-4d  %-5d  %-11" PRIu64 "  %-11" PRIu64 "  %-9.6f  %-9" PRIu64 "  %-11" PRIu64 "  %-11" PRIu64 "  %-8" PRIu64 "  %-9" PRIu64 "\n"
+
+#define REPORT_FMT_RECV_CLASS " %-9lu  %-7d  %-10.2f  %-12" PRIu64 "   %-7.2f\n"
+
+#define REPORT_FMT_RECV_POOL " Receive pool: %.2f MiB, %.1f%% used  vs  %.2f MiB, %.1f%% used in max size buffers\n"
+
+#define REPORT_FMT_RFC2544_TRIAL " %-5d  %-13.6f  %-11.6f  %-13" PRIu64 "  %-13" PRIu64 "  %-10.6f  %s\n"
+
+#define REPORT_FMT_RFC2544 " %-9lu  %-7d  %-11.4f  %-14.6f  %-16.6f  %-14.2f  %-10.6f\n"
+
+#define REPORT_FMT_OBJECT " %-9lu  %-9" PRIu64 "  %-11.2f  %-13.2f  %-13.2f  %-13.2f  %-13.2f  %-14.2f  %-10.2f  %-7.2f\n"
+
+#define REPORT_FMT_OBJECT_PORT " Port %d: %" PRIu64 " stripes, %.2f usec avg stripe time\n"
+
+#define REPORT_FMT_AUTOTUNE " %-9d  %-6d  %-8d  %-6d  %-8d  %-10.6f\n"
+
+#define REPORT_FMT_CONN_RATE " %-12s  %-10" PRIu64 "  %-7.2f        %-7.2f        %-7.2f           %-7.2f                %-7.2f                %-7.2f\n"
+
+#define REPORT_FMT_CONN_RATE_SUMMARY " Connections: %" PRIu64 "\tThreads: %d\tTime[msec]: %.2f\tRate[conn/sec]: %.2f\n"
 
 #define REPORT_FMT_QOS " %-7lu    %d           %lu           %-7.2lf            %-7.2lf                  %-7.6lf\n"
 
@@ -329,6 +453,114 @@ typedef enum { SEND , WRITE, WRITE_IMM, READ, ATOMIC } VerbType;
 /* The type of the test */
 typedef enum { LAT , BW , LAT_BY_BW, FS_RATE } TestType;
 
+/* The steps of a QP lifecycle measured by ib_conn_rate. */
+enum conn_rate_step {
+	CONN_STEP_CREATE,
+	CONN_STEP_INIT,
+	CONN_STEP_RTR,
+	CONN_STEP_RTS,
+	CONN_STEP_DESTROY,
+	CONN_STEP_TOTAL,
+	CONN_STEPS
+};
+
+/* The steps of an RDMA CM reconnect round measured by ib_conn_rate. */
+enum conn_rate_cm_step {
+	CONN_CM_STEP_DISCONNECT,
+	CONN_CM_STEP_DESTROY,
+	CONN_CM_STEP_CONNECT,
+	CONN_CM_STEP_TOTAL,
+	CONN_CM_STEPS
+};
+
+/* The setup and teardown phases timed by --report_setup. */
+enum setup_phase {
+	SETUP_PHASE_OPEN_DEVICE,
+	SETUP_PHASE_CTX_INIT,
+	SETUP_PHASE_ALLOC_PD,
+	SETUP_PHASE_BUFFER_INIT,
+	SETUP_PHASE_CREATE_MR,
+	SETUP_PHASE_CREATE_CQS,
+	SETUP_PHASE_CREATE_QPS,
+	SETUP_PHASE_SET_UP_CONNECTION,
+	SETUP_PHASE_HAND_SHAKE,
+	SETUP_PHASE_CONNECT,
+	SETUP_PHASE_DESTROY,
+	SETUP_PHASES
+};
+
+/* Accumulated time and number of calls of each setup phase. */
+struct setup_report {
+	cycles_t			cycles[SETUP_PHASES];
+	uint64_t			calls[SETUP_PHASES];
+};
+
+/* The number of passes of a sizes sweep, a probe precedes each size with --time_per_size
+ * and a single SGE reference pass precedes the measured pass with --sge.
+ */
+#define SIZE_PASSES(param) ((param)->num_of_sizes * (((param)->time_per_size ? 1 : 0) + ((param)->sge > 1 ? 2 : 1)))
+
+/* The message sizes of --size_dist, drawn through a Walker alias table:
+ * a uniform column is accepted with thresh[col] / 2^32, or replaced by its alias.
+ */
+struct size_dist {
+	int				num;
+	uint64_t			sizes[MAX_SIZE_DIST_CLASSES];
+	double				weights[MAX_SIZE_DIST_CLASSES];
+	uint64_t			thresh[MAX_SIZE_DIST_CLASSES];
+	uint8_t				alias[MAX_SIZE_DIST_CLASSES];
+	uint64_t			msgs[MAX_SIZE_DIST_CLASSES];
+	uint8_t				recv_class[MAX_SIZE_DIST_CLASSES];	/* The --recv_classes class of each size. */
+	uint64_t			rng;
+	uint8_t				*classes;	/* The class of each iteration in latency tests. */
+};
+
+/* A xorshift64* step, cheap enough for the posting loops. */
+static inline uint64_t xorshift64s(uint64_t *state)
+{
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 0x2545F4914F6CDD1DULL;
+}
+
+/* Draws a size class in O(1), one random word gives both the column and the coin. */
+static inline int size_dist_draw(struct size_dist *dist)
+{
+	uint64_t r = xorshift64s(&dist->rng);
+	uint32_t col = (uint32_t)(((r >> 32) * (uint64_t)dist->num) >> 32);
+
+	return ((r & 0xFFFFFFFFULL) < dist->thresh[col]) ? (int)col : dist->alias[col];
+}
+
+/* The verbs of --verb_mix, thresh[] is the cumulative share scaled to 2^32. */
+struct verb_mix {
+	int				num;
+	int				mask;		/* 1 << verb of each verb in the mix. */
+	VerbType			verbs[VERB_MIX_MAX];
+	double				weights[VERB_MIX_MAX];
+	uint64_t			thresh[VERB_MIX_MAX];
+	uint64_t			msgs[VERB_MIX_MAX];
+	uint64_t			rng;
+};
+
+static inline int verb_mix_draw(struct verb_mix *mix)
+{
+	uint64_t r = xorshift64s(&mix->rng) >> 32;
+	int i = 0;
+
+	while (i < mix->num - 1 && r >= mix->thresh[i])
+		i++;
+
+	return i;
+}
+
+/* True when the test posts the verb, alone or as part of --verb_mix. */
+#define USES_VERB(param, v) ((param)->verb == (v) || ((param)->verb_mix.mask & (1 << (v))))
+
+/* The setup report of the parameters, NULL when --report_setup is off. */
+#define SETUP_REPORT(param) ((param)->report_setup ? &(param)->setup : NULL)
+
 /* The type of the machine ( server or client actually). */
 typedef enum { SERVER , CLIENT , UNCHOSEN} MachineType;
 
@@ -350,6 +582,31 @@ enum ctx_report_fmt { GBS, MBS };
 /* Test method */
 enum ctx_test_method {RUN_REGULAR, RUN_ALL, RUN_INFINITELY};
 
+/* The placement of the SGEs of a --sge work request in the buffer. */
+enum sge_layout {SGE_CONTIGUOUS, SGE_SCATTER, SGE_MR};
+
+/* The order of the remote addresses of --remote_pattern, OFF walks the cycle buffer. */
+enum remote_pattern {REMOTE_PATTERN_OFF, REMOTE_PATTERN_SEQ, REMOTE_PATTERN_STRIDE, REMOTE_PATTERN_RANDOM, REMOTE_PATTERN_ZIPF};
+
+/* The allocation of the host buffers of --page_policy, SHM is --use_hugepages. */
+enum page_policy {PAGE_POLICY_DEFAULT, PAGE_POLICY_SHM, PAGE_POLICY_MMAP_2M, PAGE_POLICY_MMAP_1G,
+		  PAGE_POLICY_HUGETLBFS, PAGE_POLICY_THP, PAGE_POLICY_4K};
+
+/* The content of the buffers of --buf_init, AUTO is resolved by the test type. */
+enum buf_init {BUF_INIT_AUTO, BUF_INIT_RANDOM, BUF_INIT_ZERO, BUF_INIT_PATTERN, BUF_INIT_NONE};
+
+/* The copy of --copy_mode between the application buffer and the registered slots. */
+enum copy_mode {COPY_MODE_NONE, COPY_MODE_MEMCPY, COPY_MODE_NT_STORE, COPY_MODE_REP_MOVSB};
+
+/* The registration of the local buffers of --reg_mode, STATIC registers them once in create_mr. */
+enum reg_mode {REG_MODE_STATIC, REG_MODE_PER_OP, REG_MODE_CACHED};
+
+/* The payload accesses of --touch, a mask of the sender write and the receiver read. */
+enum touch {TOUCH_NONE, TOUCH_TX_WRITE, TOUCH_RX_READ, TOUCH_BOTH};
+
+/* The think time distribution of --consumer_delay. */
+enum consumer_delay {CONSUMER_DELAY_NONE, CONSUMER_DELAY_FIXED, CONSUMER_DELAY_EXP, CONSUMER_DELAY_UNIFORM};
+
 /* The type of the device */
 enum ctx_device {
 	DEVICE_ERROR		= -1,
@@ -582,7 +839,7 @@ struct perftest_parameters {
 	int				is_reversed;
 	int				work_rdma_cm;
 	char				*user_mgid;
-	int				buff_size;
+	uint64_t			buff_size;
 	int             		pkey_index;
 	int				raw_qos;
 	int				has_payload_modification;
@@ -675,6 +932,102 @@ struct perftest_parameters {
 	int				connectionless;
 	uint16_t			cqe_poll;
 	int				use_cqe_poll;
+	struct perf_events_context	*perf_events_ctx;
+	int				rem_ctrl_proto;
+	int				qp_threads;
+	int				report_qp_rate;
+	cycles_t			qp_create_cycles;
+	cycles_t			qp_connect_cycles;
+	int				conn_rate;
+	cycles_t			*conn_step_cycles;
+	cycles_t			conn_rate_cycles;
+	int				reg_mr_rate;
+	uint64_t			reg_min_size;
+	uint64_t			reg_max_size;
+	uint64_t			reg_mr_iters;
+	int				reg_mr_threads;
+	cycles_t			*reg_mr_cycles;
+	cycles_t			reg_mr_total_cycles;
+	int				cm_inflight;
+	int				report_cm_setup;
+	int				report_setup;
+	struct setup_report		setup;
+	uint64_t			*sizes;
+	int				num_of_sizes;
+	int				time_per_size;
+	int				size_probe;
+	uint64_t			size_max_iters;
+	int				autotune;
+	struct size_dist		size_dist;
+	struct verb_mix			verb_mix;
+	int				sge;
+	int				sge_layout;
+	uint64_t			sge_sizes[MAX_SGE_NUM];
+	int				num_sge;	/* The SGEs per WR of the current pass. */
+	int				sge_ref_pass;
+	double				sge_ref_msg_rate;
+	int				remote_pattern;
+	uint64_t			remote_stride;
+	double				remote_zipf_theta;
+	uint64_t			remote_region;
+	int				page_policy;
+	char				*hugetlbfs_dir;
+	uint64_t			working_set;
+	int				buf_init;
+	int				map_populate;
+	int				verify;
+	uint64_t			verify_msgs;
+	uint64_t			verify_bytes;
+	uint64_t			verify_errors;
+	cycles_t			verify_cycles;
+	int				copy_mode;
+	uint64_t			copy_msgs;
+	uint64_t			copy_bytes;
+	cycles_t			copy_cycles;
+	int				reg_mode;
+	int				reg_cache_size;
+	int				reg_pool;
+	int				reg_pool_random;
+	uint64_t			reg_msgs;
+	uint64_t			reg_hits;
+	uint64_t			reg_misses;
+	uint64_t			reg_evictions;
+	cycles_t			reg_cycles;
+	int				touch;
+	int				touch_fraction;
+	int				touch_stride;
+	uint64_t			touch_msgs;
+	uint64_t			touch_bytes;
+	cycles_t			touch_cycles;
+	uint64_t			touch_sum;
+	int				consumer_delay;
+	double				consumer_delay_usec;
+	double				consumer_delay_max_usec;
+	uint64_t			consumer_released;
+	cycles_t			consumer_hold_cycles;
+	int64_t				consumer_rnr_naks;
+	uint64_t			sender_stalls;
+	cycles_t			sender_stall_cycles;
+	int				use_credits;
+	int				recv_classes;
+	uint64_t			recv_class_size[MAX_RECV_CLASSES];
+	int				recv_class_depth[MAX_RECV_CLASSES];
+	uint64_t			recv_class_msgs[MAX_RECV_CLASSES];
+	uint64_t			recv_class_bytes[MAX_RECV_CLASSES];
+	uint64_t			recv_pool_footprint;
+	int				seq_track;
+	uint64_t			*seq_tx;	/* The next sequence number of each QP and flow. */
+	struct seq_tracker		*seq_trackers;
+	uint64_t			seq_unstamped;
+	int				rfc2544;
+	double				rfc2544_loss;	/* The loss a trial passes with, in percent. */
+	double				rfc2544_res;	/* The search stops within it, in percent of the max rate. */
+	uint64_t			recv_total;	/* The messages the last run_iter_bw_server received. */
+	uint64_t			object_size;
+	cycles_t			*object_cycles;	/* The first post to the last completion of each object. */
+	cycles_t			*object_tail_cycles;	/* The slowest stripe of each object behind the mean stripe. */
+	cycles_t			object_port_cycles[2];
+	uint64_t			object_port_stripes[2];
 };
 
 struct report_options {
@@ -694,6 +1047,7 @@ struct bw_report_data {
 	double msgRate_avg_p1;
 	double msgRate_avg_p2;
 	int sl;
+	float cpu_util;
 };
 
 struct rate_gbps_string {
@@ -741,6 +1095,14 @@ static const struct rate_gbps_string RATE_VALUES[RATE_VALUES_COUNT] = {
  */
 const char *link_layer_str(int8_t link_layer);
 
+/* page_policy_str
+ *
+ * Description : Return a String representation of the --page_policy allocation.
+ *
+ * Return Value : "default", "shm", "2m", "1g", "hugetlbfs", "thp" or "4k".
+ */
+const char *page_policy_str(int page_policy);
+
 /* str_link_layer
  *
  * Description : Try to parse a string into a verbs link layer type.
@@ -867,6 +1229,83 @@ void print_report_lat_duration (struct perftest_parameters *user_param);
  */
 void print_report_fs_rate (struct perftest_parameters *user_param);
 
+/* print_report_conn_rate
+ *
+ * Description : Prints the connections per second and the min/avg/median/tail
+ *				 latency of each step of the connection lifecycle.
+ *
+ * Parameters :
+ *
+ *   user_param  - the parameters parameters.
+ *
+ */
+void print_report_conn_rate (struct perftest_parameters *user_param);
+
+/* print_report_reg_mr_rate
+ *
+ * Description : Prints the registrations per second, the registered GB/s and
+ *				 the average and 99% latency of ibv_reg_mr/ibv_dereg_mr for the
+ *				 current size.
+ *
+ * Parameters :
+ *
+ *   user_param  - the parameters parameters.
+ *
+ */
+void print_report_reg_mr_rate (struct perftest_parameters *user_param);
+
+/* print_report_verify
+ *
+ * Description : Prints the messages checked by --verify, the mismatches found
+ *				 and the CPU time the CRC32C checks took.
+ *
+ * Parameters :
+ *
+ *   user_param  - the parameters parameters.
+ *
+ */
+void print_report_verify (struct perftest_parameters *user_param);
+
+/* trim_sizes
+ *
+ * Description : Drops the sizes larger than max_size from the sizes sweep,
+ *				 or sweeps max_size alone if none is left.
+ *
+ * Parameters :
+ *
+ *   user_param  - the parameters parameters.
+ *   max_size    - the largest message size supported.
+ *
+ */
+void trim_sizes(struct perftest_parameters *user_param, uint64_t max_size);
+
+/* setup_phase_add
+ *
+ * Description : Adds the time passed since start_cycles to a setup phase.
+ *				 Does nothing when report is NULL (--report_setup is off).
+ *
+ * Parameters :
+ *
+ *   report       - the setup report, see SETUP_REPORT.
+ *   phase        - the setup phase to account.
+ *   start_cycles - the cycles count at the start of the phase.
+ *
+ */
+void setup_phase_add(struct setup_report *report, enum setup_phase phase, cycles_t start_cycles);
+
+/* print_report_setup
+ *
+ * Description : Prints the number of calls, the total and the average time of
+ *				 each setup and teardown phase, and writes them to the setup
+ *				 JSON file with --out_json.
+ *
+ * Parameters :
+ *
+ *   user_param  - the parameters parameters.
+ *
+ */
+void print_report_setup (struct perftest_parameters *user_param);
+
 /* set_mtu
  *
  * Description : set MTU from the port or user
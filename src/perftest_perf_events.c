@@ -0,0 +1,306 @@
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "perftest_parameters.h"
+
+#if defined(__linux__)
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#define PERF_EVENTS_MAX (16)
+
+struct perf_event_name {
+	const char *name;
+	uint32_t type;
+	uint64_t config;
+};
+
+#define HW_CACHE(id, op, res) \
+	(PERF_COUNT_HW_CACHE_##id | (PERF_COUNT_HW_CACHE_OP_##op << 8) | \
+	 (PERF_COUNT_HW_CACHE_RESULT_##res << 16))
+
+static const struct perf_event_name perf_event_names[] = {
+	{ "cycles",			PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	{ "cpu-cycles",			PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	{ "instructions",		PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	{ "cache-references",		PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES },
+	{ "cache-misses",		PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+	{ "branches",			PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS },
+	{ "branch-instructions",	PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS },
+	{ "branch-misses",		PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+	{ "bus-cycles",			PERF_TYPE_HARDWARE, PERF_COUNT_HW_BUS_CYCLES },
+	{ "stalled-cycles-frontend",	PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_FRONTEND },
+	{ "stalled-cycles-backend",	PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND },
+	{ "ref-cycles",			PERF_TYPE_HARDWARE, PERF_COUNT_HW_REF_CPU_CYCLES },
+	{ "L1-dcache-loads",		PERF_TYPE_HW_CACHE, HW_CACHE(L1D, READ, ACCESS) },
+	{ "L1-dcache-load-misses",	PERF_TYPE_HW_CACHE, HW_CACHE(L1D, READ, MISS) },
+	{ "L1-dcache-stores",		PERF_TYPE_HW_CACHE, HW_CACHE(L1D, WRITE, ACCESS) },
+	{ "L1-icache-load-misses",	PERF_TYPE_HW_CACHE, HW_CACHE(L1I, READ, MISS) },
+	{ "LLC-loads",			PERF_TYPE_HW_CACHE, HW_CACHE(LL, READ, ACCESS) },
+	{ "LLC-load-misses",		PERF_TYPE_HW_CACHE, HW_CACHE(LL, READ, MISS) },
+	{ "LLC-stores",			PERF_TYPE_HW_CACHE, HW_CACHE(LL, WRITE, ACCESS) },
+	{ "LLC-store-misses",		PERF_TYPE_HW_CACHE, HW_CACHE(LL, WRITE, MISS) },
+	{ "dTLB-loads",			PERF_TYPE_HW_CACHE, HW_CACHE(DTLB, READ, ACCESS) },
+	{ "dTLB-load-misses",		PERF_TYPE_HW_CACHE, HW_CACHE(DTLB, READ, MISS) },
+	{ "dTLB-stores",		PERF_TYPE_HW_CACHE, HW_CACHE(DTLB, WRITE, ACCESS) },
+	{ "dTLB-store-misses",		PERF_TYPE_HW_CACHE, HW_CACHE(DTLB, WRITE, MISS) },
+	{ "iTLB-loads",			PERF_TYPE_HW_CACHE, HW_CACHE(ITLB, READ, ACCESS) },
+	{ "iTLB-load-misses",		PERF_TYPE_HW_CACHE, HW_CACHE(ITLB, READ, MISS) },
+	{ "branch-loads",		PERF_TYPE_HW_CACHE, HW_CACHE(BPU, READ, ACCESS) },
+	{ "branch-load-misses",		PERF_TYPE_HW_CACHE, HW_CACHE(BPU, READ, MISS) },
+	{ "cpu-clock",			PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_CLOCK },
+	{ "task-clock",			PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+	{ "page-faults",		PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+	{ "minor-faults",		PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MIN },
+	{ "major-faults",		PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MAJ },
+	{ "context-switches",		PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+	{ "cpu-migrations",		PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS },
+};
+
+struct perf_events_context {
+	char *event_list;
+	unsigned num_events;
+	int group_fd;
+	struct {
+		int fd;
+		char *name;
+		uint32_t type;
+		uint64_t config;
+		int exclude_kernel;
+	} events[];
+};
+
+/* Layout of read() on the group leader with PERF_FORMAT_GROUP and both time fields. */
+struct perf_events_read_format {
+	uint64_t nr;
+	uint64_t time_enabled;
+	uint64_t time_running;
+	uint64_t values[PERF_EVENTS_MAX];
+};
+
+static long sys_perf_event_open(struct perf_event_attr *attr, pid_t pid,
+		int cpu, int group_fd, unsigned long flags)
+{
+	return syscall(__NR_perf_event_open, attr, pid, cpu, group_fd, flags);
+}
+
+/* Resolve a perf(1) style name, optional ":u" modifier and "rNNNN" raw codes. */
+static int perf_events_lookup(char *name, uint32_t *type, uint64_t *config,
+		int *exclude_kernel)
+{
+	char *modifier, *end;
+	int i;
+
+	*exclude_kernel = 0;
+	modifier = strchr(name, ':');
+	if (modifier) {
+		if (strcmp(modifier, ":u"))
+			return FAILURE;
+		*modifier = '\0';
+		*exclude_kernel = 1;
+	}
+
+	if (name[0] == 'r' && name[1] != '\0') {
+		*config = strtoull(name + 1, &end, 16);
+		if (*end == '\0') {
+			*type = PERF_TYPE_RAW;
+			return SUCCESS;
+		}
+	}
+
+	for (i = 0; i < sizeof(perf_event_names) / sizeof(perf_event_names[0]); i++) {
+		if (!strcmp(name, perf_event_names[i].name)) {
+			*type = perf_event_names[i].type;
+			*config = perf_event_names[i].config;
+			return SUCCESS;
+		}
+	}
+
+	return FAILURE;
+}
+
+int perf_events_alloc(const char *event_names,
+		struct perf_events_context **ctx)
+{
+	/* Count the number of commas and allocate accordingly */
+	unsigned i, num_events = (unsigned)(strlen(event_names) > 0);
+	char *next_event;
+
+	for (i = 0; i < strlen(event_names); i++) {
+		if (event_names[i] == ',') {
+			num_events++;
+		}
+	}
+
+	if (num_events == 0 || num_events > PERF_EVENTS_MAX) {
+		fprintf(stderr, " Between 1 and %d perf events are supported\n", PERF_EVENTS_MAX);
+		return FAILURE;
+	}
+
+	*ctx = calloc(1, sizeof(struct perf_events_context) +
+			num_events * sizeof((*ctx)->events[0]));
+	if (*ctx == NULL) {
+		fprintf(stderr, "failed to allocate memory\n");
+		return FAILURE;
+	}
+	(*ctx)->event_list = strdup(event_names);
+	(*ctx)->num_events = num_events;
+	(*ctx)->group_fd = -1;
+
+	for (i = 0, next_event = strtok((*ctx)->event_list, ",");
+		 i < num_events;
+		 i++, next_event = strtok(0, ",")) {
+		(*ctx)->events[i].fd = -1;
+		if (!next_event || perf_events_lookup(next_event, &(*ctx)->events[i].type,
+				&(*ctx)->events[i].config, &(*ctx)->events[i].exclude_kernel)) {
+			fprintf(stderr, " Unknown perf event: %s\n", next_event ? next_event : "");
+			(*ctx)->num_events = 0;
+			perf_events_close(*ctx);
+			*ctx = NULL;
+			return FAILURE;
+		}
+		(*ctx)->events[i].name = next_event;
+	}
+
+	return SUCCESS;
+}
+
+int perf_events_open(struct perf_events_context *ctx)
+{
+	struct perf_event_attr attr;
+	int i;
+
+	for (i = 0; i < ctx->num_events; i++) {
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = ctx->events[i].type;
+		attr.config = ctx->events[i].config;
+		attr.disabled = (i == 0);
+		attr.exclude_kernel = ctx->events[i].exclude_kernel;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_GROUP |
+			PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		ctx->events[i].fd = sys_perf_event_open(&attr, 0, -1, ctx->group_fd, 0);
+		/* Unprivileged users may only count user space (perf_event_paranoid) */
+		if (ctx->events[i].fd < 0 && (errno == EACCES || errno == EPERM) && !attr.exclude_kernel) {
+			attr.exclude_kernel = 1;
+			ctx->events[i].fd = sys_perf_event_open(&attr, 0, -1, ctx->group_fd, 0);
+			if (ctx->events[i].fd >= 0)
+				fprintf(stderr, " perf event %s counts user space only\n", ctx->events[i].name);
+		}
+		if (ctx->events[i].fd < 0) {
+			fprintf(stderr, " Failed to open perf event %s: %s\n",
+					ctx->events[i].name, strerror(errno));
+			goto perf_events_cleanup;
+		}
+
+		if (i == 0)
+			ctx->group_fd = ctx->events[0].fd;
+	}
+
+	return SUCCESS;
+
+perf_events_cleanup:
+	for (i--; i >= 0; i--) {
+		close(ctx->events[i].fd);
+		ctx->events[i].fd = -1;
+	}
+	ctx->group_fd = -1;
+	return FAILURE;
+}
+
+void perf_events_enable(struct perf_events_context *ctx)
+{
+	if (ctx->group_fd < 0)
+		return;
+
+	(void) ioctl(ctx->group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	(void) ioctl(ctx->group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+void perf_events_disable(struct perf_events_context *ctx)
+{
+	if (ctx->group_fd < 0)
+		return;
+
+	(void) ioctl(ctx->group_fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+}
+
+void perf_events_print(struct perf_events_context *ctx,
+		uint64_t ops, uint64_t bytes)
+{
+	struct perf_events_read_format data;
+	double scale = 1.0, value;
+	int i;
+
+	if (ctx->group_fd < 0)
+		return;
+
+	memset(&data, 0, sizeof(data));
+	if (read(ctx->group_fd, &data, sizeof(data)) < 0 || data.nr != ctx->num_events) {
+		fprintf(stderr, " Failed to read perf events\n");
+		return;
+	}
+
+	/* The group is scheduled as a whole, so a single multiplexing factor applies */
+	if (data.time_running && data.time_running < data.time_enabled)
+		scale = (double)data.time_enabled / data.time_running;
+
+	printf(" %-24s %-20s %-16s %s\n", "perf event", "total", "per op", "per byte");
+	for (i = 0; i < ctx->num_events; i++) {
+		value = data.values[i] * scale;
+		printf(" %-24s %-20.0lf %-16.3lf %.5lf\n", ctx->events[i].name, value,
+				ops ? value / ops : 0.0, bytes ? value / bytes : 0.0);
+	}
+	if (scale > 1.0)
+		printf(" (events multiplexed, scaled by %.2lf)\n", scale);
+	printf("\n");
+}
+
+void perf_events_close(struct perf_events_context *ctx)
+{
+	int i;
+	for (i = 0; i < ctx->num_events; i++) {
+		if (ctx->events[i].fd >= 0)
+			close(ctx->events[i].fd);
+	}
+
+	free(ctx->event_list);
+	free(ctx);
+}
+
+#else
+
+struct perf_events_context {
+	int unused;
+};
+
+int perf_events_alloc(const char *event_names,
+		struct perf_events_context **ctx)
+{
+	fprintf(stderr, " perf events are supported on Linux only\n");
+	return FAILURE;
+}
+
+int perf_events_open(struct perf_events_context *ctx)
+{
+	return FAILURE;
+}
+
+void perf_events_enable(struct perf_events_context *ctx) {}
+
+void perf_events_disable(struct perf_events_context *ctx) {}
+
+void perf_events_print(struct perf_events_context *ctx,
+		uint64_t ops, uint64_t bytes) {}
+
+void perf_events_close(struct perf_events_context *ctx)
+{
+	free(ctx);
+}
+
+#endif
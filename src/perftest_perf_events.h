@@ -0,0 +1,42 @@
+#ifndef PERFTEST_PERF_EVENTS_H
+#define PERFTEST_PERF_EVENTS_H
+
+#include <stdint.h>
+
+struct perf_events_context;
+
+/*
+ * Allocate context for CPU performance events (perf_event_open).
+ * Event names follow perf(1): "cycles,instructions,LLC-load-misses,r01c4".
+ */
+int perf_events_alloc(const char *event_names,
+		struct perf_events_context **ctx);
+
+/*
+ * Open the events as a single group bound to the calling thread.
+ * The group is created disabled.
+ */
+int perf_events_open(struct perf_events_context *ctx);
+
+/*
+ * Reset and start counting. Async-signal-safe (used from catch_alarm).
+ */
+void perf_events_enable(struct perf_events_context *ctx);
+
+/*
+ * Stop counting. Async-signal-safe (used from catch_alarm).
+ */
+void perf_events_disable(struct perf_events_context *ctx);
+
+/*
+ * Read the group and output the values, per operation and per byte, to STDOUT.
+ */
+void perf_events_print(struct perf_events_context *ctx,
+		uint64_t ops, uint64_t bytes);
+
+/*
+ * Close the event group and free the context.
+ */
+void perf_events_close(struct perf_events_context *ctx);
+
+#endif
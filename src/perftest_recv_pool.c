@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "perftest_recv_pool.h"
+
+#define RECV_POOL_ALIGN (64)
+
+/* The class is kept in the high half of the WR ID, the slot in the low half. */
+#define RECV_POOL_WR_ID(class, slot) (((uint64_t)(class) << 32) | (uint32_t)(slot))
+#define RECV_POOL_WR_CLASS(wr_id) ((int)((wr_id) >> 32))
+#define RECV_POOL_WR_SLOT(wr_id) ((int)((wr_id) & 0xFFFFFFFFULL))
+
+int recv_pool_create(struct ibv_pd *pd, struct ibv_pd *srq_pd, int num_classes,
+		     const uint64_t *class_size, const int *depth, struct recv_pool **pool)
+{
+	struct recv_pool *new_pool;
+	struct ibv_srq_init_attr attr;
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	uint64_t offset = 0;
+	int c, j, slot = 0;
+
+	new_pool = calloc(1, sizeof(*new_pool));
+	if (!new_pool)
+		return 1;
+
+	new_pool->num_classes = num_classes;
+	new_pool->class_size = calloc(num_classes, sizeof(uint64_t));
+	new_pool->stride = calloc(num_classes, sizeof(uint64_t));
+	new_pool->depth = calloc(num_classes, sizeof(int));
+	new_pool->srq = calloc(num_classes, sizeof(struct ibv_srq*));
+	if (!new_pool->class_size || !new_pool->stride || !new_pool->depth || !new_pool->srq)
+		goto err;
+
+	for (c = 0; c < num_classes; c++) {
+		new_pool->class_size[c] = class_size[c];
+		new_pool->stride[c] = (class_size[c] + RECV_POOL_ALIGN - 1) & ~((uint64_t)RECV_POOL_ALIGN - 1);
+		new_pool->depth[c] = depth[c];
+		new_pool->arena_size += new_pool->stride[c] * depth[c];
+		new_pool->num_slots += depth[c];
+	}
+	new_pool->arena_size = (new_pool->arena_size + page_size - 1) & ~(page_size - 1);
+
+	if (posix_memalign(&new_pool->arena, page_size, new_pool->arena_size)) {
+		fprintf(stderr, "Couldn't allocate a %lu bytes receive pool\n", (unsigned long)new_pool->arena_size);
+		new_pool->arena = NULL;
+		goto err;
+	}
+	memset(new_pool->arena, 0, new_pool->arena_size);
+
+	new_pool->mr = ibv_reg_mr(pd, new_pool->arena, new_pool->arena_size, IBV_ACCESS_LOCAL_WRITE);
+	if (!new_pool->mr) {
+		fprintf(stderr, "Couldn't register the receive pool\n");
+		goto err;
+	}
+
+	new_pool->sge = calloc(new_pool->num_slots, sizeof(struct ibv_sge));
+	new_pool->wr = calloc(new_pool->num_slots, sizeof(struct ibv_recv_wr));
+	if (!new_pool->sge || !new_pool->wr)
+		goto err;
+
+	for (c = 0; c < num_classes; c++) {
+		memset(&attr, 0, sizeof(attr));
+		attr.attr.max_wr = depth[c];
+		attr.attr.max_sge = 1;
+		new_pool->srq[c] = ibv_create_srq(srq_pd, &attr);
+		if (!new_pool->srq[c]) {
+			fprintf(stderr, "Couldn't create the SRQ of the %lu bytes receive class\n",
+				(unsigned long)class_size[c]);
+			goto err;
+		}
+
+		for (j = 0; j < depth[c]; j++, slot++) {
+			new_pool->sge[slot].addr = (uintptr_t)new_pool->arena + offset;
+			new_pool->sge[slot].length = class_size[c];
+			new_pool->sge[slot].lkey = new_pool->mr->lkey;
+			new_pool->wr[slot].wr_id = RECV_POOL_WR_ID(c, slot);
+			new_pool->wr[slot].sg_list = &new_pool->sge[slot];
+			new_pool->wr[slot].num_sge = 1;
+			offset += new_pool->stride[c];
+		}
+	}
+
+	*pool = new_pool;
+	return 0;
+
+err:
+	recv_pool_destroy(new_pool);
+	return 1;
+}
+
+int recv_pool_post(struct recv_pool *pool)
+{
+	struct ibv_recv_wr *bad_wr;
+	int slot;
+
+	for (slot = 0; slot < pool->num_slots; slot++) {
+		if (ibv_post_srq_recv(pool->srq[RECV_POOL_WR_CLASS(pool->wr[slot].wr_id)], &pool->wr[slot], &bad_wr)) {
+			fprintf(stderr, "Couldn't post the receive pool buffer %d\n", slot);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int recv_pool_repost(struct recv_pool *pool, const struct ibv_wc *wc)
+{
+	struct ibv_recv_wr *bad_wr;
+	int class = RECV_POOL_WR_CLASS(wc->wr_id);
+
+	if (ibv_post_srq_recv(pool->srq[class], &pool->wr[RECV_POOL_WR_SLOT(wc->wr_id)], &bad_wr)) {
+		fprintf(stderr, "Couldn't repost the receive pool buffer %d\n", RECV_POOL_WR_SLOT(wc->wr_id));
+		return -1;
+	}
+	return class;
+}
+
+void recv_pool_destroy(struct recv_pool *pool)
+{
+	int c;
+
+	if (pool->srq) {
+		for (c = 0; c < pool->num_classes; c++) {
+			if (pool->srq[c] && ibv_destroy_srq(pool->srq[c]))
+				fprintf(stderr, "Couldn't destroy the SRQ of a receive class\n");
+		}
+	}
+	if (pool->mr && ibv_dereg_mr(pool->mr))
+		fprintf(stderr, "Couldn't deregister the receive pool\n");
+
+	free(pool->arena);
+	free(pool->sge);
+	free(pool->wr);
+	free(pool->srq);
+	free(pool->depth);
+	free(pool->stride);
+	free(pool->class_size);
+	free(pool);
+}
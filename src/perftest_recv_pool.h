@@ -0,0 +1,51 @@
+#ifndef PERFTEST_RECV_POOL_H
+#define PERFTEST_RECV_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <infiniband/verbs.h>
+
+/* A receive pool of size classes, an SRQ per class whose buffers are slabs
+ * of a single registered arena. A receive completes on the SRQ of the QP,
+ * so the senders pick the QP by the size class of the message.
+ */
+struct recv_pool {
+	int			num_classes;
+	uint64_t		*class_size;
+	uint64_t		*stride;	/* The buffer stride of the class, cache line aligned. */
+	int			*depth;
+	struct ibv_srq		**srq;
+	void			*arena;
+	size_t			arena_size;
+	struct ibv_mr		*mr;
+	int			num_slots;
+	struct ibv_sge		*sge;
+	struct ibv_recv_wr	*wr;
+};
+
+/*
+ * Allocate and register an arena of depth[c] buffers of class_size[c] bytes
+ * for each class, and an SRQ of depth[c] WQEs per class.
+ * The arena is registered on pd and the SRQs are created on srq_pd.
+ */
+int recv_pool_create(struct ibv_pd *pd, struct ibv_pd *srq_pd, int num_classes,
+		     const uint64_t *class_size, const int *depth, struct recv_pool **pool);
+
+/*
+ * Post all the buffers of the pool to the SRQs of their classes.
+ */
+int recv_pool_post(struct recv_pool *pool);
+
+/*
+ * Repost the buffer of a receive completion of the pool.
+ * Returns the class of the buffer, or -1 if the post failed.
+ */
+int recv_pool_repost(struct recv_pool *pool, const struct ibv_wc *wc);
+
+/*
+ * Destroy the SRQs, deregister and free the arena.
+ * The QPs attached to the SRQs must be destroyed first.
+ */
+void recv_pool_destroy(struct recv_pool *pool);
+
+#endif
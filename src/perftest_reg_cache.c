@@ -0,0 +1,296 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "perftest_reg_cache.h"
+
+struct reg_cache {
+	struct ibv_pd *pd;
+	int access;
+	int capacity;
+	int count;
+	uintptr_t page_size;
+	struct reg_cache_entry *root;
+	struct reg_cache_entry *head;
+	struct reg_cache_entry *tail;
+	struct reg_cache_stats stats;
+};
+
+/* The interval tree is an AVL tree ordered by the start of the registrations,
+ * each node keeps the highest end of its subtree to prune the lookups.
+ */
+static int entry_cmp(const struct reg_cache_entry *a, const struct reg_cache_entry *b)
+{
+	if (a->start != b->start)
+		return a->start < b->start ? -1 : 1;
+	if (a->end != b->end)
+		return a->end < b->end ? -1 : 1;
+	if (a != b)
+		return (uintptr_t)a < (uintptr_t)b ? -1 : 1;
+	return 0;
+}
+
+static inline int node_height(const struct reg_cache_entry *node)
+{
+	return node ? node->height : 0;
+}
+
+static void node_update(struct reg_cache_entry *node)
+{
+	int left = node_height(node->left), right = node_height(node->right);
+
+	node->height = 1 + (left > right ? left : right);
+	node->max_end = node->end;
+	if (node->left && node->left->max_end > node->max_end)
+		node->max_end = node->left->max_end;
+	if (node->right && node->right->max_end > node->max_end)
+		node->max_end = node->right->max_end;
+}
+
+static struct reg_cache_entry *rotate_right(struct reg_cache_entry *node)
+{
+	struct reg_cache_entry *left = node->left;
+
+	node->left = left->right;
+	left->right = node;
+	node_update(node);
+	node_update(left);
+	return left;
+}
+
+static struct reg_cache_entry *rotate_left(struct reg_cache_entry *node)
+{
+	struct reg_cache_entry *right = node->right;
+
+	node->right = right->left;
+	right->left = node;
+	node_update(node);
+	node_update(right);
+	return right;
+}
+
+static struct reg_cache_entry *node_balance(struct reg_cache_entry *node)
+{
+	int balance;
+
+	node_update(node);
+	balance = node_height(node->left) - node_height(node->right);
+
+	if (balance > 1) {
+		if (node_height(node->left->left) < node_height(node->left->right))
+			node->left = rotate_left(node->left);
+		return rotate_right(node);
+	}
+	if (balance < -1) {
+		if (node_height(node->right->right) < node_height(node->right->left))
+			node->right = rotate_right(node->right);
+		return rotate_left(node);
+	}
+	return node;
+}
+
+static struct reg_cache_entry *tree_insert(struct reg_cache_entry *root, struct reg_cache_entry *entry)
+{
+	if (!root) {
+		entry->left = entry->right = NULL;
+		node_update(entry);
+		return entry;
+	}
+
+	if (entry_cmp(entry, root) < 0)
+		root->left = tree_insert(root->left, entry);
+	else
+		root->right = tree_insert(root->right, entry);
+
+	return node_balance(root);
+}
+
+static struct reg_cache_entry *tree_remove_min(struct reg_cache_entry *root, struct reg_cache_entry **min)
+{
+	if (!root->left) {
+		*min = root;
+		return root->right;
+	}
+
+	root->left = tree_remove_min(root->left, min);
+	return node_balance(root);
+}
+
+static struct reg_cache_entry *tree_remove(struct reg_cache_entry *root, struct reg_cache_entry *entry)
+{
+	struct reg_cache_entry *min;
+	int cmp;
+
+	if (!root)
+		return NULL;
+
+	cmp = entry_cmp(entry, root);
+	if (cmp < 0) {
+		root->left = tree_remove(root->left, entry);
+	} else if (cmp > 0) {
+		root->right = tree_remove(root->right, entry);
+	} else {
+		if (!root->right)
+			return root->left;
+		min = NULL;
+		root->right = tree_remove_min(root->right, &min);
+		min->left = root->left;
+		min->right = root->right;
+		return node_balance(min);
+	}
+
+	return node_balance(root);
+}
+
+/* A registration covering [start, end), the subtrees ending before end are skipped. */
+static struct reg_cache_entry *tree_find(struct reg_cache_entry *root, uintptr_t start, uintptr_t end)
+{
+	struct reg_cache_entry *found;
+
+	if (!root || root->max_end < end)
+		return NULL;
+
+	found = tree_find(root->left, start, end);
+	if (found)
+		return found;
+
+	if (root->start > start)
+		return NULL;
+	if (root->end >= end)
+		return root;
+
+	return tree_find(root->right, start, end);
+}
+
+static void lru_unlink(struct reg_cache *cache, struct reg_cache_entry *entry)
+{
+	if (entry->prev)
+		entry->prev->next = entry->next;
+	else
+		cache->head = entry->next;
+	if (entry->next)
+		entry->next->prev = entry->prev;
+	else
+		cache->tail = entry->prev;
+	entry->prev = entry->next = NULL;
+}
+
+static void lru_push_front(struct reg_cache *cache, struct reg_cache_entry *entry)
+{
+	entry->prev = NULL;
+	entry->next = cache->head;
+	if (cache->head)
+		cache->head->prev = entry;
+	else
+		cache->tail = entry;
+	cache->head = entry;
+}
+
+static void entry_release(struct reg_cache *cache, struct reg_cache_entry *entry)
+{
+	lru_unlink(cache, entry);
+	if (entry->in_tree)
+		cache->root = tree_remove(cache->root, entry);
+	if (ibv_dereg_mr(entry->mr))
+		fprintf(stderr, "Failed to deregister a cached MR\n");
+	free(entry);
+	cache->count--;
+}
+
+/* Evicts the least recently used registrations not in use, down to the capacity. */
+static void cache_evict(struct reg_cache *cache)
+{
+	struct reg_cache_entry *entry = cache->tail, *prev;
+
+	while (entry && cache->count > cache->capacity) {
+		prev = entry->prev;
+		if (!entry->refcnt) {
+			entry_release(cache, entry);
+			cache->stats.evictions++;
+		}
+		entry = prev;
+	}
+}
+
+int reg_cache_create(struct ibv_pd *pd, int access, int capacity, struct reg_cache **cache)
+{
+	struct reg_cache *new_cache;
+
+	new_cache = calloc(1, sizeof(*new_cache));
+	if (!new_cache)
+		return 1;
+
+	new_cache->pd = pd;
+	new_cache->access = access;
+	new_cache->capacity = capacity;
+	new_cache->page_size = sysconf(_SC_PAGESIZE);
+	*cache = new_cache;
+	return 0;
+}
+
+struct reg_cache_entry *reg_cache_get(struct reg_cache *cache, void *addr, size_t len)
+{
+	uintptr_t start = (uintptr_t)addr & ~(cache->page_size - 1);
+	uintptr_t end = ((uintptr_t)addr + len + cache->page_size - 1) & ~(cache->page_size - 1);
+	struct reg_cache_entry *entry;
+
+	if (cache->capacity) {
+		entry = tree_find(cache->root, start, end);
+		if (entry) {
+			cache->stats.hits++;
+			entry->refcnt++;
+			lru_unlink(cache, entry);
+			lru_push_front(cache, entry);
+			return entry;
+		}
+	}
+	cache->stats.misses++;
+
+	entry = calloc(1, sizeof(*entry));
+	if (!entry)
+		return NULL;
+
+	entry->mr = ibv_reg_mr(cache->pd, (void*)start, end - start, cache->access);
+	if (!entry->mr) {
+		fprintf(stderr, "Couldn't register a %lu bytes MR for the cache\n", (unsigned long)(end - start));
+		free(entry);
+		return NULL;
+	}
+	entry->start = start;
+	entry->end = end;
+	entry->refcnt = 1;
+	lru_push_front(cache, entry);
+	cache->count++;
+
+	if (cache->capacity) {
+		cache->root = tree_insert(cache->root, entry);
+		entry->in_tree = 1;
+		cache_evict(cache);
+	}
+
+	return entry;
+}
+
+void reg_cache_put(struct reg_cache *cache, struct reg_cache_entry *entry)
+{
+	if (--entry->refcnt)
+		return;
+
+	if (!cache->capacity)
+		entry_release(cache, entry);
+	else if (cache->count > cache->capacity)
+		cache_evict(cache);
+}
+
+const struct reg_cache_stats *reg_cache_get_stats(struct reg_cache *cache)
+{
+	return &cache->stats;
+}
+
+void reg_cache_destroy(struct reg_cache *cache)
+{
+	while (cache->head)
+		entry_release(cache, cache->head);
+
+	free(cache);
+}
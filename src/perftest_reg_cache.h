@@ -0,0 +1,61 @@
+#ifndef PERFTEST_REG_CACHE_H
+#define PERFTEST_REG_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <infiniband/verbs.h>
+
+struct reg_cache;
+
+/* A registration of the cache, valid until reg_cache_put releases it. */
+struct reg_cache_entry {
+	struct ibv_mr *mr;
+	uintptr_t start;
+	uintptr_t end;
+	int refcnt;
+	/* interval tree */
+	struct reg_cache_entry *left;
+	struct reg_cache_entry *right;
+	uintptr_t max_end;
+	int height;
+	int in_tree;
+	/* LRU list, the most recently used first */
+	struct reg_cache_entry *prev;
+	struct reg_cache_entry *next;
+};
+
+struct reg_cache_stats {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+};
+
+/*
+ * Allocate a registration cache of up to capacity registrations of pd.
+ * A capacity of 0 caches nothing: each get registers and the last put deregisters.
+ */
+int reg_cache_create(struct ibv_pd *pd, int access, int capacity, struct reg_cache **cache);
+
+/*
+ * Get a registration covering [addr, addr + len), page aligned, registering it on a miss.
+ * Evicts the least recently used registrations not in use above the capacity.
+ * Returns NULL if the registration failed.
+ */
+struct reg_cache_entry *reg_cache_get(struct reg_cache *cache, void *addr, size_t len);
+
+/*
+ * Release a registration returned by reg_cache_get.
+ */
+void reg_cache_put(struct reg_cache *cache, struct reg_cache_entry *entry);
+
+/*
+ * The hits, misses and evictions since the cache was created.
+ */
+const struct reg_cache_stats *reg_cache_get_stats(struct reg_cache *cache);
+
+/*
+ * Deregister all the registrations and free the cache.
+ */
+void reg_cache_destroy(struct reg_cache *cache);
+
+#endif
@@ -27,6 +27,8 @@
 #endif
 
 #include "perftest_resources.h"
+#include "perftest_crc32c.h"
+#include "perftest_counters.h"
 #include "raw_ethernet_resources.h"
 
 static enum ibv_wr_opcode opcode_verbs_array[] = {IBV_WR_SEND,IBV_WR_RDMA_WRITE,IBV_WR_RDMA_WRITE_WITH_IMM,IBV_WR_RDMA_READ};
@@ -243,6 +245,25 @@ static void get_cpu_stats(struct perftest_parameters *duration_param,int stat_in
 	}
 }
 
+/* set_remote_pattern_addr.
+ *
+ * Description :
+ *
+ *	Moves the WR of a QP to the remote offset of message scnt in the
+ *	precomputed --remote_pattern sequence.
+ *
+ */
+static inline void set_remote_pattern_addr(struct pingpong_context *ctx, int index, uint64_t scnt)
+{
+	uint64_t addr = ctx->rem_addr[index] +
+		ctx->rem_pattern[index * (ctx->rem_pattern_mask + 1) + (scnt & ctx->rem_pattern_mask)];
+
+	if (ctx->wr[index].opcode == IBV_WR_ATOMIC_FETCH_AND_ADD || ctx->wr[index].opcode == IBV_WR_ATOMIC_CMP_AND_SWP)
+		ctx->wr[index].wr.atomic.remote_addr = addr;
+	else
+		ctx->wr[index].wr.rdma.remote_addr = addr;
+}
+
 /* _new_post_send.
  *
  * Description :
@@ -428,7 +449,7 @@ static inline int _new_post_send(struct pingpong_context *ctx,
 			ibv_wr_set_inline_data(
 				ctx->qpx[index],
 				(void*) wr->sg_list->addr,
-				user_param->size);
+				wr->sg_list->length);
 		}
 		else
 		{
@@ -442,11 +463,14 @@ static inline int _new_post_send(struct pingpong_context *ctx,
 			}
 			else
 			#endif
+			if (wr->num_sge > 1)
+				ibv_wr_set_sge_list(ctx->qpx[index], wr->num_sge, wr->sg_list);
+			else
 			ibv_wr_set_sge(
 				ctx->qpx[index],
 				wr->sg_list->lkey,
 				wr->sg_list->addr,
-				user_param->size);
+				wr->sg_list->length);
 		}
 		wr = wr->next;
 	}
@@ -539,6 +563,13 @@ static int new_post_write_sge_rc(struct pingpong_context *ctx, int index,
 	return _new_post_send(ctx, user_param, 0, index, IBV_QPT_RC, opcode_verbs_array[user_param->verb], RC, 0);
 }
 
+/* The opcode of --verb_mix is set per post in the WR. */
+static int new_post_mixed_sge_rc(struct pingpong_context *ctx, int index,
+	struct perftest_parameters *user_param)
+{
+	return _new_post_send(ctx, user_param, 0, index, IBV_QPT_RC, ctx->wr[index * user_param->post_list].opcode, RC, 0);
+}
+
 static int new_post_write_sge_enc_rc(struct pingpong_context *ctx, int index,
 	struct perftest_parameters *user_param)
 {
@@ -987,6 +1018,7 @@ struct ibv_device* ctx_find_dev(char **ib_devname)
 struct ibv_context* ctx_open_device(struct ibv_device *ib_dev, struct perftest_parameters *user_param)
 {
 	struct ibv_context *context;
+	cycles_t phase_start = get_cycles();
 
 #ifdef HAVE_AES_XTS
 	if(user_param->aes_xts){
@@ -1013,6 +1045,7 @@ struct ibv_context* ctx_open_device(struct ibv_device *ib_dev, struct perftest_p
 			return NULL;
 		}
 
+		setup_phase_add(SETUP_REPORT(user_param), SETUP_PHASE_OPEN_DEVICE, phase_start);
 		return context;
 	}
 #endif
@@ -1024,8 +1057,64 @@ struct ibv_context* ctx_open_device(struct ibv_device *ib_dev, struct perftest_p
 		return NULL;
 	}
 
+	setup_phase_add(SETUP_REPORT(user_param), SETUP_PHASE_OPEN_DEVICE, phase_start);
 	return context;
 }
+/* set_sge_layout.
+ *
+ * Description :
+ *
+ *	Splits a message of size bytes to the num_sge SGEs of a --sge WR, by
+ *	--sge_sizes or evenly with the remainder on the last SGE. The addresses
+ *	are offsets from the first SGE: back to back for the contiguous layout,
+ *	otherwise each SGE starts on a new page with a page gap after the previous.
+ *
+ * Return Value : The span of the SGEs in the buffer.
+ *
+ */
+static uint64_t set_sge_layout(struct perftest_parameters *user_param, int num_sge,
+		uint64_t size, struct ibv_sge *sge)
+{
+	uint64_t offset = 0;
+	int i;
+
+	for (i = 0; i < num_sge; i++) {
+		if (num_sge == user_param->sge && user_param->sge_sizes[0])
+			sge[i].length = user_param->sge_sizes[i];
+		else
+			sge[i].length = (i < num_sge - 1) ? size / num_sge : size - (size / num_sge) * (num_sge - 1);
+
+		if (i > 0 && user_param->sge_layout != SGE_CONTIGUOUS)
+			offset = ROUND_UP(offset, DEF_PAGE_SIZE) + DEF_PAGE_SIZE;
+		sge[i].addr = offset;
+		offset += sge[i].length;
+	}
+
+	return offset;
+}
+
+/* set_sge_list.
+ *
+ * Description :
+ *
+ *	Lays the SGEs of a --sge WR of a QP out from the address of its single SGE,
+ *	with the lkeys of the separate MRs in the mr layout.
+ *
+ */
+static void set_sge_list(struct pingpong_context *ctx, struct perftest_parameters *user_param,
+		int qp_index, struct ibv_sge *base, struct ibv_sge *sge_list)
+{
+	int mr_index = user_param->mr_per_qp ? qp_index : 0;
+	int i;
+
+	set_sge_layout(user_param, user_param->num_sge, user_param->size, sge_list);
+	for (i = 0; i < user_param->num_sge; i++) {
+		sge_list[i].addr += base->addr;
+		sge_list[i].lkey = (i > 0 && ctx->sge_mr) ?
+			ctx->sge_mr[mr_index * user_param->sge + i]->lkey : base->lkey;
+	}
+}
+
 /******************************************************************************
  *
  ******************************************************************************/
@@ -1073,6 +1162,10 @@ int alloc_ctx(struct pingpong_context *ctx,struct perftest_parameters *user_para
 		ALLOC(ctx->ccnt,uint64_t,user_param->num_of_qps);
 		memset(ctx->scnt, 0, user_param->num_of_qps * sizeof (uint64_t));
 		memset(ctx->ccnt, 0, user_param->num_of_qps * sizeof (uint64_t));
+		if (user_param->object_size) {
+			ALLOC(user_param->object_cycles, cycles_t, user_param->iters);
+			ALLOC(user_param->object_tail_cycles, cycles_t, user_param->iters);
+		}
 
 	} else if ((user_param->tst == BW || user_param->tst == LAT_BY_BW)
 		   && (user_param->verb == SEND || user_param->verb == WRITE_IMM) && user_param->machine == SERVER) {
@@ -1086,8 +1179,22 @@ int alloc_ctx(struct pingpong_context *ctx,struct perftest_parameters *user_para
 
 	if (user_param->machine == CLIENT || user_param->tst == LAT || user_param->duplex) {
 
-		ALLOC(ctx->sge_list, struct ibv_sge,user_param->num_of_qps * user_param->post_list);
-		ALLOC(ctx->wr, struct ibv_send_wr, user_param->num_of_qps * user_param->post_list);
+		/* --autotune tries post lists up to AUTOTUNE_MAX_POST_LIST on the same WRs. */
+		int max_post_list = user_param->autotune ? AUTOTUNE_MAX_POST_LIST : user_param->post_list;
+
+		ALLOC(ctx->sge_list, struct ibv_sge,user_param->num_of_qps * max_post_list);
+		ALLOC(ctx->wr, struct ibv_send_wr, user_param->num_of_qps * max_post_list);
+		if (user_param->sge > 1)
+			ALLOC(ctx->gather_sge_list, struct ibv_sge, user_param->num_of_qps * user_param->sge);
+		if (user_param->remote_pattern) {
+			uint64_t len = 1;
+
+			/* The sequence is a power of 2 to wrap with a mask, it repeats beyond it. */
+			while (len < user_param->iters && len < REMOTE_PATTERN_MAX_LEN)
+				len <<= 1;
+			ctx->rem_pattern_mask = len - 1;
+			ALLOC(ctx->rem_pattern, uint64_t, user_param->num_of_qps * len);
+		}
 		ALLOC(ctx->rem_qpn, uint32_t, user_param->num_of_qps);
 		if ((user_param->verb == SEND && user_param->connection_type == UD) ||
 				user_param->connection_type == DC || user_param->connection_type == SRD) {
@@ -1103,12 +1210,73 @@ int alloc_ctx(struct pingpong_context *ctx,struct perftest_parameters *user_para
 		ALLOC(ctx->rwr, struct ibv_recv_wr,
 			 user_param->num_of_qps * user_param->recv_post_list);
 		ALLOC(ctx->rx_buffer_addr, uint64_t, user_param->num_of_qps);
+		if (user_param->sge > 1)
+			ALLOC(ctx->scatter_sge_list, struct ibv_sge, user_param->num_of_qps * user_param->sge);
+		if ((user_param->verify || user_param->copy_mode != COPY_MODE_NONE || (user_param->touch & TOUCH_RX_READ) ||
+				user_param->seq_track) && user_param->verb == SEND) {
+			ALLOC(ctx->rx_posted_addr, uint64_t, user_param->num_of_qps * user_param->rx_depth);
+			ALLOC(ctx->rx_posted_cnt, uint64_t, user_param->num_of_qps);
+			memset(ctx->rx_posted_cnt, 0, user_param->num_of_qps * sizeof(uint64_t));
+		}
+	}
+	if (user_param->reg_mode != REG_MODE_STATIC) {
+		ALLOC(ctx->reg_inflight, struct reg_cache_entry*, user_param->num_of_qps * user_param->tx_depth);
+		memset(ctx->reg_inflight, 0, user_param->num_of_qps * user_param->tx_depth * sizeof(struct reg_cache_entry*));
+	}
+	if (user_param->sge > 1 && user_param->sge_layout == SGE_MR) {
+		ALLOC(ctx->sge_mr, struct ibv_mr*, user_param->num_of_qps * user_param->sge);
+		memset(ctx->sge_mr, 0, user_param->num_of_qps * user_param->sge * sizeof(struct ibv_mr*));
 	}
 	if (user_param->mac_fwd == ON )
 		ctx->cycle_buffer = user_param->size * user_param->rx_depth;
 
+	/* A slot per receive, so no posted receive lands on a message before it is checked. */
+	if (user_param->verify && user_param->verb == SEND)
+		ctx->cycle_buffer = INC(user_param->size, ctx->cache_line_size) * user_param->rx_depth;
+
+	/* Also a slot per outstanding send, so no stamp is rewritten before the message is sent.
+	 * A forwarder sends the frames where they were received.
+	 */
+	if (user_param->seq_track && !user_param->mac_fwd) {
+		uint64_t seq_buffer = INC(SIZE(user_param->connection_type, user_param->size, 1), ctx->cache_line_size) *
+			((user_param->rx_depth > user_param->tx_depth) ? user_param->rx_depth : user_param->tx_depth);
+
+		if (seq_buffer > ctx->cycle_buffer)
+			ctx->cycle_buffer = seq_buffer;
+	}
+
+	/* --copy_mode, --touch=tx_write and --verify write a message into its slot right
+	 * before the post, so each outstanding send needs a slot the NIC isn't still reading.
+	 */
+	if (user_param->copy_mode != COPY_MODE_NONE || (user_param->touch & TOUCH_TX_WRITE) ||
+			(user_param->verify && user_param->verb != READ)) {
+		uint64_t tx_buffer = INC(user_param->size, ctx->cache_line_size) * user_param->tx_depth;
+
+		if (tx_buffer > ctx->cycle_buffer)
+			ctx->cycle_buffer = tx_buffer;
+	}
+
+	/* --working_set is the whole buffer of a side, both halves of each QP walk their share. */
+	if (user_param->working_set) {
+		uint64_t qp_share = user_param->working_set / (2 * user_param->num_of_qps * user_param->flows);
+
+		qp_share -= qp_share % user_param->cycle_buffer;
+		if (qp_share > ctx->cycle_buffer)
+			ctx->cycle_buffer = qp_share;
+	}
+
 	ctx->size = user_param->size;
 
+	if (user_param->remote_region > ctx->size)
+		ctx->size = user_param->remote_region;
+
+	/* The SGEs on separate pages span more than the message, on both sides alike. */
+	if (user_param->sge > 1 && user_param->sge_layout != SGE_CONTIGUOUS) {
+		struct ibv_sge layout[MAX_SGE_NUM];
+
+		ctx->size = set_sge_layout(user_param, user_param->sge, user_param->size, layout);
+	}
+
 	num_of_qps_factor = (user_param->mr_per_qp) ? 1 : user_param->num_of_qps;
 
 	/* holds the size of maximum between msg size and cycle buffer,
@@ -1140,6 +1308,11 @@ void dealloc_ctx(struct pingpong_context *ctx,struct perftest_parameters *user_p
 	if (user_param->tposted != NULL)
 		free(user_param->tposted);
 
+	if (user_param->object_cycles != NULL) {
+		free(user_param->object_cycles);
+		free(user_param->object_tail_cycles);
+	}
+
 	if (((user_param->tst == LAT || user_param->tst == FS_RATE) && user_param->test_type == DURATION) ||
 		((user_param->tst == BW || user_param->tst == LAT_BY_BW) && (user_param->machine == CLIENT || user_param->duplex)) ||
 		((user_param->tst == BW || user_param->tst == LAT_BY_BW) && user_param->verb == SEND && user_param->machine == SERVER) ||
@@ -1193,6 +1366,10 @@ void dealloc_ctx(struct pingpong_context *ctx,struct perftest_parameters *user_p
 	if (user_param->machine == CLIENT || user_param->tst == LAT || user_param->duplex) {
 		if (ctx->sge_list != NULL)
 			free(ctx->sge_list);
+		if (ctx->gather_sge_list != NULL)
+			free(ctx->gather_sge_list);
+		if (ctx->rem_pattern != NULL)
+			free(ctx->rem_pattern);
 		if (ctx->wr != NULL)
 			free(ctx->wr);
 		if (ctx->rem_qpn != NULL)
@@ -1211,18 +1388,191 @@ void dealloc_ctx(struct pingpong_context *ctx,struct perftest_parameters *user_p
 	if ((user_param->verb == SEND || user_param->verb == WRITE_IMM) && (user_param->tst == LAT || user_param->machine == SERVER || user_param->duplex)) {
 		if (ctx->recv_sge_list != NULL)
 			free(ctx->recv_sge_list);
+		if (ctx->scatter_sge_list != NULL)
+			free(ctx->scatter_sge_list);
 		if (ctx->rwr != NULL)
 			free(ctx->rwr);
 		if (ctx->rx_buffer_addr != NULL)
 			free(ctx->rx_buffer_addr);
+		if (ctx->rx_posted_addr != NULL)
+			free(ctx->rx_posted_addr);
+		if (ctx->rx_posted_cnt != NULL)
+			free(ctx->rx_posted_cnt);
 	}
 
+	if (ctx->reg_inflight != NULL)
+		free(ctx->reg_inflight);
+
 	if (ctx->memory != NULL) {
 		ctx->memory->destroy(ctx->memory);
 		ctx->memory = NULL;
 	}
 }
 
+/******************************************************************************
+ *
+ ******************************************************************************/
+typedef int (*qp_worker_func)(struct pingpong_context *ctx,
+		struct perftest_parameters *user_param, void *arg, int qp_index);
+
+struct qp_worker {
+	pthread_t			thread;
+	struct pingpong_context		*ctx;
+	struct perftest_parameters	*user_param;
+	qp_worker_func			func;
+	void				*arg;
+	int				first;
+	int				last;
+	int				stop_on_error;
+	int				started;
+	int				result;
+};
+
+static void *qp_worker_run(void *data)
+{
+	struct qp_worker *worker = (struct qp_worker*)data;
+	int i;
+
+	for (i = worker->first; i < worker->last; i++) {
+		if (worker->func(worker->ctx, worker->user_param, worker->arg, i)) {
+			worker->result = FAILURE;
+			if (worker->stop_on_error)
+				break;
+		}
+	}
+
+	return NULL;
+}
+
+/* run_qp_workers.
+ *
+ * Description :
+ *
+ *  Calls func for every index in [first, last). The range is split into
+ *  contiguous shards, one per thread of the --qp_threads pool. The QP
+ *  control path of the RDMA CM flow stays on the calling thread.
+ *
+ * Return Value : SUCCESS, FAILURE if func failed for any index.
+ */
+static int run_qp_workers(struct pingpong_context *ctx,
+		struct perftest_parameters *user_param,
+		qp_worker_func func, void *arg, int first, int last, int stop_on_error)
+{
+	struct qp_worker *workers;
+	int num_of_qps = last - first;
+	int num_threads = user_param->qp_threads;
+	int i, shard, extra, result = SUCCESS;
+
+	if (num_of_qps <= 0)
+		return SUCCESS;
+
+	if (num_threads > num_of_qps)
+		num_threads = num_of_qps;
+
+	if (num_threads < 1 || user_param->work_rdma_cm == ON)
+		num_threads = 1;
+
+	workers = calloc(num_threads, sizeof(struct qp_worker));
+	if (!workers) {
+		fprintf(stderr, "Failed to allocate QP workers\n");
+		return FAILURE;
+	}
+
+	shard = num_of_qps / num_threads;
+	extra = num_of_qps % num_threads;
+	for (i = 0; i < num_threads; i++) {
+		workers[i].ctx = ctx;
+		workers[i].user_param = user_param;
+		workers[i].func = func;
+		workers[i].arg = arg;
+		workers[i].stop_on_error = stop_on_error;
+		workers[i].first = first + i * shard + (i < extra ? i : extra);
+		workers[i].last = workers[i].first + shard + (i < extra ? 1 : 0);
+	}
+
+	for (i = 1; i < num_threads; i++) {
+		if (pthread_create(&workers[i].thread, NULL, qp_worker_run, &workers[i]) == 0)
+			workers[i].started = 1;
+		else
+			qp_worker_run(&workers[i]);
+	}
+
+	qp_worker_run(&workers[0]);
+
+	for (i = 0; i < num_threads; i++) {
+		if (workers[i].started)
+			pthread_join(workers[i].thread, NULL);
+		if (workers[i].result)
+			result = FAILURE;
+	}
+
+	free(workers);
+	return result;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static int destroy_ctx_qp(struct pingpong_context *ctx,
+		struct perftest_parameters *user_param, void *arg, int i)
+{
+	int test_result = 0;
+	int num_of_qps = user_param->num_of_qps;
+
+	/* in dc with bidirectional,
+	 * there are send qps and recv qps. the actual number of send/recv qps
+	 * is num_of_qps / 2.
+	 */
+	if (user_param->duplex || user_param->tst == LAT) {
+		num_of_qps /= 2;
+	}
+
+	if ((((user_param->connection_type == DC && !((!(user_param->duplex || user_param->tst == LAT) && user_param->machine == SERVER)
+						|| ((user_param->duplex || user_param->tst == LAT) && i >= num_of_qps))) ||
+				user_param->connection_type == UD || user_param->connection_type == SRD) &&
+			(user_param->tst == LAT || user_param->machine == CLIENT || user_param->duplex)) ||
+			(user_param->connection_type == SRD && (user_param->verb == READ || user_param->verb == WRITE || user_param->verb == WRITE_IMM))) {
+
+		if (user_param->ah_allocated == 1 && ibv_destroy_ah(ctx->ah[i])) {
+			fprintf(stderr, "Failed to destroy AH\n");
+			test_result = 1;
+		}
+	}
+	if (user_param->work_rdma_cm == OFF) {
+		if (ibv_destroy_qp(ctx->qp[i])) {
+			fprintf(stderr, "Couldn't destroy QP - %s\n", strerror(errno));
+			test_result = 1;
+		}
+	}
+
+	return test_result;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static void print_qp_rate_report(struct perftest_parameters *user_param,
+		cycles_t destroy_cycles)
+{
+	double cycles_to_msec = get_cpu_mhz(user_param->cpu_freq_f) * 1000;
+	int num_threads = user_param->qp_threads < user_param->num_of_qps ?
+		user_param->qp_threads : user_param->num_of_qps;
+	const char *phase[] = {"create+INIT", "connect RTR/RTS", "destroy"};
+	cycles_t cycles[] = {user_param->qp_create_cycles,
+		user_param->qp_connect_cycles, destroy_cycles};
+	double msec;
+	int i;
+
+	printf(RESULT_LINE);
+	printf("%s\n", RESULT_FMT_QP_RATE);
+	for (i = 0; i < 3; i++) {
+		msec = cycles[i] / cycles_to_msec;
+		printf(REPORT_FMT_QP_RATE, phase[i], num_threads, user_param->num_of_qps,
+			msec, msec > 0 ? user_param->num_of_qps * 1000 / msec : 0);
+	}
+	printf(RESULT_LINE);
+}
+
 /******************************************************************************
  *
  ******************************************************************************/
@@ -1231,7 +1581,7 @@ int destroy_ctx(struct pingpong_context *ctx,
 {
 	int i, dereg_counter, rc;
 	int test_result = 0;
-	int num_of_qps = user_param->num_of_qps;
+	cycles_t start_cycles, phase_start;
 	int dct_only = (user_param->machine == SERVER && !(user_param->duplex || user_param->tst == LAT));
 
 	if (user_param->wait_destroy) {
@@ -1240,6 +1590,7 @@ int destroy_ctx(struct pingpong_context *ctx,
 		sleep(user_param->wait_destroy);
 	}
 
+	phase_start = get_cycles();
 	dereg_counter = (user_param->mr_per_qp) ? user_param->num_of_qps : 1;
 
 	if (user_param->work_rdma_cm == ON) {
@@ -1253,34 +1604,13 @@ int destroy_ctx(struct pingpong_context *ctx,
 	if (user_param->work_rdma_cm == ON)
 		rdma_disconnect(ctx->cm_id);
 
-	/* in dc with bidirectional,
-	 * there are send qps and recv qps. the actual number of send/recv qps
-	 * is num_of_qps / 2.
-	 */
-	if (user_param->duplex || user_param->tst == LAT) {
-		num_of_qps /= 2;
-	}
-
-	for (i = 0; i < user_param->num_of_qps; i++) {
+	start_cycles = get_cycles();
 
-		if ((((user_param->connection_type == DC && !((!(user_param->duplex || user_param->tst == LAT) && user_param->machine == SERVER)
-							|| ((user_param->duplex || user_param->tst == LAT) && i >= num_of_qps))) ||
-					user_param->connection_type == UD || user_param->connection_type == SRD) &&
-				(user_param->tst == LAT || user_param->machine == CLIENT || user_param->duplex)) ||
-				(user_param->connection_type == SRD && (user_param->verb == READ || user_param->verb == WRITE || user_param->verb == WRITE_IMM))) {
+	if (run_qp_workers(ctx, user_param, destroy_ctx_qp, NULL, 0, user_param->num_of_qps, 0))
+		test_result = 1;
 
-			if (user_param->ah_allocated == 1 && ibv_destroy_ah(ctx->ah[i])) {
-				fprintf(stderr, "Failed to destroy AH\n");
-				test_result = 1;
-			}
-		}
-		if (user_param->work_rdma_cm == OFF) {
-			if (ibv_destroy_qp(ctx->qp[i])) {
-				fprintf(stderr, "Couldn't destroy QP - %s\n", strerror(errno));
-				test_result = 1;
-			}
-		}
-	}
+	if (user_param->report_qp_rate && user_param->work_rdma_cm == OFF)
+		print_qp_rate_report(user_param, get_cycles() - start_cycles);
 
 	if (user_param->srq_exists) {
 		if (ibv_destroy_srq(ctx->srq)) {
@@ -1289,6 +1619,11 @@ int destroy_ctx(struct pingpong_context *ctx,
 		}
 	}
 
+	if (ctx->recv_pool) {
+		recv_pool_destroy(ctx->recv_pool);
+		ctx->recv_pool = NULL;
+	}
+
 	#ifdef HAVE_XRCD
 	if (user_param->use_xrc) {
 
@@ -1317,6 +1652,21 @@ int destroy_ctx(struct pingpong_context *ctx,
 			}
 	}
 
+	if (ctx->sge_mr) {
+		for (i = 0; i < dereg_counter * user_param->sge; i++) {
+			if (ctx->sge_mr[i] && ibv_dereg_mr(ctx->sge_mr[i])) {
+				fprintf(stderr, "Failed to deregister SGE MR #%d\n", i+1);
+				test_result = 1;
+			}
+		}
+		free(ctx->sge_mr);
+	}
+
+	if (ctx->reg_cache) {
+		reg_cache_destroy(ctx->reg_cache);
+		ctx->reg_cache = NULL;
+	}
+
 	for (i = 0; i < dereg_counter; i++) {
 		if (ibv_dereg_mr(ctx->mr[i])) {
 			fprintf(stderr, "Failed to deregister MR #%d\n", i+1);
@@ -1393,6 +1743,11 @@ int destroy_ctx(struct pingpong_context *ctx,
 		ctx->memory->free_buffer(ctx->memory, 0, ctx->buf[i], ctx->buff_size);
 	}
 
+	free(ctx->copy_buf);
+	ctx->copy_buf = NULL;
+	free(ctx->reg_pool_buf);
+	ctx->reg_pool_buf = NULL;
+
 	free(ctx->qp);
 	#ifdef HAVE_IBV_WR_API
 	free(ctx->qpx);
@@ -1426,6 +1781,8 @@ int destroy_ctx(struct pingpong_context *ctx,
 	if (user_param->machine == CLIENT || user_param->tst == LAT || user_param->duplex) {
 
 		free(ctx->sge_list);
+		free(ctx->gather_sge_list);
+		free(ctx->rem_pattern);
 		free(ctx->wr);
 	}
 
@@ -1433,6 +1790,7 @@ int destroy_ctx(struct pingpong_context *ctx,
 
 		free(ctx->rx_buffer_addr);
 		free(ctx->recv_sge_list);
+		free(ctx->scatter_sge_list);
 		free(ctx->rwr);
 	}
 
@@ -1444,11 +1802,20 @@ int destroy_ctx(struct pingpong_context *ctx,
 		counters_close(user_param->counter_ctx);
 	}
 
+	if (user_param->perf_events_ctx) {
+		perf_events_close(user_param->perf_events_ctx);
+	}
+
 	if (ctx->memory != NULL) {
 		ctx->memory->destroy(ctx->memory);
 		ctx->memory = NULL;
 	}
 
+	if (user_param->report_setup) {
+		setup_phase_add(&user_param->setup, SETUP_PHASE_DESTROY, phase_start);
+		print_report_setup(user_param);
+	}
+
 	return test_result;
 }
 
@@ -1666,6 +2033,558 @@ int create_cqs(struct pingpong_context *ctx, struct perftest_parameters *user_pa
 	return ret;
 }
 
+/******************************************************************************
+ *
+ ******************************************************************************/
+struct buf_init_chunk {
+	pthread_t			thread;
+	struct perftest_parameters	*user_param;
+	char				*buf;
+	uint64_t			offset;	/* Of the chunk in the buffer, the phase of the pattern. */
+	uint64_t			size;
+	uint64_t			seed;
+};
+
+/* Four independent xorshift lanes per step, so the compiler can keep them in
+ * vector registers, an order of magnitude faster than perftest_rand per word.
+ */
+static void fill_random_chunk(struct buf_init_chunk *chunk)
+{
+	uint64_t lanes[4];
+	uint64_t *words = (uint64_t*)chunk->buf;
+	uint64_t num_words = chunk->size / sizeof(uint64_t);
+	uint64_t i;
+	int k;
+
+	for (k = 0; k < 4; k++)
+		lanes[k] = (chunk->seed + (k + 1) * 0x9E3779B97F4A7C15ULL) | 1;
+
+	for (i = 0; i + 4 <= num_words; i += 4) {
+		for (k = 0; k < 4; k++) {
+			lanes[k] ^= lanes[k] << 13;
+			lanes[k] ^= lanes[k] >> 7;
+			lanes[k] ^= lanes[k] << 17;
+			words[i + k] = lanes[k];
+		}
+	}
+	for (; i < num_words; i++)
+		words[i] = xorshift64s(&lanes[0]);
+	for (i = num_words * sizeof(uint64_t); i < chunk->size; i++)
+		chunk->buf[i] = (char)xorshift64s(&lanes[1]);
+}
+
+/* Writes one period of the payload in the phase of the chunk and doubles it. */
+static void fill_pattern_chunk(struct buf_init_chunk *chunk)
+{
+	struct perftest_parameters *user_param = chunk->user_param;
+	uint64_t period = user_param->payload_length;
+	uint64_t filled;
+
+	for (filled = 0; filled < period && filled < chunk->size; filled++)
+		chunk->buf[filled] = user_param->payload_content[(chunk->offset + filled) % period];
+
+	while (filled < chunk->size) {
+		uint64_t len = (filled < chunk->size - filled) ? filled : chunk->size - filled;
+
+		memcpy(chunk->buf + filled, chunk->buf, len);
+		filled += len;
+	}
+}
+
+static void *buf_init_worker(void *arg)
+{
+	struct buf_init_chunk *chunk = arg;
+	long page_size = sysconf(_SC_PAGESIZE);
+	uint64_t i;
+
+	switch (chunk->user_param->buf_init) {
+	case BUF_INIT_RANDOM:
+		fill_random_chunk(chunk);
+		break;
+	case BUF_INIT_PATTERN:
+		fill_pattern_chunk(chunk);
+		break;
+	case BUF_INIT_NONE:
+		/* Only fault the pages in, writable, keeping the content. */
+		for (i = 0; i < chunk->size; i += page_size)
+			((volatile char*)chunk->buf)[i] = ((volatile char*)chunk->buf)[i];
+		break;
+	default:
+		memset(chunk->buf, 0, chunk->size);
+		break;
+	}
+
+	return NULL;
+}
+
+/* init_buffer.
+ *
+ * Description :
+ *
+ *	Fills the buffer according to --buf_init, faulting its pages in before
+ *	the registration. Large buffers are split in page aligned chunks which
+ *	are filled by up to BUF_INIT_MAX_THREADS threads.
+ *
+ * Parameters :
+ *
+ *	user_param - the perftest parameters.
+ *	buf        - the host buffer.
+ *	size       - the size of the buffer.
+ *
+ * Return Value : SUCCESS, FAILURE.
+ */
+static int init_buffer(struct perftest_parameters *user_param, void *buf, uint64_t size)
+{
+	struct buf_init_chunk chunks[BUF_INIT_MAX_THREADS];
+	uint64_t page_size = sysconf(_SC_PAGESIZE);
+	uint64_t chunk_size, seed = 0;
+	uint32_t rng_state;
+	long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	int num_chunks, started, i, ret = SUCCESS;
+
+	num_chunks = size / BUF_INIT_MIN_CHUNK;
+	if (num_chunks > num_cpus)
+		num_chunks = num_cpus;
+	if (num_chunks > BUF_INIT_MAX_THREADS)
+		num_chunks = BUF_INIT_MAX_THREADS;
+	if (num_chunks < 1)
+		num_chunks = 1;
+	chunk_size = ((size / num_chunks + page_size - 1) / page_size) * page_size;
+
+	if (user_param->buf_init == BUF_INIT_RANDOM) {
+		rng_state = init_perftest_rand_state();
+		seed = ((uint64_t)perftest_rand(&rng_state) << 32) | perftest_rand(&rng_state);
+	}
+
+	for (i = 0; i < num_chunks; i++) {
+		chunks[i].user_param = user_param;
+		chunks[i].offset = i * chunk_size;
+		chunks[i].buf = (char*)buf + chunks[i].offset;
+		chunks[i].size = (chunks[i].offset >= size) ? 0 :
+				 (size - chunks[i].offset < chunk_size) ? size - chunks[i].offset : chunk_size;
+		chunks[i].seed = seed + chunks[i].offset;
+	}
+
+	if (num_chunks == 1) {
+		buf_init_worker(&chunks[0]);
+		return SUCCESS;
+	}
+
+	for (started = 1; started < num_chunks; started++) {
+		if (pthread_create(&chunks[started].thread, NULL, buf_init_worker, &chunks[started])) {
+			fprintf(stderr, "Failed to create a buffer init thread\n");
+			ret = FAILURE;
+			break;
+		}
+	}
+	/* The calling thread fills the first chunk. */
+	buf_init_worker(&chunks[0]);
+
+	for (i = 1; i < started; i++)
+		pthread_join(chunks[i].thread, NULL);
+
+	return ret;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+/* The messages of a QP walk num_slots slots of the cycle buffer, as increase_loc_addr does. */
+static uint64_t cycle_buffer_slots(struct pingpong_context *ctx, struct perftest_parameters *user_param)
+{
+	if (user_param->size > ctx->cycle_buffer / 2)
+		return 1;
+
+	return ctx->cycle_buffer / INC(user_param->size, ctx->cache_line_size);
+}
+
+/* The receive half of a QP, the address the QP gives the remote side. */
+static uint64_t recv_region_addr(struct pingpong_context *ctx, struct perftest_parameters *user_param, int qp_index)
+{
+	if (user_param->mr_per_qp)
+		return (uintptr_t)ctx->buf[qp_index] + BUFF_SIZE(ctx->size, ctx->cycle_buffer);
+
+	return (uintptr_t)ctx->buf[0] + (user_param->num_of_qps + qp_index) * BUFF_SIZE(ctx->size, ctx->cycle_buffer);
+}
+
+/* Seals the message with its sequence number and slot, and the CRC32C of the message
+ * from the slot on.
+ */
+static void verify_seal(char *msg, uint64_t size, uint64_t seq, uint32_t slot)
+{
+	uint32_t crc;
+
+	memcpy(msg + 4, &slot, sizeof(slot));
+	memcpy(msg + 8, &seq, sizeof(seq));
+	crc = perftest_crc32c(0, msg + 4, size - 4);
+	memcpy(msg, &crc, sizeof(crc));
+}
+
+/* Writes the payload derived from the slot, and seals the message with seq. */
+static void verify_fill(char *msg, uint64_t size, uint64_t seq, uint32_t slot)
+{
+	uint64_t state = VERIFY_SEED ^ ((slot + 1) * 0x9E3779B97F4A7C15ULL);
+	uint64_t i, word;
+
+	for (i = VERIFY_HDR_SIZE; i < size; i += sizeof(word)) {
+		word = xorshift64s(&state);
+		memcpy(msg + i, &word, (size - i < sizeof(word)) ? size - i : sizeof(word));
+	}
+
+	verify_seal(msg, size, seq, slot);
+}
+
+/* Fills the slots of a region. The sent messages get their sequence number at the post,
+ * until then they carry VERIFY_SEQ_UNSENT. The messages a READ reads can't be stamped
+ * per message, they carry their slot.
+ */
+static void verify_stamp_region(struct pingpong_context *ctx, struct perftest_parameters *user_param,
+				uint64_t region, int slot_seq)
+{
+	uint64_t num_slots = cycle_buffer_slots(ctx, user_param);
+	uint64_t k;
+
+	for (k = 0; k < num_slots; k++)
+		verify_fill((char*)(region + k * INC(user_param->size, ctx->cache_line_size)),
+			    user_param->size, slot_seq ? k : VERIFY_SEQ_UNSENT, k);
+}
+
+/* Stamps the message about to be posted with the number of the messages its QP posted before it. */
+static inline void verify_stamp_message(struct pingpong_context *ctx, struct perftest_parameters *user_param,
+					int qp_index)
+{
+	uint64_t addr = ctx->wr[qp_index].sg_list->addr;
+
+	verify_seal((char*)(uintptr_t)addr, user_param->size, ctx->scnt[qp_index],
+		    (addr - ctx->my_addr[qp_index]) / INC(user_param->size, ctx->cache_line_size));
+}
+
+/* Compares the message with the one expected, to report where they differ. */
+static void verify_report(struct pingpong_context *ctx, struct perftest_parameters *user_param,
+			  int qp_index, const char *msg, uint64_t index, uint64_t region)
+{
+	uint32_t slot;
+	uint64_t seq, i, first = 0, bad = 0;
+	char *expected;
+
+	/* The payload comes from the sender's slot, trust the one in the message unless it is off the buffer. */
+	memcpy(&slot, msg + 4, sizeof(slot));
+	memcpy(&seq, msg + 8, sizeof(seq));
+	if (slot >= cycle_buffer_slots(ctx, user_param) * 2)
+		slot = index % cycle_buffer_slots(ctx, user_param);
+
+	expected = malloc(user_param->size);
+	if (!expected)
+		return;
+	verify_fill(expected, user_param->size, index, slot);
+
+	for (i = 0; i < user_param->size; i++) {
+		if (msg[i] != expected[i] && !bad++)
+			first = i;
+	}
+	free(expected);
+
+	fprintf(stderr, " Verify mismatch: QP %d message %" PRIu64 " at buffer offset %" PRIu64 ", seq %" PRIu64
+		" (expected %" PRIu64 "), %" PRIu64 " bytes differ from message offset %" PRIu64 "\n",
+		qp_index, index, (uint64_t)(uintptr_t)msg - region, seq, index, bad, first);
+}
+
+/* verify_message.
+ *
+ * Description :
+ *
+ *	Checks the CRC32C of a message and that it carries the sequence number
+ *	expected, and accounts the check to the CPU cost of --verify.
+ *
+ * Parameters :
+ *
+ *	ctx        - Test Context.
+ *	user_param - user_parameters struct for this test.
+ *	qp_index   - The QP the message came on.
+ *	msg        - The message in the buffer.
+ *	index      - The sequence number expected.
+ *	region     - The start of the receive region, for the reported offsets.
+ *
+ * Return Value : SUCCESS, FAILURE on a mismatch.
+ */
+static int verify_message(struct pingpong_context *ctx, struct perftest_parameters *user_param,
+			  int qp_index, const char *msg, uint64_t index, uint64_t region)
+{
+	cycles_t start = get_cycles();
+	uint32_t crc;
+	uint64_t seq;
+	int match;
+
+	memcpy(&crc, msg, sizeof(crc));
+	memcpy(&seq, msg + 8, sizeof(seq));
+	match = seq == index && crc == perftest_crc32c(0, msg + 4, user_param->size - 4);
+
+	user_param->verify_cycles += get_cycles() - start;
+	user_param->verify_bytes += user_param->size;
+	user_param->verify_msgs++;
+
+	if (match)
+		return SUCCESS;
+
+	if (user_param->verify_errors++ < VERIFY_MAX_REPORTS)
+		verify_report(ctx, user_param, qp_index, msg, index, region);
+	return FAILURE;
+}
+
+/* Where the index-th receive completion of the QP landed. SEND lands where the receive
+ * was posted, WRITE_IMM where the sender's walk of the remote buffer is.
+ */
+static uint64_t recv_completion_addr(struct pingpong_context *ctx, struct perftest_parameters *user_param,
+				     int qp_index, uint64_t index, uint64_t *region)
+{
+	if (user_param->verb == SEND) {
+		*region = ctx->rx_buffer_addr[qp_index];
+		return ctx->rx_posted_addr[qp_index * user_param->rx_depth + index % user_param->rx_depth];
+	}
+
+	*region = recv_region_addr(ctx, user_param, qp_index);
+	return *region + (index % cycle_buffer_slots(ctx, user_param)) * INC(user_param->size, ctx->cache_line_size);
+}
+
+/* Checks the index-th receive completion of the QP, the sender stamped it with index. */
+static void verify_recv_completion(struct pingpong_context *ctx, struct perftest_parameters *user_param,
+				   int qp_index, uint64_t index)
+{
+	uint64_t region, addr;
+
+	addr = recv_completion_addr(ctx, user_param, qp_index, index, &region);
+	verify_message(ctx, user_param, qp_index, (const char*)addr, index, region);
+}
+
+/* The --seq_track stamp is the start of the payload, past the GRH of a UD receive,
+ * and the end of a raw Ethernet frame, past its headers.
+ */
+static inline uint64_t seq_stamp_offset(struct perftest_parameters *user_param, int receive)
+{
+	if (user_param->connection_type == RawEth)
+		return user_param->size - SEQ_STAMP_SIZE;
+
+	return (receive && user_param->connection_type == UD) ? UD_ADDITION : 0;
+}
+
+/* Stamps the message about to be posted with the next sequence number of its QP and flow. */
+static inline void seq_stamp_message(struct pingpong_context *ctx, struct perftest_parameters *user_param,
+				     int qp_index, int flow)
+{
+	char *stamp = (char*)(uintptr_t)ctx->wr[qp_index].sg_list->addr + seq_stamp_offset(user_param, 0);
+	uint32_t magic = SEQ_STAMP_MAGIC, flow_id = flow;
+
+	memcpy(stamp, &magic, sizeof(magic));
+	memcpy(stamp + 4, &flow_id, sizeof(flow_id));
+	memcpy(stamp + 8, &user_param->seq_tx[qp_index * user_param->flows + flow], sizeof(uint64_t));
+	user_param->seq_tx[qp_index * user_param->flows + flow]++;
+}
+
+void ctx_seq_track_recv(struct pingpong_context *ctx, struct perftest_parameters *user_param,
+			int qp_index, uint64_t index)
+{
+	uint64_t region, seq;
+	uint32_t magic, flow;
+	const char *stamp;
+
+	stamp = (const char*)(uintptr_t)recv_completion_addr(ctx, user_param, qp_index, index, &region) +
+		seq_stamp_offset(user_param, 1);
+	memcpy(&magic, stamp, sizeof(magic));
+	memcpy(&flow, stamp + 4, sizeof(flow));
+	memcpy(&seq, stamp + 8, sizeof(seq));
+
+	if (magic != SEQ_STAMP_MAGIC || flow >= user_param->flows) {
+		user_param->seq_unstamped++;
+		return;
+	}
+	seq_tracker_add(&user_param->seq_trackers[qp_index * user_param->flows + flow], seq);
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+int ctx_verify_bw(struct pingpong_context *ctx, struct perftest_parameters *user_param)
+{
+	uint64_t num_slots = cycle_buffer_slots(ctx, user_param);
+	uint64_t slots = (user_param->iters < num_slots) ? user_param->iters : num_slots;
+	uint64_t region, k, seq;
+	int i;
+
+	for (i = 0; i < user_param->num_of_qps; i++) {
+		region = (user_param->verb == READ) ? ctx->my_addr[i] : recv_region_addr(ctx, user_param, i);
+		for (k = 0; k < slots; k++) {
+			/* A READ reads the slot stamps of the remote side, a WRITE leaves the last message sent to the slot. */
+			seq = (user_param->verb == READ) ? k : k + (user_param->iters - 1 - k) / num_slots * num_slots;
+			verify_message(ctx, user_param, i,
+				       (const char*)(region + k * INC(user_param->size, ctx->cache_line_size)), seq, region);
+		}
+	}
+
+	return user_param->verify_errors ? FAILURE : SUCCESS;
+}
+
+/* The application buffer of --copy_mode mirrors the registered one, the message of
+ * a slot is copied to and from the same offset in the QP's part of it.
+ */
+static inline void *copy_app_addr(struct pingpong_context *ctx, int qp_index, uint64_t region, uint64_t addr)
+{
+	return (char*)ctx->copy_buf + qp_index * BUFF_SIZE(ctx->size, ctx->cycle_buffer) + (addr - region);
+}
+
+/* copy_message.
+ *
+ * Description :
+ *
+ *	Copies a message between the application buffer and its registered slot
+ *	with the copy of the memory type, and accounts it to the copy cost of
+ *	--copy_mode.
+ *
+ * Parameters :
+ *
+ *	ctx        - Test Context.
+ *	user_param - user_parameters struct for this test.
+ *	qp_index   - The QP of the message.
+ *	region     - The start of the registered region the slot is in.
+ *	addr       - The registered slot.
+ *	to_buffer  - Copy into the slot (before a post) or out of it (after a completion).
+ */
+static void copy_message(struct pingpong_context *ctx, struct perftest_parameters *user_param,
+			 int qp_index, uint64_t region, uint64_t addr, int to_buffer)
+{
+	void *app = copy_app_addr(ctx, qp_index, region, addr);
+	cycles_t start = get_cycles();
+
+	if (to_buffer)
+		ctx->memory->copy_host_to_buffer((void*)(uintptr_t)addr, app, user_param->size);
+	else
+		ctx->memory->copy_buffer_to_host(app, (void*)(uintptr_t)addr, user_param->size);
+
+	user_param->copy_cycles += get_cycles() - start;
+	user_param->copy_bytes += user_param->size;
+	user_param->copy_msgs++;
+}
+
+/* Copies the index-th receive completion of the QP out to the application buffer. */
+static void copy_recv_completion(struct pingpong_context *ctx, struct perftest_parameters *user_param,
+				 int qp_index, uint64_t index)
+{
+	uint64_t region, addr;
+
+	addr = recv_completion_addr(ctx, user_param, qp_index, index, &region);
+	copy_message(ctx, user_param, qp_index, region, addr, 0);
+}
+
+/* touch_message.
+ *
+ * Description :
+ *
+ *	Accesses the payload of a message like an application producing or
+ *	consuming it: writes or reads (and sums) a word every --touch_stride
+ *	bytes of the --touch_fraction of the message, and accounts the time.
+ *
+ * Parameters :
+ *
+ *	user_param - user_parameters struct for this test.
+ *	addr       - The message in the buffer.
+ *	write      - Write the words, or read them.
+ *	seq        - The value the written words are derived from.
+ */
+static void touch_message(struct perftest_parameters *user_param, uint64_t addr, int write, uint64_t seq)
+{
+	uint64_t len = user_param->size * user_param->touch_fraction / 100;
+	uint64_t off, word, sum = 0;
+	char *msg = (char*)(uintptr_t)addr;
+	cycles_t start = get_cycles();
+
+	/* A small fraction of a small message still touches one word. */
+	if (len < sizeof(word))
+		len = (user_param->size < sizeof(word)) ? user_param->size : sizeof(word);
+
+	for (off = 0; off < len; off += user_param->touch_stride) {
+		if (write) {
+			word = seq ^ off;
+			memcpy(msg + off, &word, (len - off < sizeof(word)) ? len - off : sizeof(word));
+		} else {
+			word = 0;
+			memcpy(&word, msg + off, (len - off < sizeof(word)) ? len - off : sizeof(word));
+			sum += word;
+		}
+	}
+
+	user_param->touch_sum += sum;
+	user_param->touch_cycles += get_cycles() - start;
+	user_param->touch_bytes += len;
+	user_param->touch_msgs++;
+}
+
+/* Reads the index-th receive completion of the QP. */
+static void touch_recv_completion(struct pingpong_context *ctx, struct perftest_parameters *user_param,
+				  int qp_index, uint64_t index)
+{
+	uint64_t region;
+
+	touch_message(user_param, recv_completion_addr(ctx, user_param, qp_index, index, &region), 0, index);
+}
+
+/* reg_post_buffer.
+ *
+ * Description :
+ *
+ *	Takes the next buffer of the --reg_mode pool for the message the QP posts
+ *	next and gets its registration, from the cache or a new one, into the
+ *	SGE of the WR. The registration is held until the completion.
+ *
+ * Parameters :
+ *
+ *	ctx        - Test Context.
+ *	user_param - user_parameters struct for this test.
+ *	qp_index   - The QP posting the message.
+ *
+ * Return Value : SUCCESS, FAILURE.
+ */
+static int reg_post_buffer(struct pingpong_context *ctx, struct perftest_parameters *user_param, int qp_index)
+{
+	uint64_t buf_index;
+	struct reg_cache_entry *entry;
+	cycles_t start = get_cycles();
+	char *buf;
+
+	buf_index = user_param->reg_pool_random ? perftest_rand(&ctx->reg_rand_state) % user_param->reg_pool :
+						  ctx->reg_pool_next++ % user_param->reg_pool;
+	buf = (char*)ctx->reg_pool_buf + buf_index * ctx->reg_pool_stride;
+
+	entry = reg_cache_get(ctx->reg_cache, buf, user_param->size);
+	if (!entry)
+		return FAILURE;
+
+	ctx->reg_inflight[qp_index * user_param->tx_depth + ctx->scnt[qp_index] % user_param->tx_depth] = entry;
+	ctx->wr[qp_index].sg_list->addr = (uintptr_t)buf;
+	ctx->wr[qp_index].sg_list->lkey = entry->mr->lkey;
+
+	user_param->reg_cycles += get_cycles() - start;
+	user_param->reg_msgs++;
+	return SUCCESS;
+}
+
+/* Releases the registrations of the completed messages of the QP, from first on. */
+static void reg_complete(struct pingpong_context *ctx, struct perftest_parameters *user_param,
+			 int qp_index, uint64_t first, int num)
+{
+	struct reg_cache_entry **entry;
+	cycles_t start = get_cycles();
+	uint64_t n;
+
+	for (n = first; n < first + num && n < ctx->scnt[qp_index]; n++) {
+		entry = &ctx->reg_inflight[qp_index * user_param->tx_depth + n % user_param->tx_depth];
+		if (*entry) {
+			reg_cache_put(ctx->reg_cache, *entry);
+			*entry = NULL;
+		}
+	}
+
+	user_param->reg_cycles += get_cycles() - start;
+}
+
 /******************************************************************************
  *
  ******************************************************************************/
@@ -1675,6 +2594,7 @@ int create_single_mr(struct pingpong_context *ctx, struct perftest_parameters *u
 	bool can_init_mem = true;
 	int dmabuf_fd = 0;
 	uint64_t dmabuf_offset = 0;
+	cycles_t phase_start = get_cycles();
 
 	/* ODP */
 	#ifdef HAVE_EX_ODP
@@ -1700,16 +2620,24 @@ int create_single_mr(struct pingpong_context *ctx, struct perftest_parameters *u
 		return FAILURE;
 	}
 
-	if (user_param->verb == WRITE || user_param->verb == WRITE_IMM) {
+	/* Initialize the buffer before the registration, which then finds the pages present. */
+	if (can_init_mem && init_buffer(user_param, ctx->buf[qp_index], ctx->buff_size))
+		return FAILURE;
+	setup_phase_add(SETUP_REPORT(user_param), SETUP_PHASE_BUFFER_INIT, phase_start);
+
+	phase_start = get_cycles();
+	if (USES_VERB(user_param, WRITE) || user_param->verb == WRITE_IMM)
 		flags |= IBV_ACCESS_REMOTE_WRITE;
-	} else if (user_param->verb == READ) {
+
+	if (USES_VERB(user_param, READ)) {
 		flags |= IBV_ACCESS_REMOTE_READ;
 		if (user_param->transport_type == IBV_TRANSPORT_IWARP)
 			flags |= IBV_ACCESS_REMOTE_WRITE;
-	} else if (user_param->verb == ATOMIC) {
-		flags |= IBV_ACCESS_REMOTE_ATOMIC;
 	}
 
+	if (USES_VERB(user_param, ATOMIC))
+		flags |= IBV_ACCESS_REMOTE_ATOMIC;
+
 #ifdef HAVE_RO
 	if (user_param->disable_pcir == 0) {
 		flags |= IBV_ACCESS_RELAXED_ORDERING;
@@ -1762,36 +2690,128 @@ int create_single_mr(struct pingpong_context *ctx, struct perftest_parameters *u
 		}
 	}
 
-	if (user_param->use_null_mr) {
-		ctx->null_mr = ibv_alloc_null_mr(ctx->pd);
-		if (!ctx->null_mr) {
-			fprintf(stderr, "Couldn't create null MR\n");
+	if (user_param->use_null_mr) {
+		ctx->null_mr = ibv_alloc_null_mr(ctx->pd);
+		if (!ctx->null_mr) {
+			fprintf(stderr, "Couldn't create null MR\n");
+			return FAILURE;
+		}
+	}
+	setup_phase_add(SETUP_REPORT(user_param), SETUP_PHASE_CREATE_MR, phase_start);
+
+	return SUCCESS;
+}
+
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+struct reg_mr_args {
+	void				**bufs;
+	int				flags;
+};
+
+static int reg_mr_worker(struct pingpong_context *ctx,
+		struct perftest_parameters *user_param, void *arg, int index)
+{
+	struct reg_mr_args *args = (struct reg_mr_args*)arg;
+	uint64_t measure_cnt = user_param->reg_mr_iters * user_param->reg_mr_threads;
+	cycles_t *reg_cycles = &user_param->reg_mr_cycles[index * user_param->reg_mr_iters];
+	cycles_t *dereg_cycles = &user_param->reg_mr_cycles[measure_cnt + index * user_param->reg_mr_iters];
+	struct ibv_mr *mr;
+	cycles_t start_cycles;
+	uint64_t i;
+
+	for (i = 0; i < user_param->reg_mr_iters; i++) {
+		start_cycles = get_cycles();
+		mr = ibv_reg_mr(ctx->pd, args->bufs[index], user_param->size, args->flags);
+		reg_cycles[i] = get_cycles() - start_cycles;
+		if (!mr) {
+			fprintf(stderr, "Couldn't register MR of %" PRIu64 " bytes - %s\n",
+				user_param->size, strerror(errno));
+			return FAILURE;
+		}
+
+		start_cycles = get_cycles();
+		if (ibv_dereg_mr(mr)) {
+			fprintf(stderr, "Failed to deregister MR\n");
+			return FAILURE;
+		}
+		dereg_cycles[i] = get_cycles() - start_cycles;
+	}
+
+	return SUCCESS;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+int run_iter_reg_mr_rate(struct pingpong_context *ctx, struct perftest_parameters *user_param)
+{
+	struct reg_mr_args args;
+	int i, rc = FAILURE;
+	int dmabuf_fd = 0;
+	uint64_t dmabuf_offset = 0;
+	uint64_t max_iters;
+	bool can_init_mem = true;
+	cycles_t start_cycles;
+
+	args.flags = IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE | IBV_ACCESS_REMOTE_READ;
+
+	#ifdef HAVE_EX_ODP
+	if (user_param->use_odp) {
+		if ( !check_odp_support(ctx, user_param) )
 			return FAILURE;
-		}
+
+		args.flags |= IBV_ACCESS_ON_DEMAND;
 	}
+	#endif
 
-	/* Initialize buffer with random numbers except in WRITE_LAT test that it 0's */
-	if (can_init_mem) {
-		uint32_t rng_state = init_perftest_rand_state();
-		if ((user_param->verb == WRITE || user_param->verb == WRITE_IMM) && user_param->tst == LAT) {
-			memset(ctx->buf[qp_index], 0, ctx->buff_size);
-		} else {
-			uint64_t i;
-			if (user_param->has_payload_modification) {
-				for (i = 0; i < ctx->buff_size; i++) {
-					((char*)ctx->buf[qp_index])[i] = user_param->payload_content[i % user_param->payload_length];
-				}
-			} else {
-				uint32_t *buf_ptr = (uint32_t*)ctx->buf[qp_index];
-				for (i = 0; i < ctx->buff_size/4; i++) {
-					buf_ptr[i] = perftest_rand(&rng_state);
-				}
-			}
+	#ifdef HAVE_RO
+	if (user_param->disable_pcir == 0)
+		args.flags |= IBV_ACCESS_RELAXED_ORDERING;
+	#endif
+
+	/* Bound the bytes registered per size, so the large sizes of the sweep
+	 * finish in a reasonable time.
+	 */
+	max_iters = REG_MR_BYTES_PER_SIZE / user_param->size;
+	if (max_iters < REG_MR_MIN_ITERS)
+		max_iters = REG_MR_MIN_ITERS;
+	user_param->reg_mr_iters = (user_param->iters < max_iters) ? user_param->iters : max_iters;
+	user_param->reg_mr_threads = user_param->qp_threads;
+
+	free(user_param->reg_mr_cycles);
+	ALLOCATE(user_param->reg_mr_cycles, cycles_t, 2 * user_param->reg_mr_iters * user_param->reg_mr_threads);
+	ALLOCATE(args.bufs, void*, user_param->reg_mr_threads);
+	memset(args.bufs, 0, sizeof(void*) * user_param->reg_mr_threads);
+
+	/* Each thread registers its own buffer. */
+	for (i = 0; i < user_param->reg_mr_threads; i++) {
+		if (ctx->memory->allocate_buffer(ctx->memory, user_param->cycle_buffer, user_param->size,
+						 &dmabuf_fd, &dmabuf_offset, &args.bufs[i],
+						 &can_init_mem)) {
+			fprintf(stderr, "Couldn't allocate a buffer of %" PRIu64 " bytes\n", user_param->size);
+			goto free_bufs;
 		}
+		/* Keep the page faults out of the measured registrations. */
+		if (can_init_mem && init_buffer(user_param, args.bufs[i], user_param->size))
+			goto free_bufs;
 	}
-	return SUCCESS;
-}
 
+	start_cycles = get_cycles();
+	rc = run_qp_workers(ctx, user_param, reg_mr_worker, &args, 0, user_param->reg_mr_threads, 1);
+	user_param->reg_mr_total_cycles = get_cycles() - start_cycles;
+
+free_bufs:
+	for (i = 0; i < user_param->reg_mr_threads; i++) {
+		if (args.bufs[i])
+			ctx->memory->free_buffer(ctx->memory, 0, args.bufs[i], user_param->size);
+	}
+	free(args.bufs);
+
+	return rc;
+}
 
 static int create_payload(struct perftest_parameters *user_param)
 {
@@ -1909,8 +2929,82 @@ int create_mr(struct pingpong_context *ctx, struct perftest_parameters *user_par
 		}
 	}
 
+	/* A --verify READ reads the stamped messages of the receive halves of the remote side. */
+	if (user_param->verify && user_param->verb == READ) {
+		for (i = 0; i < user_param->num_of_qps; i++)
+			verify_stamp_region(ctx, user_param, recv_region_addr(ctx, user_param, i), 1);
+	}
+
+	/* The unregistered application buffer of --copy_mode, one part per QP like the send halves. */
+	if (user_param->copy_mode != COPY_MODE_NONE) {
+		uint64_t copy_size = user_param->num_of_qps * BUFF_SIZE(ctx->size, ctx->cycle_buffer);
+
+		if (posix_memalign(&ctx->copy_buf, sysconf(_SC_PAGESIZE), copy_size)) {
+			fprintf(stderr, "Couldn't allocate the copy buffer\n");
+			ctx->copy_buf = NULL;
+			goto destroy_mr;
+		}
+		if (init_buffer(user_param, ctx->copy_buf, copy_size))
+			goto free_copy_buf;
+	}
+
+	/* The unregistered buffer pool of --reg_mode, the initiator registers a buffer for each message. */
+	if (user_param->reg_mode != REG_MODE_STATIC && user_param->machine == CLIENT) {
+		uint64_t page_size = sysconf(_SC_PAGESIZE);
+		uint64_t pool_size;
+
+		ctx->reg_pool_stride = (ctx->size + page_size - 1) / page_size * page_size;
+		pool_size = user_param->reg_pool * ctx->reg_pool_stride;
+		if (posix_memalign(&ctx->reg_pool_buf, page_size, pool_size)) {
+			fprintf(stderr, "Couldn't allocate the registration pool\n");
+			ctx->reg_pool_buf = NULL;
+			goto free_copy_buf;
+		}
+		if (init_buffer(user_param, ctx->reg_pool_buf, pool_size))
+			goto free_reg_pool;
+		if (reg_cache_create(ctx->pd, IBV_ACCESS_LOCAL_WRITE,
+				     user_param->reg_mode == REG_MODE_CACHED ? user_param->reg_cache_size : 0,
+				     &ctx->reg_cache)) {
+			fprintf(stderr, "Couldn't allocate the registration cache\n");
+			goto free_reg_pool;
+		}
+		ctx->reg_pool_next = 0;
+		ctx->reg_rand_state = init_perftest_rand_state();
+	}
+
+	/* --sge_layout=mr gives each SGE after the first of a WR its own MR over the buffer. */
+	if (ctx->sge_mr) {
+		for (i = 0; i < mr_index * user_param->sge; i++) {
+			if (i % user_param->sge == 0)
+				continue;
+			ctx->sge_mr[i] = ibv_reg_mr(ctx->pd, ctx->mr[i / user_param->sge]->addr,
+					ctx->mr[i / user_param->sge]->length, IBV_ACCESS_LOCAL_WRITE);
+			if (!ctx->sge_mr[i]) {
+				fprintf(stderr, "failed to create SGE mr\n");
+				goto destroy_sge_mr;
+			}
+		}
+	}
+
 	return 0;
 
+destroy_sge_mr:
+	for (i = 0; i < mr_index * user_param->sge; i++) {
+		if (ctx->sge_mr[i]) {
+			ibv_dereg_mr(ctx->sge_mr[i]);
+			ctx->sge_mr[i] = NULL;
+		}
+	}
+	if (ctx->reg_cache) {
+		reg_cache_destroy(ctx->reg_cache);
+		ctx->reg_cache = NULL;
+	}
+free_reg_pool:
+	free(ctx->reg_pool_buf);
+	ctx->reg_pool_buf = NULL;
+free_copy_buf:
+	free(ctx->copy_buf);
+	ctx->copy_buf = NULL;
 destroy_mr:
 	for (i = 0; i < mr_index; i++)
 		ibv_dereg_mr(ctx->mr[i]);
@@ -1934,6 +3028,22 @@ int verify_params_with_device_context(struct ibv_context *context,
 		}
 	}
 
+	if (user_param->sge > 1) {
+		struct ibv_device_attr attr;
+		int max_sge;
+
+		if (ibv_query_device(context, &attr)) {
+			fprintf(stderr, " Couldn't query the device attributes\n");
+			return FAILURE;
+		}
+		/* The local SGEs of a READ are bound by max_sge_rd. */
+		max_sge = (user_param->verb == READ && attr.max_sge_rd < attr.max_sge) ? attr.max_sge_rd : attr.max_sge;
+		if (user_param->sge > max_sge) {
+			fprintf(stderr, " --sge %d is above the device max of %d SGEs\n", user_param->sge, max_sge);
+			return FAILURE;
+		}
+	}
+
 	// those are devices supporting new post send
 	if (current_dev != CONNECTIB &&
 		current_dev != CONNECTX4 &&
@@ -2033,11 +3143,27 @@ void check_bf_support(struct pingpong_context *ctx)
 	#endif
 }
 
+static int ctx_init_qp(struct pingpong_context *ctx,
+		struct perftest_parameters *user_param, void *arg, int qp_index)
+{
+	if (create_qp_main(ctx, user_param, qp_index)) {
+		fprintf(stderr, "Failed to create QP.\n");
+		return FAILURE;
+	}
+
+	if (user_param->work_rdma_cm == OFF)
+		modify_qp_to_init(ctx, user_param, qp_index);
+
+	return SUCCESS;
+}
+
 int ctx_init(struct pingpong_context *ctx, struct perftest_parameters *user_param)
 {
 	int i;
 	int dct_only = (user_param->machine == SERVER && !(user_param->duplex || user_param->tst == LAT));
-	int qp_index = 0, dereg_counter;
+	int dereg_counter;
+	cycles_t start_cycles, phase_start;
+	cycles_t init_start = get_cycles();
 	#ifdef HAVE_AES_XTS
 	int mkey_index = 0, dek_index = 0;
 	#endif
@@ -2066,12 +3192,20 @@ int ctx_init(struct pingpong_context *ctx, struct perftest_parameters *user_para
 		}
 	}
 
+	/* The events count the test thread, destroy_ctx closes them with the resources. */
+	if (user_param->perf_events_ctx && perf_events_open(user_param->perf_events_ctx)) {
+		fprintf(stderr," Unable to open perf events\n");
+		goto comp_channel;
+	}
+
 	/* Allocating the Protection domain. */
+	phase_start = get_cycles();
 	ctx->pd = ibv_alloc_pd(ctx->context);
 	if (!ctx->pd) {
 		fprintf(stderr, "Couldn't allocate PD\n");
 		goto comp_channel;
 	}
+	setup_phase_add(SETUP_REPORT(user_param), SETUP_PHASE_ALLOC_PD, phase_start);
 
 	#ifdef HAVE_TD_API
 	/* Allocating the Thread domain, Parent domain. */
@@ -2153,16 +3287,19 @@ int ctx_init(struct pingpong_context *ctx, struct perftest_parameters *user_para
 		goto mkey;
 	}
 
+	/* create_single_mr splits the buffer init and the registration of each MR. */
 	if (create_mr(ctx, user_param)) {
 		fprintf(stderr, "Failed to create MR\n");
 		goto mkey;
 	}
 
+	phase_start = get_cycles();
 	if (create_cqs(ctx, user_param)) {
 		fprintf(stderr, "Failed to create CQs\n");
 		goto mr;
 
 	}
+	setup_phase_add(SETUP_REPORT(user_param), SETUP_PHASE_CREATE_CQS, phase_start);
 
 	#ifdef HAVE_XRCD
 	if (user_param->use_xrc) {
@@ -2217,39 +3354,59 @@ int ctx_init(struct pingpong_context *ctx, struct perftest_parameters *user_para
 		}
 	}
 
+	if (user_param->recv_classes && user_param->machine == SERVER) {
+		if (recv_pool_create(ctx->pd, ctx->pad, user_param->recv_classes, user_param->recv_class_size,
+				     user_param->recv_class_depth, &ctx->recv_pool)) {
+			fprintf(stderr, "Couldn't create the receive pool\n");
+			goto xrcd;
+		}
+		user_param->recv_pool_footprint = ctx->recv_pool->arena_size;
+	}
+
 	/*
 	* QPs creation in RDMA CM flow will be done separately.
 	* Unless, the function called with RDMA CM connection contexts,
 	* need to verify the call with the existence of ctx->cm_id.
 	*/
-	if (!(user_param->work_rdma_cm == OFF || ctx->cm_id))
+	if (!(user_param->work_rdma_cm == OFF || ctx->cm_id)) {
+		setup_phase_add(SETUP_REPORT(user_param), SETUP_PHASE_CTX_INIT, init_start);
 		return SUCCESS;
+	}
 
-	for (i=0; i < user_param->num_of_qps; i++) {
-		if (create_qp_main(ctx, user_param, i)) {
-			fprintf(stderr, "Failed to create QP.\n");
-			goto qps;
-		}
+	memset(ctx->qp, 0, sizeof(struct ibv_qp*) * user_param->num_of_qps);
+	start_cycles = get_cycles();
 
-		if (user_param->work_rdma_cm == OFF) {
-			modify_qp_to_init(ctx, user_param, i);
-		}
+	/* The first QP settles the capabilities clamped at creation
+	 * (inline size, DDP) before the rest are created in parallel.
+	 */
+	if (ctx_init_qp(ctx, user_param, NULL, 0))
+		goto qps;
 
-		qp_index++;
-	}
+	if (run_qp_workers(ctx, user_param, ctx_init_qp, NULL, 1, user_param->num_of_qps, 1))
+		goto qps;
+
+	user_param->qp_create_cycles = get_cycles() - start_cycles;
+	setup_phase_add(SETUP_REPORT(user_param), SETUP_PHASE_CREATE_QPS, start_cycles);
+	setup_phase_add(SETUP_REPORT(user_param), SETUP_PHASE_CTX_INIT, init_start);
 
 	return SUCCESS;
 
 
 qps:
-	for(i = 0; i < qp_index; i++){
-		ibv_destroy_qp(ctx->qp[i]);
+	for(i = 0; i < user_param->num_of_qps; i++){
+		if (ctx->qp[i])
+			ibv_destroy_qp(ctx->qp[i]);
 	}
 
 	if (user_param->use_srq && (user_param->tst == LAT ||
 			user_param->machine == SERVER || user_param->duplex == ON))
 		ibv_destroy_srq(ctx->srq);
 
+	if (ctx->recv_pool) {
+		recv_pool_destroy(ctx->recv_pool);
+		ctx->recv_pool = NULL;
+	}
+
 xrcd: __attribute__((unused))
 	#ifdef HAVE_XRCD
 	if (user_param->use_xrc)
@@ -2303,6 +3460,11 @@ comp_channel:
 		ibv_destroy_comp_channel(ctx->recv_channel);
 	}
 
+	if (user_param->perf_events_ctx) {
+		perf_events_close(user_param->perf_events_ctx);
+		user_param->perf_events_ctx = NULL;
+	}
+
 	return FAILURE;
 }
 
@@ -2409,10 +3571,14 @@ struct ibv_qp* ctx_qp_create(struct pingpong_context *ctx,
 	if (!(user_param->connection_type == DC &&
 			is_dc_server_side)) {
 		attr.cap.max_send_wr  = user_param->tx_depth;
-		attr.cap.max_send_sge = MAX_SEND_SGE;
+		attr.cap.max_send_sge = (user_param->sge > 1) ? user_param->sge : MAX_SEND_SGE;
 	}
 
-	if (user_param->use_srq &&
+	if (ctx->recv_pool) {
+		attr.srq = ctx->recv_pool->srq[qp_index % ctx->recv_pool->num_classes];
+		attr.cap.max_recv_wr  = 0;
+		attr.cap.max_recv_sge = 0;
+	} else if (user_param->use_srq &&
 			(user_param->tst == LAT ||
 			 user_param->machine == SERVER ||
 			 user_param->duplex == ON)) {
@@ -2425,7 +3591,7 @@ struct ibv_qp* ctx_qp_create(struct pingpong_context *ctx,
 		attr.srq = NULL;
 		if (user_param->connection_type != DC) {
 			attr.cap.max_recv_wr  = user_param->rx_depth;
-			attr.cap.max_recv_sge = MAX_RECV_SGE;
+			attr.cap.max_recv_sge = (user_param->sge > 1) ? user_param->sge : MAX_RECV_SGE;
 		}
 	}
 
@@ -2469,6 +3635,13 @@ struct ibv_qp* ctx_qp_create(struct pingpong_context *ctx,
 			attr_ex.send_ops_flags |= IBV_QP_EX_WITH_RDMA_READ;
 	}
 
+	if (USES_VERB(user_param, WRITE))
+		attr_ex.send_ops_flags |= IBV_QP_EX_WITH_RDMA_WRITE;
+	if (USES_VERB(user_param, READ))
+		attr_ex.send_ops_flags |= IBV_QP_EX_WITH_RDMA_READ;
+	if (USES_VERB(user_param, ATOMIC))
+		attr_ex.send_ops_flags |= IBV_QP_EX_WITH_ATOMIC_FETCH_AND_ADD;
+
 	attr_ex.pd = ctx->pad;
 
 	attr_ex.comp_mask |= IBV_QP_INIT_ATTR_SEND_OPS_FLAGS | IBV_QP_INIT_ATTR_PD;
@@ -2660,15 +3833,14 @@ int ctx_modify_qp_to_init(struct ibv_qp *qp,struct perftest_parameters *user_par
 						 (qp_index >= num_of_qps)));
 
 	if (user_param->dualport==ON) {
-		static int portindex=0;  /* for dual-port support */
-		if (portindex % num_of_qps < num_of_qps_per_port) {
+		/* Keyed on the QP, --qp_threads moves the QPs to INIT in any order. */
+		if (qp_index % num_of_qps < num_of_qps_per_port) {
 			attr.port_num = user_param->ib_port;
-			user_param->port_by_qp[portindex] = 0;
+			user_param->port_by_qp[qp_index] = 0;
 		} else {
 			attr.port_num = user_param->ib_port2;
-			user_param->port_by_qp[portindex] = 1;
+			user_param->port_by_qp[qp_index] = 1;
 		}
-		portindex++;
 
 	} else {
 		attr.port_num = user_param->ib_port;
@@ -2690,6 +3862,12 @@ int ctx_modify_qp_to_init(struct ibv_qp *qp,struct perftest_parameters *user_par
 				     attr.qp_access_flags = IBV_ACCESS_REMOTE_WRITE; break;
 			case SEND  : attr.qp_access_flags = IBV_ACCESS_REMOTE_WRITE | IBV_ACCESS_LOCAL_WRITE;
 		}
+		if (USES_VERB(user_param, WRITE))
+			attr.qp_access_flags |= IBV_ACCESS_REMOTE_WRITE;
+		if (USES_VERB(user_param, READ))
+			attr.qp_access_flags |= IBV_ACCESS_REMOTE_READ;
+		if (USES_VERB(user_param, ATOMIC))
+			attr.qp_access_flags |= IBV_ACCESS_REMOTE_ATOMIC;
 		flags |= IBV_QP_ACCESS_FLAGS;
 	}
 	ret = ibv_modify_qp(qp, &attr, flags);
@@ -2845,103 +4023,209 @@ static int ctx_modify_qp_to_rts(struct ibv_qp *qp,
 /******************************************************************************
  *
  ******************************************************************************/
-int ctx_connect(struct pingpong_context *ctx,
-		struct pingpong_dest *dest,
-		struct perftest_parameters *user_param,
-		struct pingpong_dest *my_dest)
+struct ctx_connect_args {
+	struct pingpong_dest		*dest;
+	struct pingpong_dest		*my_dest;
+};
+
+static int ctx_connect_qp(struct pingpong_context *ctx,
+		struct perftest_parameters *user_param, void *arg, int i)
 {
-	int i;
+	struct ctx_connect_args *args = (struct ctx_connect_args*)arg;
+	struct pingpong_dest *dest = args->dest;
+	struct pingpong_dest *my_dest = args->my_dest;
 	struct ibv_qp_attr attr;
 	int xrc_offset = 0;
 
-	if((user_param->use_xrc || user_param->connection_type == DC) && (user_param->duplex || user_param->tst == LAT)) {
-		xrc_offset = user_param->num_of_qps / 2;
-	}
-	for (i=0; i < user_param->num_of_qps; i++) {
-
+	/* in xrc/dc with bidirectional, the send qps of one side are
+	 * connected to the recv qps of the other half.
+	 */
+	if ((user_param->use_xrc || user_param->connection_type == DC) && (user_param->duplex || user_param->tst == LAT))
+		xrc_offset = (i < user_param->num_of_qps / 2) ? user_param->num_of_qps / 2 : -1 * (user_param->num_of_qps / 2);
 
-		memset(&attr, 0, sizeof attr);
+	memset(&attr, 0, sizeof attr);
 
-		if (user_param->rate_limit_type == HW_RATE_LIMIT)
-			attr.ah_attr.static_rate = user_param->valid_hw_rate_limit_index;
+	if (user_param->rate_limit_type == HW_RATE_LIMIT)
+		attr.ah_attr.static_rate = user_param->valid_hw_rate_limit_index;
 
-		#if defined (HAVE_PACKET_PACING)
-		if (user_param->rate_limit_type == PP_RATE_LIMIT) {
-			if (check_packet_pacing_support(ctx) == FAILURE) {
-				fprintf(stderr, "Packet Pacing isn't supported.\n");
-				return FAILURE;
-			}
+	if(ctx_modify_qp_to_rtr(ctx->qp[i], &attr, user_param, &dest[xrc_offset + i], &my_dest[i], i)) {
+		fprintf(stderr, "Failed to modify QP %d to RTR\n",ctx->qp[i]->qp_num);
+		return FAILURE;
+	}
+	if (user_param->connection_type == DC) {
+		if ( ((!(user_param->duplex || user_param->tst == LAT) && (user_param->machine == SERVER) )
+			|| ((user_param->duplex || user_param->tst == LAT) && (i >= user_param->num_of_qps/2)))) {
+			return SUCCESS;
 		}
-		#endif
+	}
+	if (user_param->tst == LAT || user_param->machine == CLIENT || user_param->duplex) {
+		if(ctx_modify_qp_to_rts(ctx->qp[i], &attr, user_param, &dest[xrc_offset + i], &my_dest[i])) {
+			fprintf(stderr, "Failed to modify QP to RTS\n");
+			return FAILURE;
+		}
+	}
 
-		if ((i >= xrc_offset) && (user_param->use_xrc || user_param->connection_type == DC) && (user_param->duplex || user_param->tst == LAT))
-			xrc_offset = -1*xrc_offset;
+	if (((user_param->connection_type == UD || user_param->connection_type == DC || user_param->connection_type == SRD) &&
+			(user_param->tst == LAT || user_param->machine == CLIENT || user_param->duplex)) ||
+			(user_param->connection_type == SRD && (user_param->verb == READ || user_param->verb == WRITE ||
+								user_param->verb == WRITE_IMM))) {
 
+		ctx->ah[i] = ibv_create_ah(ctx->pd,&(attr.ah_attr));
 
-		if(ctx_modify_qp_to_rtr(ctx->qp[i], &attr, user_param, &dest[xrc_offset + i], &my_dest[i], i)) {
-			fprintf(stderr, "Failed to modify QP %d to RTR\n",ctx->qp[i]->qp_num);
+		if (!ctx->ah[i]) {
+			fprintf(stderr, "Failed to create AH\n");
 			return FAILURE;
 		}
-		if (user_param->connection_type == DC) {
-			if ( ((!(user_param->duplex || user_param->tst == LAT) && (user_param->machine == SERVER) )
-				|| ((user_param->duplex || user_param->tst == LAT) && (i >= user_param->num_of_qps/2)))) {
-				continue;
-			}
-		}
-		if (user_param->tst == LAT || user_param->machine == CLIENT || user_param->duplex) {
-			if(ctx_modify_qp_to_rts(ctx->qp[i], &attr, user_param, &dest[xrc_offset + i], &my_dest[i])) {
-				fprintf(stderr, "Failed to modify QP to RTS\n");
-				return FAILURE;
-			}
-		}
+		user_param->ah_allocated = 1;
+	}
 
-		if (((user_param->connection_type == UD || user_param->connection_type == DC || user_param->connection_type == SRD) &&
-				(user_param->tst == LAT || user_param->machine == CLIENT || user_param->duplex)) ||
-				(user_param->connection_type == SRD && (user_param->verb == READ || user_param->verb == WRITE ||
-									user_param->verb == WRITE_IMM))) {
+	if (user_param->rate_limit_type == HW_RATE_LIMIT) {
+		struct ibv_qp_attr qp_attr;
+		struct ibv_qp_init_attr init_attr;
+		int err, qp_static_rate = 0;
 
-			ctx->ah[i] = ibv_create_ah(ctx->pd,&(attr.ah_attr));
+		memset(&qp_attr,0,sizeof(struct ibv_qp_attr));
+		memset(&init_attr,0,sizeof(struct ibv_qp_init_attr));
 
-			if (!ctx->ah[i]) {
-				fprintf(stderr, "Failed to create AH\n");
+		err = ibv_query_qp(ctx->qp[i], &qp_attr, IBV_QP_AV, &init_attr);
+		if (err)
+			fprintf(stderr, "ibv_query_qp failed to get ah_attr\n");
+		else
+			qp_static_rate = (int)(qp_attr.ah_attr.static_rate);
+
+		//- Fall back to SW Limit only if flag undefined
+		if(err ||
+		   qp_static_rate != user_param->valid_hw_rate_limit_index ||
+		   user_param->link_type != IBV_LINK_LAYER_INFINIBAND) {
+			if(!user_param->is_rate_limit_type) {
+				user_param->rate_limit_type = SW_RATE_LIMIT;
+				fprintf(stderr, "\x1b[31mThe QP failed to accept HW rate limit, providing SW rate limit \x1b[0m\n");
+			} else {
+				fprintf(stderr, "\x1b[31mThe QP failed to accept HW rate limit  \x1b[0m\n");
 				return FAILURE;
 			}
-			user_param->ah_allocated = 1;
 		}
+	}
 
-		if (user_param->rate_limit_type == HW_RATE_LIMIT) {
-			struct ibv_qp_attr qp_attr;
-			struct ibv_qp_init_attr init_attr;
-			int err, qp_static_rate = 0;
+	return SUCCESS;
+}
 
-			memset(&qp_attr,0,sizeof(struct ibv_qp_attr));
-			memset(&init_attr,0,sizeof(struct ibv_qp_init_attr));
+/******************************************************************************
+ *
+ ******************************************************************************/
+int ctx_connect(struct pingpong_context *ctx,
+		struct pingpong_dest *dest,
+		struct perftest_parameters *user_param,
+		struct pingpong_dest *my_dest)
+{
+	struct ctx_connect_args args = { .dest = dest, .my_dest = my_dest };
+	cycles_t start_cycles;
 
-			err = ibv_query_qp(ctx->qp[i], &qp_attr, IBV_QP_AV, &init_attr);
-			if (err)
-				fprintf(stderr, "ibv_query_qp failed to get ah_attr\n");
-			else
-				qp_static_rate = (int)(qp_attr.ah_attr.static_rate);
-
-			//- Fall back to SW Limit only if flag undefined
-			if(err ||
-			   qp_static_rate != user_param->valid_hw_rate_limit_index ||
-			   user_param->link_type != IBV_LINK_LAYER_INFINIBAND) {
-				if(!user_param->is_rate_limit_type) {
-					user_param->rate_limit_type = SW_RATE_LIMIT;
-					fprintf(stderr, "\x1b[31mThe QP failed to accept HW rate limit, providing SW rate limit \x1b[0m\n");
-				} else {
-					fprintf(stderr, "\x1b[31mThe QP failed to accept HW rate limit  \x1b[0m\n");
-					return FAILURE;
-				}
-			}
+	#if defined (HAVE_PACKET_PACING)
+	if (user_param->rate_limit_type == PP_RATE_LIMIT) {
+		if (check_packet_pacing_support(ctx) == FAILURE) {
+			fprintf(stderr, "Packet Pacing isn't supported.\n");
+			return FAILURE;
 		}
+	}
+	#endif
+
+	start_cycles = get_cycles();
+
+	/* The first QP settles the HW rate limit fallback before the rest
+	 * are connected in parallel.
+	 */
+	if (ctx_connect_qp(ctx, user_param, &args, 0))
+		return FAILURE;
+
+	if (run_qp_workers(ctx, user_param, ctx_connect_qp, &args, 1, user_param->num_of_qps, 1))
+		return FAILURE;
+
+	user_param->qp_connect_cycles = get_cycles() - start_cycles;
+	setup_phase_add(SETUP_REPORT(user_param), SETUP_PHASE_CONNECT, start_cycles);
+
+	return SUCCESS;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static int conn_rate_lifecycle(struct pingpong_context *ctx,
+		struct perftest_parameters *user_param, void *arg, int index)
+{
+	struct ctx_connect_args *args = (struct ctx_connect_args*)arg;
+	cycles_t *step_cycles = &user_param->conn_step_cycles[index * CONN_STEPS];
+	cycles_t stamp[CONN_STEPS];
+	struct ibv_qp_attr attr;
+	struct ibv_qp *qp;
+	int i;
+
+	stamp[CONN_STEP_CREATE] = get_cycles();
+	qp = ctx_qp_create(ctx, user_param, 0);
+	if (!qp) {
+		fprintf(stderr, "Couldn't create QP\n");
+		return FAILURE;
+	}
+
+	stamp[CONN_STEP_INIT] = get_cycles();
+	if (ctx_modify_qp_to_init(qp, user_param, 0)) {
+		fprintf(stderr, "Failed to modify QP to INIT\n");
+		goto destroy_qp;
+	}
+
+	memset(&attr, 0, sizeof attr);
+	stamp[CONN_STEP_RTR] = get_cycles();
+	if (ctx_modify_qp_to_rtr(qp, &attr, user_param, args->dest, args->my_dest, 0)) {
+		fprintf(stderr, "Failed to modify QP %d to RTR\n", qp->qp_num);
+		goto destroy_qp;
+	}
 
-		if((user_param->use_xrc || user_param->connection_type == DC) && (user_param->duplex || user_param->tst == LAT))
-			xrc_offset = user_param->num_of_qps / 2;
+	stamp[CONN_STEP_RTS] = get_cycles();
+	if (ctx_modify_qp_to_rts(qp, &attr, user_param, args->dest, args->my_dest)) {
+		fprintf(stderr, "Failed to modify QP to RTS\n");
+		goto destroy_qp;
+	}
 
+	stamp[CONN_STEP_DESTROY] = get_cycles();
+	if (ibv_destroy_qp(qp)) {
+		fprintf(stderr, "Couldn't destroy QP - %s\n", strerror(errno));
+		return FAILURE;
 	}
+	stamp[CONN_STEP_TOTAL] = get_cycles();
+
+	for (i = CONN_STEP_CREATE; i < CONN_STEP_TOTAL; i++)
+		step_cycles[i] = stamp[i + 1] - stamp[i];
+	step_cycles[CONN_STEP_TOTAL] = stamp[CONN_STEP_TOTAL] - stamp[CONN_STEP_CREATE];
+
 	return SUCCESS;
+
+destroy_qp:
+	ibv_destroy_qp(qp);
+	return FAILURE;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+int run_iter_conn_rate(struct pingpong_context *ctx,
+		struct perftest_parameters *user_param,
+		struct pingpong_dest *my_dest, struct pingpong_dest *rem_dest)
+{
+	struct ctx_connect_args args = { .dest = &rem_dest[0], .my_dest = &my_dest[0] };
+	cycles_t start_cycles;
+	int rc;
+
+	ALLOCATE(user_param->conn_step_cycles, cycles_t, user_param->iters * CONN_STEPS);
+	memset(user_param->conn_step_cycles, 0, sizeof(cycles_t) * user_param->iters * CONN_STEPS);
+
+	start_cycles = get_cycles();
+	rc = run_qp_workers(ctx, user_param, conn_rate_lifecycle, &args, 0, user_param->iters, 1);
+	user_param->conn_rate_cycles = get_cycles() - start_cycles;
+
+	if (rc)
+		fprintf(stderr, "Failed to run the connection lifecycles\n");
+
+	return rc;
 }
 
 /******************************************************************************
@@ -3011,6 +4295,10 @@ static void ctx_post_send_work_request_func_pointer(struct pingpong_context *ctx
 		}
 		break;
 	case RC:
+		if (user_param->verb_mix.num) {
+			ctx->new_post_send_work_request_func_pointer = &new_post_mixed_sge_rc;
+			break;
+		}
 		switch (user_param->verb) {
 			case SEND:
 				if (use_enc) {
@@ -3160,6 +4448,91 @@ static void ctx_post_send_work_request_func_pointer(struct pingpong_context *ctx
 /******************************************************************************
  *
  ******************************************************************************/
+/* zipf_zeta.
+ *
+ * Description :
+ *
+ *	The generalized harmonic number of n and theta, summed up to a million
+ *	terms and integrated beyond, so regions of billions of slots set up fast.
+ *
+ */
+static double zipf_zeta(uint64_t n, double theta)
+{
+	uint64_t i, terms = (n < REMOTE_PATTERN_MAX_LEN) ? n : REMOTE_PATTERN_MAX_LEN;
+	double sum = 0;
+
+	for (i = 1; i <= terms; i++)
+		sum += pow((double)i, -theta);
+
+	if (n > terms)
+		sum += (pow(n + 0.5, 1 - theta) - pow(terms + 0.5, 1 - theta)) / (1 - theta);
+
+	return sum;
+}
+
+/* set_remote_pattern.
+ *
+ * Description :
+ *
+ *	Fills the remote offsets of --remote_pattern for each QP, in slots of the
+ *	message size aligned to the cache line. The Zipf ranks are drawn as in
+ *	Gray et al. and hashed over the region, so the hot slots are scattered.
+ *	The first WR of each QP starts from the first offset.
+ *
+ */
+static void set_remote_pattern(struct pingpong_context *ctx, struct perftest_parameters *user_param, int num_of_qps)
+{
+	uint64_t len = ctx->rem_pattern_mask + 1;
+	uint64_t slot = INC(user_param->size, ctx->cache_line_size);
+	uint64_t region = user_param->remote_region ? user_param->remote_region : BUFF_SIZE(ctx->size, ctx->cycle_buffer);
+	uint64_t num_slots = (region - user_param->size) / slot + 1;
+	uint64_t stride = ROUND_UP(user_param->remote_stride, slot);
+	double theta = user_param->remote_zipf_theta;
+	double zetan = 0, alpha = 0, eta = 0, u;
+	uint64_t rng, rank, k, *pattern;
+	int i;
+
+	if (user_param->remote_pattern == REMOTE_PATTERN_ZIPF) {
+		zetan = zipf_zeta(num_slots, theta);
+		alpha = 1 / (1 - theta);
+		eta = (1 - pow(2.0 / num_slots, 1 - theta)) / (1 - zipf_zeta(2, theta) / zetan);
+	}
+
+	for (i = 0; i < num_of_qps; i++) {
+		pattern = &ctx->rem_pattern[i * len];
+		rng = REMOTE_PATTERN_SEED + i;
+
+		for (k = 0; k < len; k++) {
+			switch (user_param->remote_pattern) {
+			case REMOTE_PATTERN_SEQ:
+				pattern[k] = (k % num_slots) * slot;
+				break;
+			case REMOTE_PATTERN_STRIDE:
+				pattern[k] = (k * stride) % (num_slots * slot);
+				break;
+			case REMOTE_PATTERN_RANDOM:
+				pattern[k] = (xorshift64s(&rng) % num_slots) * slot;
+				break;
+			case REMOTE_PATTERN_ZIPF:
+				u = (xorshift64s(&rng) >> 11) * (1.0 / 9007199254740992.0);
+				if (u * zetan < 1)
+					rank = 0;
+				else if (u * zetan < 1 + pow(0.5, theta))
+					rank = 1;
+				else
+					rank = (uint64_t)(num_slots * pow(eta * u - eta + 1, alpha));
+				pattern[k] = ((rank * 0x9E3779B97F4A7C15ULL) % num_slots) * slot;
+				break;
+			}
+		}
+
+		if (user_param->verb == ATOMIC)
+			ctx->wr[i].wr.atomic.remote_addr = ctx->rem_addr[i] + pattern[0];
+		else
+			ctx->wr[i].wr.rdma.remote_addr = ctx->rem_addr[i] + pattern[0];
+	}
+}
+
 void ctx_set_send_reg_wqes(struct pingpong_context *ctx,
 		struct perftest_parameters *user_param,
 		struct pingpong_dest *rem_dest)
@@ -3304,6 +4677,22 @@ void ctx_set_send_reg_wqes(struct pingpong_context *ctx,
 				ctx->wr[i*user_param->post_list + j].qp_type.xrc.remote_srqn = rem_dest[xrc_offset + i].srqn;
 			#endif
 		}
+
+		if (user_param->num_sge > 1) {
+			set_sge_list(ctx, user_param, i, &ctx->sge_list[i*user_param->post_list],
+					&ctx->gather_sge_list[i*user_param->sge]);
+			ctx->wr[i*user_param->post_list].sg_list = &ctx->gather_sge_list[i*user_param->sge];
+			ctx->wr[i*user_param->post_list].num_sge = user_param->num_sge;
+		}
+	}
+
+	if (ctx->rem_pattern)
+		set_remote_pattern(ctx, user_param, num_of_qps);
+
+	/* --verify seals each message at its post, in READ the remote side stamps them. */
+	if (user_param->verify && user_param->verb != READ) {
+		for (i = 0; i < num_of_qps; i++)
+			verify_stamp_region(ctx, user_param, ctx->my_addr[i], 0);
 	}
 }
 
@@ -3335,6 +4724,9 @@ int ctx_set_recv_wqes(struct pingpong_context *ctx,struct perftest_parameters *u
 	if (user_param->verb == WRITE_IMM)
 		length = 0;
 
+	if (ctx->recv_pool)
+		return recv_pool_post(ctx->recv_pool);
+
 	if((user_param->use_xrc || user_param->connection_type == DC) &&
 				(user_param->duplex || user_param->tst == LAT)) {
 
@@ -3358,6 +4750,8 @@ int ctx_set_recv_wqes(struct pingpong_context *ctx,struct perftest_parameters *u
 			ctx->recv_sge_list[i * user_param->recv_post_list].addr += (ctx->cache_line_size - UD_ADDITION);
 
 		ctx->rx_buffer_addr[i] = ctx->recv_sge_list[i * user_param->recv_post_list].addr;
+		if (ctx->rx_posted_cnt)
+			ctx->rx_posted_cnt[i] = 0;
 
 		for (j = 0; j < user_param->recv_post_list; j++) {
 			ctx->recv_sge_list[i * user_param->recv_post_list + j].length = length;
@@ -3385,6 +4779,16 @@ int ctx_set_recv_wqes(struct pingpong_context *ctx,struct perftest_parameters *u
 				ctx->rwr[i * user_param->recv_post_list + j].next = &ctx->rwr[i * user_param->recv_post_list + j + 1];
 		}
 
+		/* The scatter list of --sge splits the receive as the sender gathers it,
+		 * --sge_sizes places the header and the data in separate SGEs.
+		 */
+		if (user_param->num_sge > 1) {
+			set_sge_list(ctx, user_param, i, &ctx->recv_sge_list[i * user_param->recv_post_list],
+					&ctx->scatter_sge_list[i * user_param->sge]);
+			ctx->rwr[i * user_param->recv_post_list].sg_list = &ctx->scatter_sge_list[i * user_param->sge];
+			ctx->rwr[i * user_param->recv_post_list].num_sge = user_param->num_sge;
+		}
+
 		for (j = 0; j < size_per_qp ; ++j) {
 
 			if (user_param->use_srq) {
@@ -3396,6 +4800,9 @@ int ctx_set_recv_wqes(struct pingpong_context *ctx,struct perftest_parameters *u
 
 			} else {
 
+				if (ctx->rx_posted_addr)
+					track_recv_post(ctx, user_param, i, ctx->recv_sge_list[i * user_param->recv_post_list].addr);
+
 				if (ibv_post_recv(ctx->qp[i],&ctx->rwr[i * user_param->recv_post_list],&bad_wr_recv)) {
 					fprintf(stderr, "Couldn't post recv Qp = %d: counter=%d\n",i,j);
 					return 1;
@@ -3575,9 +4982,64 @@ int perform_warm_up(struct pingpong_context *ctx,struct perftest_parameters *use
 		} while (warmindex);
 	}
 
-cleaning:
-	free(wc_for_cleaning);
-	return return_value;
+cleaning:
+	free(wc_for_cleaning);
+	return return_value;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static inline void perf_events_iters_start(struct perftest_parameters *user_param)
+{
+	if (user_param->perf_events_ctx && user_param->test_type == ITERATIONS)
+		perf_events_enable(user_param->perf_events_ctx);
+}
+
+static inline void perf_events_iters_stop(struct perftest_parameters *user_param)
+{
+	if (user_param->perf_events_ctx && user_param->test_type == ITERATIONS)
+		perf_events_disable(user_param->perf_events_ctx);
+}
+
+/* set_verb_mix_wr.
+ *
+ * Description :
+ *
+ *	Turns the WR of a QP into the verb drawn by --verb_mix. The remote address
+ *	is shared by the rdma and atomic layouts, the rkey is moved between them.
+ *
+ */
+static inline void set_verb_mix_wr(struct ibv_send_wr *wr, VerbType verb, uint32_t size)
+{
+	uint32_t rkey = (wr->opcode == IBV_WR_ATOMIC_FETCH_AND_ADD) ?
+		wr->wr.atomic.rkey : wr->wr.rdma.rkey;
+
+	if (verb == ATOMIC) {
+		wr->opcode = IBV_WR_ATOMIC_FETCH_AND_ADD;
+		wr->wr.atomic.rkey = rkey;
+		wr->wr.atomic.compare_add = ATOMIC_ADD_VALUE;
+		wr->sg_list->length = DEF_SIZE_ATOMIC;
+	} else {
+		wr->opcode = opcode_verbs_array[verb];
+		wr->wr.rdma.rkey = rkey;
+		wr->sg_list->length = size;
+	}
+}
+
+/* bw_msg_features.
+ *
+ * Description :
+ *
+ *	Whether an option works on the single messages of the BW loops. The loops
+ *	check it once per run and skip the per message hooks without it.
+ *
+ */
+static inline int bw_msg_features(struct pingpong_context *ctx, struct perftest_parameters *user_param)
+{
+	return user_param->size_dist.num || user_param->verb_mix.num || user_param->sge > 1 ||
+		ctx->rem_pattern || user_param->verify || ctx->copy_buf || ctx->reg_cache ||
+		user_param->touch != TOUCH_NONE || user_param->recv_classes || user_param->seq_track;
 }
 
 /******************************************************************************
@@ -3609,12 +5071,25 @@ int run_iter_bw(struct pingpong_context *ctx,struct perftest_parameters *user_pa
 	uintptr_t		primary_send_addr = ctx->sge_list[0].addr;
 	int			address_offset = 0;
 	int			flows_burst_iter = 0;
+	int			size_class;
+	int			k;
+	struct reg_cache_stats	reg_start = {0};
+	int			track_stalls = user_param->consumer_delay != CONSUMER_DELAY_NONE || user_param->use_credits;
+	int			stalled = 0;
+	uint64_t		round_scnt;
+	cycles_t		stall_start = 0;
+	int			pending_class = -1;
+	/* On with --sge for the single SGE reference pass too, so both passes run the same code. */
+	int			features = bw_msg_features(ctx, user_param);
 
 	#ifdef HAVE_IBV_WR_API
 	if (user_param->connection_type != RawEth)
 		ctx_post_send_work_request_func_pointer(ctx, user_param);
 	#endif
 
+	if (ctx->reg_cache)
+		reg_start = *reg_cache_get_stats(ctx->reg_cache);
+
 	ALLOCATE(wc ,struct ibv_wc ,user_param->cqe_poll);
 	if (user_param->test_type == DURATION) {
 		duration_param=user_param;
@@ -3641,6 +5116,7 @@ int run_iter_bw(struct pingpong_context *ctx,struct perftest_parameters *user_pa
 		goto cleaning;
 	}
 
+	perf_events_iters_start(user_param);
 	if (user_param->test_type == ITERATIONS && user_param->noPeak == ON)
 		user_param->tposted[0] = get_cycles();
 
@@ -3675,6 +5151,8 @@ int run_iter_bw(struct pingpong_context *ctx,struct perftest_parameters *user_pa
 	while (totscnt < tot_iters  || totccnt < tot_iters ||
 		(user_param->test_type == DURATION && user_param->state != END_STATE) ) {
 
+		round_scnt = totscnt;
+
 		/* main loop to run over all the qps and post each time n messages */
 		for (index =0 ; index < num_of_qps ; index++) {
 			if (user_param->rate_limit_type == SW_RATE_LIMIT && is_sending_burst == 0) {
@@ -3695,6 +5173,15 @@ int run_iter_bw(struct pingpong_context *ctx,struct perftest_parameters *user_pa
 					if (swindow >= user_param->rx_depth)
 						break;
 				}
+
+				/* With --recv_classes the next message waits for a QP of its receive class. */
+				if (features && user_param->recv_classes) {
+					if (pending_class < 0)
+						pending_class = size_dist_draw(&user_param->size_dist);
+					if (user_param->size_dist.recv_class[pending_class] != index % user_param->recv_classes)
+						break;
+				}
+
 				if (user_param->post_list == 1 && (ctx->scnt[index] % user_param->cq_mod == 0 && user_param->cq_mod > 1)
 					&& !(ctx->scnt[index] == (user_param->iters - 1) && user_param->test_type == ITERATIONS)) {
 
@@ -3707,6 +5194,44 @@ int run_iter_bw(struct pingpong_context *ctx,struct perftest_parameters *user_pa
 				if (user_param->test_type == DURATION && user_param->state == END_STATE)
 					break;
 
+				if (features) {
+					if (user_param->verb_mix.num) {
+						size_class = verb_mix_draw(&user_param->verb_mix);
+						set_verb_mix_wr(&ctx->wr[index], user_param->verb_mix.verbs[size_class], user_param->size);
+						user_param->verb_mix.msgs[size_class]++;
+					}
+
+					if (user_param->size_dist.num) {
+						if (pending_class >= 0) {
+							size_class = pending_class;
+							pending_class = -1;
+						} else {
+							size_class = size_dist_draw(&user_param->size_dist);
+						}
+						ctx->wr[index].sg_list->length = user_param->size_dist.sizes[size_class];
+						user_param->size_dist.msgs[size_class]++;
+					}
+
+					if (ctx->reg_cache && reg_post_buffer(ctx, user_param, index)) {
+						fprintf(stderr, "Couldn't register the buffer: qp %d scnt=%lu\n", index, ctx->scnt[index]);
+						return_value = FAILURE;
+						goto cleaning;
+					}
+
+					if (ctx->copy_buf && user_param->verb != READ)
+						copy_message(ctx, user_param, index, ctx->my_addr[index],
+							     ctx->wr[index].sg_list->addr, 1);
+
+					if (user_param->touch & TOUCH_TX_WRITE)
+						touch_message(user_param, ctx->wr[index].sg_list->addr, 1, ctx->scnt[index]);
+
+					if (user_param->seq_track)
+						seq_stamp_message(ctx, user_param, index, send_flows_index);
+
+					if (user_param->verify && user_param->verb != READ)
+						verify_stamp_message(ctx, user_param, index);
+				}
+
 				err = post_send_method(ctx, index, user_param);
 				if (err) {
 					fprintf(stderr,"Couldn't post send: qp %d scnt=%lu \n",index,ctx->scnt[index]);
@@ -3726,13 +5251,18 @@ int run_iter_bw(struct pingpong_context *ctx,struct perftest_parameters *user_pa
 					}
 				}
 
+				if (features && ctx->rem_pattern)
+					set_remote_pattern_addr(ctx, index, ctx->scnt[index] + 1);
+
 				/* in multiple flow scenarios we will go to next cycle buffer address in the main buffer*/
 				if (user_param->post_list == 1 && user_param->size <= (ctx->cycle_buffer / 2)) {
+					/* The SGEs of a --sge WR keep their layout, only the remote address moves. */
+					if (!features || user_param->num_sge == 1)
 						increase_loc_addr(ctx->wr[index].sg_list,user_param->size, ctx->scnt[index],
 								ctx->my_addr[index] + address_offset , 0, ctx->cache_line_size,
 								ctx->cycle_buffer);
 
-					if (user_param->verb != SEND) {
+					if (user_param->verb != SEND && !(features && ctx->rem_pattern)) {
 						increase_rem_addr(&ctx->wr[index], user_param->size,
 								ctx->scnt[index], ctx->rem_addr[index], user_param->verb,
 								ctx->cache_line_size, ctx->cycle_buffer);
@@ -3759,6 +5289,20 @@ int run_iter_bw(struct pingpong_context *ctx,struct perftest_parameters *user_pa
 			}
 		}
 
+		/* The sender stalls while no QP can post, its send queue full or out of credits. */
+		if (track_stalls) {
+			if (totscnt == round_scnt && (totscnt < tot_iters || user_param->test_type == DURATION)) {
+				if (!stalled) {
+					stall_start = get_cycles();
+					stalled = 1;
+				}
+			} else if (stalled) {
+				user_param->sender_stall_cycles += get_cycles() - stall_start;
+				user_param->sender_stalls++;
+				stalled = 0;
+			}
+		}
+
 		if (totccnt < tot_iters || (user_param->test_type == DURATION &&  totccnt < totscnt)) {
 				/* Make sure all completions from previous event were polled before waiting for another */
 				if (user_param->use_event && ne == 0) {
@@ -3782,6 +5326,17 @@ int run_iter_bw(struct pingpong_context *ctx,struct perftest_parameters *user_pa
 						if (user_param->fill_count && ctx->ccnt[wc_id] + user_param->cq_mod > user_param->iters) {
 							fill = user_param->iters - ctx->ccnt[wc_id];
 						}
+						if (features) {
+							/* The READs of the completion landed in the slots of the local walk. */
+							if (ctx->copy_buf && user_param->verb == READ) {
+								for (k = 0; k < fill; k++)
+									copy_message(ctx, user_param, wc_id, ctx->my_addr[wc_id], ctx->my_addr[wc_id] +
+										     ((ctx->ccnt[wc_id] + k) % cycle_buffer_slots(ctx, user_param)) *
+										     INC(user_param->size, ctx->cache_line_size), 0);
+							}
+							if (ctx->reg_cache)
+								reg_complete(ctx, user_param, wc_id, ctx->ccnt[wc_id], fill);
+						}
 						ctx->ccnt[wc_id] += fill;
 						totccnt += fill;
 
@@ -3809,32 +5364,445 @@ int run_iter_bw(struct pingpong_context *ctx,struct perftest_parameters *user_pa
 	}
 	if (user_param->noPeak == ON && user_param->test_type == ITERATIONS)
 		user_param->tcompleted[0] = get_cycles();
+	perf_events_iters_stop(user_param);
 
 cleaning:
+	if (ctx->reg_cache) {
+		const struct reg_cache_stats *reg_stats = reg_cache_get_stats(ctx->reg_cache);
+
+		user_param->reg_hits += reg_stats->hits - reg_start.hits;
+		user_param->reg_misses += reg_stats->misses - reg_start.misses;
+		user_param->reg_evictions += reg_stats->evictions - reg_start.evictions;
+	}
+
+	free(wc);
+	return return_value;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+int run_iter_bw_object(struct pingpong_context *ctx, struct perftest_parameters *user_param)
+{
+	uint64_t		chunks = OBJECT_CHUNKS(user_param);
+	uint64_t		last_size = user_param->object_size - (chunks - 1) * user_param->size;
+	int			num_of_qps = user_param->num_of_qps;
+	int			stripes = (chunks < num_of_qps) ? chunks : num_of_qps;
+	uint64_t		*stripe_chunks = NULL, *posted = NULL, *completed = NULL;
+	int			*rank = NULL;
+	cycles_t		*stripe_end = NULL;
+	struct ibv_wc		*wc = NULL;
+	uint64_t		totscnt, totccnt, obj;
+	cycles_t		start, end, stripe_sum;
+	int			index, i, ne, fill, port;
+	int			return_value = SUCCESS;
+
+	#ifdef HAVE_IBV_WR_API
+	ctx_post_send_work_request_func_pointer(ctx, user_param);
+	#endif
+
+	ALLOCATE(wc, struct ibv_wc, user_param->cqe_poll);
+	ALLOCATE(stripe_chunks, uint64_t, num_of_qps);
+	ALLOCATE(posted, uint64_t, num_of_qps);
+	ALLOCATE(completed, uint64_t, num_of_qps);
+	ALLOCATE(rank, int, num_of_qps);
+	ALLOCATE(stripe_end, cycles_t, num_of_qps);
+
+	/* Chunk c of an object goes to the QP of rank c % num_of_qps. With --dualport the
+	 * QPs of the two ports take turns, so an object of fewer chunks still uses both.
+	 */
+	for (index = 0; index < num_of_qps; index++) {
+		rank[index] = user_param->dualport ?
+			(index % (num_of_qps / 2)) * 2 + index / (num_of_qps / 2) : index;
+		stripe_chunks[index] = chunks / num_of_qps + ((uint64_t)rank[index] < chunks % num_of_qps);
+	}
+
+	for (port = 0; port < 2; port++) {
+		user_param->object_port_cycles[port] = 0;
+		user_param->object_port_stripes[port] = 0;
+	}
+
+	perf_events_iters_start(user_param);
+	user_param->tposted[0] = get_cycles();
+
+	for (obj = 0; obj < user_param->iters; obj++) {
+		memset(posted, 0, num_of_qps * sizeof(uint64_t));
+		memset(completed, 0, num_of_qps * sizeof(uint64_t));
+		totscnt = 0;
+		totccnt = 0;
+		start = get_cycles();
+
+		while (totccnt < chunks) {
+			for (index = 0; index < num_of_qps; index++) {
+				while (posted[index] < stripe_chunks[index] &&
+						ctx->scnt[index] < user_param->tx_depth + ctx->ccnt[index]) {
 
+					/* The last chunk of its stripe is always signaled, it ends the stripe. */
+					if ((posted[index] + 1) % user_param->cq_mod == 0 || posted[index] + 1 == stripe_chunks[index])
+						ctx->wr[index].send_flags |= IBV_SEND_SIGNALED;
+					else
+						ctx->wr[index].send_flags &= ~IBV_SEND_SIGNALED;
+
+					if (posted[index] * num_of_qps + rank[index] == chunks - 1)
+						ctx->wr[index].sg_list->length = last_size;
+
+					if (post_send_method(ctx, index, user_param)) {
+						fprintf(stderr,"Couldn't post send: qp %d object %lu chunk %lu\n",
+							index, obj, posted[index] * num_of_qps + rank[index]);
+						return_value = FAILURE;
+						goto cleaning;
+					}
+					ctx->wr[index].sg_list->length = user_param->size;
+
+					if (user_param->size <= (ctx->cycle_buffer / 2)) {
+						increase_loc_addr(ctx->wr[index].sg_list, user_param->size, ctx->scnt[index],
+								ctx->my_addr[index], 0, ctx->cache_line_size, ctx->cycle_buffer);
+						increase_rem_addr(&ctx->wr[index], user_param->size, ctx->scnt[index],
+								ctx->rem_addr[index], user_param->verb, ctx->cache_line_size,
+								ctx->cycle_buffer);
+					}
+
+					posted[index]++;
+					ctx->scnt[index]++;
+					totscnt++;
+				}
+			}
+
+			ne = ibv_poll_cq(ctx->send_cq, user_param->cqe_poll, wc);
+			if (ne < 0) {
+				fprintf(stderr, "poll CQ failed %d\n", ne);
+				return_value = FAILURE;
+				goto cleaning;
+			}
+
+			for (i = 0; i < ne; i++) {
+				index = (int)wc[i].wr_id;
+
+				if (wc[i].status != IBV_WC_SUCCESS) {
+					NOTIFY_COMP_ERROR_SEND(wc[i], totscnt, totccnt);
+					return_value = FAILURE;
+					goto cleaning;
+				}
+
+				/* A completion covers the chunks up to its signaled one. */
+				fill = (stripe_chunks[index] - completed[index] < user_param->cq_mod) ?
+					stripe_chunks[index] - completed[index] : user_param->cq_mod;
+				completed[index] += fill;
+				ctx->ccnt[index] += fill;
+				totccnt += fill;
+
+				if (completed[index] == stripe_chunks[index])
+					stripe_end[index] = get_cycles();
+			}
+		}
+
+		/* The object takes as long as its slowest stripe. */
+		end = start;
+		stripe_sum = 0;
+		for (index = 0; index < num_of_qps; index++) {
+			if (!stripe_chunks[index])
+				continue;
+			if (stripe_end[index] > end)
+				end = stripe_end[index];
+			stripe_sum += stripe_end[index] - start;
+			if (user_param->dualport) {
+				port = user_param->port_by_qp[index];
+				user_param->object_port_cycles[port] += stripe_end[index] - start;
+				user_param->object_port_stripes[port]++;
+			}
+		}
+		user_param->object_cycles[obj] = end - start;
+		user_param->object_tail_cycles[obj] = end - start - stripe_sum / stripes;
+	}
+
+	user_param->tcompleted[0] = get_cycles();
+	perf_events_iters_stop(user_param);
+
+cleaning:
+	free(stripe_end);
+	free(rank);
+	free(completed);
+	free(posted);
+	free(stripe_chunks);
 	free(wc);
 	return return_value;
 }
 
+/******************************************************************************
+ *
+ ******************************************************************************/
+struct autotune_point {
+	int	post_list;
+	int	cq_mod;
+	int	tx_depth;
+	int	inline_size;
+	int	cqe_poll;
+	double	msg_rate;
+};
+
+static void autotune_set_point(struct perftest_parameters *user_param,
+		const struct autotune_point *point)
+{
+	user_param->post_list	= point->post_list;
+	user_param->cq_mod	= point->cq_mod;
+	user_param->tx_depth	= point->tx_depth;
+	user_param->inline_size	= point->inline_size;
+	user_param->cqe_poll	= point->cqe_poll;
+}
+
+/* The same constraints force_dependecies puts on -l, -Q and -t, within the
+ * resources allocated for the test and the iterations of the final run.
+ */
+static int autotune_valid_point(const struct autotune_point *point, int max_tx_depth,
+		int test_type, uint64_t iters)
+{
+	if (point->tx_depth > max_tx_depth || point->post_list > point->tx_depth ||
+			point->cq_mod > point->tx_depth)
+		return 0;
+
+	if (point->post_list > 1 && point->post_list % point->cq_mod)
+		return 0;
+
+	return test_type == DURATION || iters % point->post_list == 0;
+}
+
+/* Runs a point for about AUTOTUNE_SAMPLE_MSEC, the iterations are derived from
+ * the rate of the previous sample, and keeps its message rate in Mpps.
+ */
+static int autotune_sample(struct pingpong_context *ctx, struct perftest_parameters *user_param,
+		struct pingpong_dest *rem_dest, struct autotune_point *point, double *rate_estimate)
+{
+	double cycles_to_units = get_cpu_mhz(user_param->cpu_freq_f);
+	uint64_t step = point->post_list > 1 ? point->post_list : point->cq_mod;
+	uint64_t iters = AUTOTUNE_PROBE_ITERS;
+
+	if (*rate_estimate > 0)
+		iters = *rate_estimate * AUTOTUNE_SAMPLE_MSEC * 1000 / user_param->num_of_qps;
+	if (iters < (uint64_t)point->tx_depth)
+		iters = point->tx_depth;
+
+	autotune_set_point(user_param, point);
+	user_param->iters = (iters + step - 1) / step * step;
+	user_param->fill_count = 0;
+
+	ctx_set_send_wqes(ctx, user_param, rem_dest);
+	if (run_iter_bw(ctx, user_param))
+		return FAILURE;
+
+	point->msg_rate = user_param->iters * user_param->num_of_qps /
+		((user_param->tcompleted[0] - user_param->tposted[0]) / cycles_to_units);
+	*rate_estimate = point->msg_rate;
+
+	if (user_param->output == FULL_VERBOSITY)
+		printf(REPORT_FMT_AUTOTUNE, point->post_list, point->cq_mod, point->tx_depth,
+			point->inline_size, point->cqe_poll, point->msg_rate);
+
+	return SUCCESS;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+int run_autotune(struct pingpong_context *ctx, struct perftest_parameters *user_param,
+		struct pingpong_dest *rem_dest)
+{
+	const int post_list_vals[] = {1, 2, 4, 8, 16, 32};
+	const int cq_mod_vals[] = {1, 2, 4, 8, 16, 32, 64, 128};
+	const int cqe_poll_vals[] = {1, 4, 16, 64};
+	const int tx_depth_div[] = {1, 2, 4, 8};
+	struct autotune_point point, best;
+	uint64_t iters = user_param->iters;
+	int test_type = user_param->test_type;
+	int no_peak = user_param->noPeak;
+	int max_tx_depth = user_param->tx_depth;
+	double rate_estimate = 0;
+	int i, j;
+
+	best.post_list		= user_param->post_list;
+	best.cq_mod		= user_param->cq_mod;
+	best.tx_depth		= user_param->tx_depth;
+	best.inline_size	= user_param->inline_size;
+	best.cqe_poll		= user_param->cqe_poll;
+	best.msg_rate		= 0;
+
+	/* The samples are short iterations runs timed by the first and last
+	 * completions only, on the same QPs as the final run.
+	 */
+	user_param->test_type = ITERATIONS;
+	user_param->noPeak = ON;
+
+	if (user_param->output == FULL_VERBOSITY) {
+		printf(RESULT_LINE);
+		printf("%s\n", RESULT_FMT_AUTOTUNE);
+	}
+
+	/* A grid over the post list and the CQ moderation, that constrain each other. */
+	point = best;
+	for (i = 0; i < GET_ARRAY_SIZE(post_list_vals); i++) {
+		for (j = 0; j < GET_ARRAY_SIZE(cq_mod_vals); j++) {
+			point.post_list = post_list_vals[i];
+			point.cq_mod = cq_mod_vals[j];
+			if (!autotune_valid_point(&point, max_tx_depth, test_type, iters))
+				continue;
+			if (autotune_sample(ctx, user_param, rem_dest, &point, &rate_estimate))
+				return FAILURE;
+			if (point.msg_rate > best.msg_rate)
+				best = point;
+		}
+	}
+
+	/* Then refine the TX depth, the inline and the CQE polling one at a time. */
+	for (i = 1; i < GET_ARRAY_SIZE(tx_depth_div); i++) {
+		point = best;
+		point.tx_depth = max_tx_depth / tx_depth_div[i];
+		if (!autotune_valid_point(&point, max_tx_depth, test_type, iters))
+			continue;
+		if (autotune_sample(ctx, user_param, rem_dest, &point, &rate_estimate))
+			return FAILURE;
+		if (point.msg_rate > best.msg_rate)
+			best = point;
+	}
+
+	if (best.inline_size > 0 && user_param->size <= best.inline_size) {
+		point = best;
+		point.inline_size = 0;
+		if (autotune_sample(ctx, user_param, rem_dest, &point, &rate_estimate))
+			return FAILURE;
+		if (point.msg_rate > best.msg_rate)
+			best = point;
+	}
+
+	for (i = 0; i < GET_ARRAY_SIZE(cqe_poll_vals); i++) {
+		point = best;
+		point.cqe_poll = cqe_poll_vals[i];
+		if (point.cqe_poll == best.cqe_poll)
+			continue;
+		if (autotune_sample(ctx, user_param, rem_dest, &point, &rate_estimate))
+			return FAILURE;
+		if (point.msg_rate > best.msg_rate)
+			best = point;
+	}
+
+	autotune_set_point(user_param, &best);
+	user_param->iters = iters;
+	user_param->test_type = test_type;
+	user_param->noPeak = no_peak;
+
+	user_param->fill_count = 0;
+	if (user_param->test_type == ITERATIONS) {
+		if (user_param->cq_mod >= user_param->tx_depth && user_param->iters % user_param->tx_depth)
+			user_param->fill_count = 1;
+		else if (user_param->cq_mod < user_param->tx_depth && user_param->iters % user_param->cq_mod)
+			user_param->fill_count = 1;
+	}
+
+	printf(RESULT_LINE);
+	printf(" Autotune best: post list %d, CQ moderation %d, TX depth %d, inline %d, CQE poll %d, %.6f Mpps\n",
+		best.post_list, best.cq_mod, best.tx_depth, best.inline_size, best.cqe_poll, best.msg_rate);
+
+	return SUCCESS;
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+void start_duration_window(struct perftest_parameters *user_param)
+{
+	duration_param=user_param;
+	user_param->iters=0;
+	duration_param->state = START_STATE;
+	signal(SIGALRM, catch_alarm);
+	if (user_param->margin > 0)
+		alarm(user_param->margin);
+	else
+		catch_alarm(0);
+}
+
 /******************************************************************************
  *
  ******************************************************************************/
 static inline void set_on_first_rx_packet(struct perftest_parameters *user_param)
 {
 	if (user_param->test_type == DURATION) {
+		start_duration_window(user_param);
+	} else if (user_param->tst == BW) {
+		perf_events_iters_start(user_param);
+		user_param->tposted[0] = get_cycles();
+	}
+}
 
-		duration_param=user_param;
-		user_param->iters=0;
-		duration_param->state = START_STATE;
-		signal(SIGALRM, catch_alarm);
-		if (user_param->margin > 0)
-			alarm(user_param->margin);
+/* Samples a think time of --consumer_delay, in cycles. */
+static cycles_t consumer_think_cycles(struct perftest_parameters *user_param, uint64_t *rng, double cycles_per_usec)
+{
+	double u, usec = user_param->consumer_delay_usec;
+
+	if (user_param->consumer_delay != CONSUMER_DELAY_FIXED) {
+		u = (xorshift64s(rng) >> 11) * (1.0 / (1ULL << 53));
+		if (user_param->consumer_delay == CONSUMER_DELAY_EXP)
+			usec = -user_param->consumer_delay_usec * log(1.0 - u);
 		else
-			catch_alarm(0);
+			usec += u * (user_param->consumer_delay_max_usec - user_param->consumer_delay_usec);
+	}
 
-	} else if (user_param->tst == BW) {
-		user_param->tposted[0] = get_cycles();
+	return (cycles_t)(usec * cycles_per_usec);
+}
+
+/* Reposts a receive buffer --consumer_delay held, the posted-th one of the QP. */
+static int consumer_repost(struct pingpong_context *ctx, struct perftest_parameters *user_param,
+			   int qp_index, uint64_t posted)
+{
+	struct ibv_recv_wr *bad_wr_recv = NULL;
+
+	if (ctx->rx_posted_addr)
+		track_recv_post(ctx, user_param, qp_index, ctx->rwr[qp_index].sg_list->addr);
+	if (ibv_post_recv(ctx->qp[qp_index], &ctx->rwr[qp_index], &bad_wr_recv)) {
+		fprintf(stderr, "Couldn't post recv Qp=%d posted=%lu\n", qp_index, posted);
+		return FAILURE;
+	}
+
+	if (SIZE(user_param->connection_type, user_param->size, !(int)user_param->machine) <= (ctx->cycle_buffer / 2) &&
+			user_param->num_sge == 1) {
+		increase_loc_addr(ctx->rwr[qp_index].sg_list, user_param->size, posted, ctx->rx_buffer_addr[qp_index],
+				  user_param->connection_type, ctx->cache_line_size, ctx->cycle_buffer);
+	}
+	return SUCCESS;
+}
+
+/* Writes the credit of the QP to the sender, once the send queue has room for it. */
+static int send_recv_credit(struct pingpong_context *ctx, struct perftest_parameters *user_param, int qp_index,
+			    uint64_t credit, long *scredit_for_qp, int *tot_scredit, struct ibv_wc *swc)
+{
+	struct ibv_send_wr *bad_wr = NULL;
+	int sne = 0, j = 0;
+
+	ctx->ctrl_buf[qp_index] = credit;
+
+	while (scredit_for_qp[qp_index] == user_param->tx_depth) {
+		sne = ibv_poll_cq(ctx->send_cq,user_param->tx_depth,swc);
+		if (sne > 0) {
+			for (j = 0; j < sne; j++) {
+				if (swc[j].status != IBV_WC_SUCCESS) {
+					fprintf(stderr, "Poll send CQ error status=%u qp %d credit=%lu scredit=%ld\n",
+							swc[j].status,(int)swc[j].wr_id,
+							credit,scredit_for_qp[swc[j].wr_id]);
+					return FAILURE;
+				}
+				scredit_for_qp[swc[j].wr_id]--;
+				(*tot_scredit)--;
+			}
+		} else if (sne < 0) {
+			fprintf(stderr, "Poll send CQ failed ne=%d\n",sne);
+			return FAILURE;
+		}
+	}
+	if (ibv_post_send(ctx->qp[qp_index],&ctx->ctrl_wr[qp_index],&bad_wr)) {
+		fprintf(stderr,"Couldn't post send qp %d credit = %lu\n",
+				qp_index,credit);
+		return FAILURE;
 	}
+	scredit_for_qp[qp_index]++;
+	(*tot_scredit)++;
+	return SUCCESS;
 }
 
 /******************************************************************************
@@ -3854,13 +5822,26 @@ int run_iter_bw_server(struct pingpong_context *ctx, struct perftest_parameters
 	struct ibv_wc 		*swc = NULL;
 	long 			*scredit_for_qp = NULL;
 	int 			tot_scredit = 0;
-	int 			firstRx = 1;
+	int 			firstRx;
 	int 			return_value = 0;
 	int			wc_id;
 	int			recv_flows_index = 0;
 	uintptr_t		primary_recv_addr = ctx->recv_sge_list[0].addr;
 	int			recv_flows_burst = 0;
 	int			address_flows_offset =0;
+	cycles_t		*held_due = NULL;
+	cycles_t		*held_arrival = NULL;
+	uint64_t		*held_head = NULL;
+	uint64_t		*held_cnt = NULL;
+	uint64_t		*released_per_qp = NULL;
+	uint64_t		consumer_rng = CONSUMER_DELAY_SEED;
+	double			cycles_per_usec = 0;
+	cycles_t		now;
+	unsigned long long	rnr_start = 0, rnr_end = 0;
+	int			rnr_valid = 0;
+	uint64_t		slot;
+	int			size_class;
+	int			features = bw_msg_features(ctx, user_param);
 
 	#ifdef HAVE_IBV_WR_API
 	if (user_param->connection_type != RawEth)
@@ -3886,8 +5867,28 @@ int run_iter_bw_server(struct pingpong_context *ctx, struct perftest_parameters
 	for (i = 0; i < user_param->num_of_qps; i++)
 		posted_per_qp[i] = ctx->rposted;
 
+	/* --consumer_delay holds the completed receive buffers of a QP in arrival order,
+	 * each one until its think time has passed.
+	 */
+	if (user_param->consumer_delay != CONSUMER_DELAY_NONE) {
+		ALLOCATE(held_due, cycles_t, user_param->num_of_qps * user_param->rx_depth);
+		ALLOCATE(held_arrival, cycles_t, user_param->num_of_qps * user_param->rx_depth);
+		ALLOCATE(held_head, uint64_t, user_param->num_of_qps);
+		memset(held_head, 0, sizeof(uint64_t) * user_param->num_of_qps);
+		ALLOCATE(held_cnt, uint64_t, user_param->num_of_qps);
+		memset(held_cnt, 0, sizeof(uint64_t) * user_param->num_of_qps);
+		ALLOCATE(released_per_qp, uint64_t, user_param->num_of_qps);
+		memset(released_per_qp, 0, sizeof(uint64_t) * user_param->num_of_qps);
+		cycles_per_usec = get_cpu_mhz(user_param->cpu_freq_f);
+		rnr_valid = !counters_read_value(user_param->ib_devname, user_param->ib_port,
+						 CONSUMER_RNR_COUNTER, &rnr_start);
+	}
+
 	tot_iters = (uint64_t)user_param->iters*user_param->num_of_qps;
 
+	/* A window the caller already started with start_duration_window isn't restarted. */
+	firstRx = user_param->test_type != DURATION || user_param->state == START_STATE;
+
 	if (user_param->test_type == ITERATIONS) {
 		check_alive_data.is_events = user_param->use_event;
 		signal(SIGALRM, check_alive);
@@ -3898,6 +5899,35 @@ int run_iter_bw_server(struct pingpong_context *ctx, struct perftest_parameters
 
 	while (rcnt < tot_iters || (user_param->test_type == DURATION && user_param->state != END_STATE)) {
 
+		if (held_due) {
+			now = get_cycles();
+			for (i = 0; i < user_param->num_of_qps; i++) {
+				while (held_cnt[i] && held_due[i * user_param->rx_depth + held_head[i]] <= now) {
+					user_param->consumer_hold_cycles += now - held_arrival[i * user_param->rx_depth + held_head[i]];
+					user_param->consumer_released++;
+					held_head[i] = (held_head[i] + 1) % user_param->rx_depth;
+					held_cnt[i]--;
+					released_per_qp[i]++;
+
+					if (user_param->test_type == DURATION || posted_per_qp[i] + 1 <= user_param->iters) {
+						if (consumer_repost(ctx, user_param, i, posted_per_qp[i])) {
+							return_value = 15;
+							goto cleaning;
+						}
+						posted_per_qp[i]++;
+					}
+
+					/* The credits count the buffers returned to the receive queue. */
+					if (ctx->send_rcredit && (released_per_qp[i] % user_param->rx_depth) % ctx->credit_cnt == 0 &&
+							send_recv_credit(ctx, user_param, i, released_per_qp[i],
+									 scredit_for_qp, &tot_scredit, swc)) {
+						return_value = FAILURE;
+						goto cleaning;
+					}
+				}
+			}
+		}
+
 		if (user_param->use_event) {
 			if (ctx_notify_events(ctx->recv_channel)) {
 				fprintf(stderr ," Failed to notify events to CQ\n");
@@ -3919,6 +5949,29 @@ int run_iter_bw_server(struct pingpong_context *ctx, struct perftest_parameters
 				}
 
 				for (i = 0; i < ne; i++) {
+					/* The WR ID of a pool receive is its buffer, repost it to the SRQ of its class. */
+					if (features && ctx->recv_pool) {
+						if (wc[i].status != IBV_WC_SUCCESS) {
+							NOTIFY_COMP_ERROR_RECV(wc[i],rcnt);
+							return_value = FAILURE;
+							goto cleaning;
+						}
+						rcnt++;
+						check_alive_data.current_totrcnt = rcnt;
+
+						size_class = recv_pool_repost(ctx->recv_pool, &wc[i]);
+						if (size_class < 0) {
+							return_value = 15;
+							goto cleaning;
+						}
+						if (user_param->state == SAMPLE_STATE) {
+							user_param->recv_class_msgs[size_class]++;
+							user_param->recv_class_bytes[size_class] += wc[i].byte_len;
+							user_param->iters++;
+						}
+						continue;
+					}
+
 					wc_id = (int)wc[i].wr_id;
 					if (wc[i].status != IBV_WC_SUCCESS) {
 
@@ -3926,6 +5979,16 @@ int run_iter_bw_server(struct pingpong_context *ctx, struct perftest_parameters
 						return_value = FAILURE;
 						goto cleaning;
 					}
+					if (features) {
+						if (user_param->verify)
+							verify_recv_completion(ctx, user_param, wc_id, rcnt_for_qp[wc_id]);
+						if (user_param->seq_track)
+							ctx_seq_track_recv(ctx, user_param, wc_id, rcnt_for_qp[wc_id]);
+						if (ctx->copy_buf)
+							copy_recv_completion(ctx, user_param, wc_id, rcnt_for_qp[wc_id]);
+						if (user_param->touch & TOUCH_RX_READ)
+							touch_recv_completion(ctx, user_param, wc_id, rcnt_for_qp[wc_id]);
+					}
 					rcnt_for_qp[wc_id]++;
 					rcnt++;
 					unused_recv_for_qp[wc_id]++;
@@ -3937,8 +6000,13 @@ int run_iter_bw_server(struct pingpong_context *ctx, struct perftest_parameters
 						}
 						user_param->iters++;
 					}
+					if (held_due) {
+						now = get_cycles();
+						slot = wc_id * user_param->rx_depth + (held_head[wc_id] + held_cnt[wc_id]++) % user_param->rx_depth;
+						held_arrival[slot] = now;
+						held_due[slot] = now + consumer_think_cycles(user_param, &consumer_rng, cycles_per_usec);
 					//coverity[uninit_use]
-					if ((user_param->test_type==DURATION || posted_per_qp[wc_id] + user_param->recv_post_list <= user_param->iters) &&
+					} else if ((user_param->test_type==DURATION || posted_per_qp[wc_id] + user_param->recv_post_list <= user_param->iters) &&
 					    unused_recv_for_qp[wc_id] >= user_param->recv_post_list && !user_param->use_unsolicited_write) {
 						if (user_param->use_srq) {
 							if (ibv_post_srq_recv(ctx->srq, &ctx->rwr[wc_id * user_param->recv_post_list], &bad_wr_recv)) {
@@ -3948,6 +6016,8 @@ int run_iter_bw_server(struct pingpong_context *ctx, struct perftest_parameters
 							}
 
 						} else {
+							if (ctx->rx_posted_addr)
+								track_recv_post(ctx, user_param, wc_id, ctx->rwr[wc_id * user_param->recv_post_list].sg_list->addr);
 							if (ibv_post_recv(ctx->qp[wc_id], &ctx->rwr[wc_id * user_param->recv_post_list], &bad_wr_recv)) {
 								fprintf(stderr, "Couldn't post recv Qp=%d rcnt=%lu\n",wc_id,rcnt_for_qp[wc_id]);
 								return_value = 15;
@@ -3966,7 +6036,7 @@ int run_iter_bw_server(struct pingpong_context *ctx, struct perftest_parameters
 							}
 						}
 						if (SIZE(user_param->connection_type,user_param->size,!(int)user_param->machine) <= (ctx->cycle_buffer / 2) &&
-								user_param->recv_post_list == 1) {
+								user_param->recv_post_list == 1 && user_param->num_sge == 1) {
 							increase_loc_addr(ctx->rwr[wc_id].sg_list,
 									user_param->size,
 									posted_per_qp[wc_id],
@@ -3976,42 +6046,14 @@ int run_iter_bw_server(struct pingpong_context *ctx, struct perftest_parameters
 						posted_per_qp[wc_id] += user_param->recv_post_list;
 					}
 
-					if (ctx->send_rcredit) {
+					if (ctx->send_rcredit && !held_due) {
 						int credit_cnt = rcnt_for_qp[wc_id]%user_param->rx_depth;
 
-						if (credit_cnt%ctx->credit_cnt == 0) {
-							struct ibv_send_wr *bad_wr = NULL;
-							int sne = 0, j = 0;
-							ctx->ctrl_buf[wc_id] = rcnt_for_qp[wc_id];
-
-							while (scredit_for_qp[wc_id] == user_param->tx_depth) {
-								sne = ibv_poll_cq(ctx->send_cq,user_param->tx_depth,swc);
-								if (sne > 0) {
-									for (j = 0; j < sne; j++) {
-										if (swc[j].status != IBV_WC_SUCCESS) {
-											fprintf(stderr, "Poll send CQ error status=%u qp %d credit=%lu scredit=%ld\n",
-													swc[j].status,(int)swc[j].wr_id,
-													rcnt_for_qp[swc[j].wr_id],scredit_for_qp[swc[j].wr_id]);
-											return_value = FAILURE;
-											goto cleaning;
-										}
-										scredit_for_qp[swc[j].wr_id]--;
-										tot_scredit--;
-									}
-								} else if (sne < 0) {
-									fprintf(stderr, "Poll send CQ failed ne=%d\n",sne);
-									return_value = FAILURE;
-									goto cleaning;
-								}
-							}
-							if (ibv_post_send(ctx->qp[wc_id],&ctx->ctrl_wr[wc_id],&bad_wr)) {
-								fprintf(stderr,"Couldn't post send qp %d credit = %lu\n",
-										wc_id,rcnt_for_qp[wc_id]);
-								return_value = FAILURE;
-								goto cleaning;
-							}
-							scredit_for_qp[wc_id]++;
-							tot_scredit++;
+						if (credit_cnt%ctx->credit_cnt == 0 &&
+								send_recv_credit(ctx, user_param, wc_id, rcnt_for_qp[wc_id],
+										 scredit_for_qp, &tot_scredit, swc)) {
+							return_value = FAILURE;
+							goto cleaning;
 						}
 					}
 				}
@@ -4035,6 +6077,7 @@ int run_iter_bw_server(struct pingpong_context *ctx, struct perftest_parameters
 	}
 	if (user_param->test_type == ITERATIONS)
 		user_param->tcompleted[0] = get_cycles();
+	perf_events_iters_stop(user_param);
 
 cleaning:
 	if (ctx->send_rcredit) {
@@ -4042,6 +6085,12 @@ cleaning:
 			return_value = FAILURE;
 	}
 
+	/* The receive drops for lack of a WQE of the port, an RNR NAK each on RC. */
+	if (rnr_valid && !counters_read_value(user_param->ib_devname, user_param->ib_port,
+					      CONSUMER_RNR_COUNTER, &rnr_end))
+		user_param->consumer_rnr_naks = rnr_end - rnr_start;
+
+	user_param->recv_total = rcnt;
 	check_alive_data.last_totrcnt=0;
 	free(wc);
 	free(rcnt_for_qp);
@@ -4049,6 +6098,11 @@ cleaning:
 	free(scredit_for_qp);
 	free(unused_recv_for_qp);
 	free(posted_per_qp);
+	free(held_due);
+	free(held_arrival);
+	free(held_head);
+	free(held_cnt);
+	free(released_per_qp);
 
 	return return_value;
 }
@@ -4371,6 +6425,7 @@ int run_iter_bi(struct pingpong_context *ctx,
 	for (i = 0; i < user_param->num_of_qps; i++)
 		posted_per_qp[i] = ctx->rposted;
 
+	perf_events_iters_start(user_param);
 	if (user_param->noPeak == ON)
 		user_param->tposted[0] = get_cycles();
 
@@ -4642,6 +6697,7 @@ int run_iter_bi(struct pingpong_context *ctx,
 	if (user_param->noPeak == ON && user_param->test_type == ITERATIONS) {
 		user_param->tcompleted[0] = get_cycles();
 	}
+	perf_events_iters_stop(user_param);
 
 	if (ctx->send_rcredit) {
 		if (clean_scq_credit(tot_scredit, ctx, user_param)) {
@@ -4674,6 +6730,8 @@ int run_iter_lat_write(struct pingpong_context *ctx,struct perftest_parameters *
 	int 			poll_buf_offset = 0;
 	volatile char           *poll_buf = NULL;
 	volatile char           *post_buf = NULL;
+	volatile char           *poll_base = NULL;
+	struct size_dist        *dist = &user_param->size_dist;
 
 
 	struct ibv_wc           wc;
@@ -4699,7 +6757,8 @@ int run_iter_lat_write(struct pingpong_context *ctx,struct perftest_parameters *
 		poll_buf_offset = 1;
 
 	post_buf = (char*)ctx->buf[0] + user_param->size - 1;
-	poll_buf = (char*)ctx->buf[0] + (user_param->num_of_qps + poll_buf_offset)*BUFF_SIZE(ctx->size, ctx->cycle_buffer) + user_param->size - 1;
+	poll_base = (char*)ctx->buf[0] + (user_param->num_of_qps + poll_buf_offset)*BUFF_SIZE(ctx->size, ctx->cycle_buffer);
+	poll_buf = poll_base + user_param->size - 1;
 
 	/* Duration support in latency tests. */
 	if (user_param->test_type == DURATION) {
@@ -4714,12 +6773,22 @@ int run_iter_lat_write(struct pingpong_context *ctx,struct perftest_parameters *
 	}
 
 	/* Done with setup. Start the test. */
+	perf_events_iters_start(user_param);
 	while (scnt < user_param->iters || ccnt < user_param->iters || rcnt < user_param->iters
 			|| ((user_param->test_type == DURATION && user_param->state != END_STATE))) {
 
 		if ((rcnt < user_param->iters || user_param->test_type == DURATION) && !(scnt < 1 && user_param->machine == SERVER)) {
+			if (dist->num)
+				poll_buf = poll_base + dist->sizes[dist->classes[rcnt]] - 1;
+
 			rcnt++;
 			while (*poll_buf != (char)rcnt && user_param->state != END_STATE);
+
+			/* The marker of the next size may hold a stale copy from a larger
+			 * message, the peer doesn't write before we reply so reset it.
+			 */
+			if (dist->num && rcnt < user_param->iters)
+				poll_base[dist->sizes[dist->classes[rcnt]] - 1] = (char)rcnt;
 		}
 
 		if (scnt < user_param->iters || user_param->test_type == DURATION) {
@@ -4732,6 +6801,11 @@ int run_iter_lat_write(struct pingpong_context *ctx,struct perftest_parameters *
 				}
 			}
 
+			if (dist->num) {
+				ctx->wr[0].sg_list->length = dist->sizes[dist->classes[scnt]];
+				post_buf = (char*)ctx->buf[0] + ctx->wr[0].sg_list->length - 1;
+			}
+
 			if (user_param->test_type == ITERATIONS)
 				user_param->tposted[scnt] = get_cycles();
 
@@ -4770,6 +6844,7 @@ int run_iter_lat_write(struct pingpong_context *ctx,struct perftest_parameters *
 			}
 		}
 	}
+	perf_events_iters_stop(user_param);
 	return 0;
 }
 
@@ -4822,6 +6897,7 @@ int run_iter_lat_write_imm(struct pingpong_context *ctx,struct perftest_paramete
 	}
 
 	/* Done with setup. Start the test. */
+	perf_events_iters_start(user_param);
 	while (scnt < user_param->iters || ccnt < user_param->iters || rcnt < user_param->iters
 			|| ((user_param->test_type == DURATION && user_param->state != END_STATE))) {
 
@@ -4909,6 +6985,7 @@ int run_iter_lat_write_imm(struct pingpong_context *ctx,struct perftest_paramete
 			}
 		}
 	}
+	perf_events_iters_stop(user_param);
 	return 0;
 }
 
@@ -4944,6 +7021,7 @@ int run_iter_lat(struct pingpong_context *ctx,struct perftest_parameters *user_p
 		else
 			catch_alarm(0);
 	}
+	perf_events_iters_start(user_param);
 	while (scnt < user_param->iters || (user_param->test_type == DURATION && user_param->state != END_STATE)) {
 		if (user_param->latency_gap) {
 			start_gap = get_cycles();
@@ -4952,6 +7030,9 @@ int run_iter_lat(struct pingpong_context *ctx,struct perftest_parameters *user_p
 				continue;
 			}
 		}
+		if (user_param->size_dist.num)
+			ctx->wr[0].sg_list->length = user_param->size_dist.sizes[user_param->size_dist.classes[scnt]];
+
 		if (user_param->test_type == ITERATIONS)
 			user_param->tposted[scnt++] = get_cycles();
 
@@ -4991,6 +7072,7 @@ int run_iter_lat(struct pingpong_context *ctx,struct perftest_parameters *user_p
 		} while (!user_param->use_event && ne == 0);
 	}
 
+	perf_events_iters_stop(user_param);
 	return 0;
 }
 
@@ -5030,6 +7112,7 @@ int run_iter_lat_send(struct pingpong_context *ctx,struct perftest_parameters *u
 	if (user_param->size <= user_param->inline_size) {
 		ctx->wr[0].send_flags |= IBV_SEND_INLINE;
 	}
+	perf_events_iters_start(user_param);
 	while (scnt < user_param->iters || rcnt < user_param->iters ||
 			( (user_param->test_type == DURATION && user_param->state != END_STATE))) {
 
@@ -5062,6 +7145,10 @@ int run_iter_lat_send(struct pingpong_context *ctx,struct perftest_parameters *u
 						return 1;
 					}
 
+					/* The receives of the latency test all land at the start of the receive buffer. */
+					if (user_param->touch & TOUCH_RX_READ)
+						touch_message(user_param, ctx->rwr[wc.wr_id].sg_list->addr, 0, rcnt);
+
 					rcnt++;
 
 					if (user_param->test_type == DURATION && user_param->state == SAMPLE_STATE)
@@ -5110,6 +7197,9 @@ int run_iter_lat_send(struct pingpong_context *ctx,struct perftest_parameters *u
 				}
 			}
 
+			if (user_param->size_dist.num)
+				ctx->wr[0].sg_list->length = user_param->size_dist.sizes[user_param->size_dist.classes[scnt]];
+
 			if (user_param->test_type == ITERATIONS)
 				user_param->tposted[scnt] = get_cycles();
 
@@ -5124,6 +7214,9 @@ int run_iter_lat_send(struct pingpong_context *ctx,struct perftest_parameters *u
 			if (user_param->test_type == DURATION && user_param->state == END_STATE)
 				break;
 
+			if (user_param->touch & TOUCH_TX_WRITE)
+				touch_message(user_param, ctx->wr[0].sg_list->addr, 1, scnt);
+
 			/* send the packet that's in index 0 on the buffer */
 			err = post_send_method(ctx, 0, user_param);
 
@@ -5172,6 +7265,7 @@ int run_iter_lat_send(struct pingpong_context *ctx,struct perftest_parameters *u
 		}
 	}
 
+	perf_events_iters_stop(user_param);
 	return 0;
 }
 /******************************************************************************
@@ -5425,12 +7519,16 @@ void catch_alarm(int sig)
 		case START_STATE:
 			duration_param->state = SAMPLE_STATE;
 			get_cpu_stats(duration_param,1);
+			if (duration_param->perf_events_ctx)
+				perf_events_enable(duration_param->perf_events_ctx);
 			duration_param->tposted[0] = get_cycles();
 			alarm(duration_param->duration - 2*(duration_param->margin));
 			break;
 		case SAMPLE_STATE:
 			duration_param->state = STOP_SAMPLE_STATE;
 			duration_param->tcompleted[0] = get_cycles();
+			if (duration_param->perf_events_ctx)
+				perf_events_disable(duration_param->perf_events_ctx);
 			get_cpu_stats(duration_param,2);
 			if (duration_param->margin > 0)
 				alarm(duration_param->margin);
@@ -5627,11 +7725,17 @@ int rdma_cm_allocate_nodes(struct pingpong_context *ctx,
 	memset(ctx->cma_master.nodes, 0,
 		(sizeof *ctx->cma_master.nodes) * user_param->num_of_qps);
 
+	ALLOCATE(ctx->cma_master.pending_nodes, int, user_param->num_of_qps);
+	ctx->cma_master.pending_head = 0;
+	ctx->cma_master.pending_tail = 0;
+	ctx->cma_master.connects_in_flight = 0;
+
 	for (i = 0; i < user_param->num_of_qps; i++) {
 		ctx->cma_master.nodes[i].id = i;
 		if (user_param->machine == CLIENT) {
 			rc = rdma_create_id(ctx->cma_master.channel,
-				&ctx->cma_master.nodes[i].cma_id, NULL, hints->ai_port_space);
+				&ctx->cma_master.nodes[i].cma_id, &ctx->cma_master.nodes[i],
+				hints->ai_port_space);
 			if (rc) {
 				error_message = "Failed to create RDMA CM ID.";
 				goto error;
@@ -5685,6 +7789,7 @@ error:
 	}
 
 	free(ctx->cma_master.nodes);
+	free(ctx->cma_master.pending_nodes);
 	return error_handler(error_message);
 }
 
@@ -5730,6 +7835,7 @@ int rdma_cm_destroy_cma(struct pingpong_context *ctx,
 	}
 
 	free(ctx->cma_master.nodes);
+	free(ctx->cma_master.pending_nodes);
 	return rc;
 
 error:
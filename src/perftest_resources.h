@@ -73,6 +73,9 @@
 #include <netdb.h>
 #include <fcntl.h>
 #include "perftest_parameters.h"
+#include "perftest_reg_cache.h"
+#include "perftest_recv_pool.h"
+#include "perftest_seq_track.h"
 
 #define NUM_OF_RETRIES		(10)
 
@@ -80,6 +83,8 @@
 #define MAX_SEND_SGE		(1)
 #define MAX_RECV_SGE		(1)
 #define CTX_POLL_BATCH		(16)
+#define BUF_INIT_MIN_CHUNK	(64 * 1024 * 1024)
+#define BUF_INIT_MAX_THREADS	(16)
 #define CTX_POLL_BATCH_INTENSE	(64)
 #define CQE_POLL_INTENSE_NUM_QPS_THRESHOLD		(2048)
 #define CQE_POLL_INTENSE_MSG_SIZE_THRESHOLD		(8192)
@@ -156,6 +161,12 @@ struct cma_node {
 	uint32_t remote_qkey;
 	int id;
 	int connected;
+	/* Per-phase timestamps of the client connection setup */
+	cycles_t addr_start;
+	cycles_t addr_resolved;
+	cycles_t route_resolved;
+	cycles_t connect_start;
+	cycles_t established;
 };
 
 /* Represents RDMA CM management needed information */
@@ -166,6 +177,11 @@ struct cma {
 	int connection_index;
 	int connects_left;
 	int disconnects_left;
+	int connects_in_flight;
+	/* Nodes with a resolved route waiting for a connect slot */
+	int *pending_nodes;
+	int pending_head;
+	int pending_tail;
 };
 
 struct pingpong_context {
@@ -203,6 +219,21 @@ struct pingpong_context {
 	struct ibv_srq				*srq;
 	struct ibv_sge				*sge_list;
 	struct ibv_sge				*recv_sge_list;
+	struct ibv_sge				*gather_sge_list;
+	struct ibv_sge				*scatter_sge_list;
+	struct ibv_mr				**sge_mr;
+	uint64_t				*rem_pattern;
+	uint64_t				rem_pattern_mask;
+	uint64_t				*rx_posted_addr;
+	uint64_t				*rx_posted_cnt;
+	void					*copy_buf;
+	void					*reg_pool_buf;
+	uint64_t				reg_pool_stride;	/* A buffer of the pool, rounded up to pages. */
+	struct reg_cache			*reg_cache;
+	struct reg_cache_entry			**reg_inflight;
+	uint64_t				reg_pool_next;
+	uint32_t				reg_rand_state;
+	struct recv_pool			*recv_pool;
 	struct ibv_send_wr			*wr;
 	struct ibv_recv_wr			*rwr;
 	uint64_t				size;
@@ -227,7 +258,7 @@ struct pingpong_context {
 	int                                     send_rcredit;
 	int                                     credit_cnt;
 	int					cache_line_size;
-	int					cycle_buffer;
+	uint64_t				cycle_buffer;
 	int					rposted;
 	#ifdef HAVE_XRCD
 	struct ibv_xrcd				*xrc_domain;
@@ -588,6 +619,48 @@ int ctx_set_credit_wqes(struct pingpong_context *ctx,
  */
 int run_iter_bw(struct pingpong_context *ctx,struct perftest_parameters *user_param);
 
+/* run_iter_bw_object.
+ *
+ * Description :
+ *
+ *	The BW test of --object_size, -n objects transferred one after the other.
+ *	Each object is split in chunks of the message size, striped round robin
+ *	over the QPs, and timed from its first post to the last completion of its
+ *	slowest stripe.
+ *
+ * Parameters :
+ *
+ *	ctx     - Test Context.
+ *	user_param  - user_parameters struct for this test.
+ *
+ * Return Value : SUCCESS, FAILURE.
+ *
+ */
+int run_iter_bw_object(struct pingpong_context *ctx, struct perftest_parameters *user_param);
+
+/* run_autotune.
+ *
+ * Description :
+ *
+ *	Searches the post list, CQ moderation, TX depth, inline and CQE poll
+ *	that give the best message rate of run_iter_bw, on the connected QPs.
+ *	A grid over the post list and CQ moderation is refined one parameter
+ *	at a time, each point is a short sample re-posted with ctx_set_send_wqes.
+ *	The TX depth and inline size of the QPs are the upper bounds.
+ *	Leaves the best configuration in user_param for the final run.
+ *
+ * Parameters :
+ *
+ *	ctx     - Test Context.
+ *	user_param  - user_parameters struct for this test.
+ *	rem_dest    - pingpong_dest struct of the remote side.
+ *
+ * Return Value : SUCCESS, FAILURE.
+ *
+ */
+int run_autotune(struct pingpong_context *ctx, struct perftest_parameters *user_param,
+		struct pingpong_dest *rem_dest);
+
 /* run_iter_bw_infinitely
  *
  * Description :
@@ -630,6 +703,42 @@ int run_iter_bw_infinitely_server(struct pingpong_context *ctx, struct perftest_
  */
 int run_iter_bw_server(struct pingpong_context *ctx, struct perftest_parameters *user_param);
 
+/* ctx_verify_bw.
+ *
+ * Description :
+ *
+ *	Checks the last message that landed in every slot of the cycle buffer
+ *	after a --verify run: the receive halves on the target of WRITE, which
+ *	hold the last message sent to each slot, the local buffer on the
+ *	initiator of READ, which holds the slot stamps of the remote side.
+ *
+ * Parameters :
+ *
+ *	ctx     - Test Context.
+ *	user_param  - user_parameters struct for this test.
+ *
+ * Return Value : SUCCESS, FAILURE if a message doesn't match.
+ */
+int ctx_verify_bw(struct pingpong_context *ctx, struct perftest_parameters *user_param);
+
+/* ctx_seq_track_recv.
+ *
+ * Description :
+ *
+ *	Reads the --seq_track stamp of the index-th receive completion of the
+ *	QP and accounts it to the tracker of its flow.
+ *
+ * Parameters :
+ *
+ *	ctx     - Test Context.
+ *	user_param  - user_parameters struct for this test.
+ *	qp_index - The QP the message came on.
+ *	index - The receive completions of the QP before this one.
+ *
+ */
+void ctx_seq_track_recv(struct pingpong_context *ctx, struct perftest_parameters *user_param,
+			int qp_index, uint64_t index);
+
 /* run_iter_bi.
  *
  * Description :
@@ -771,7 +880,7 @@ static __inline int ctx_notify_events(struct ibv_comp_channel *channel)
 	return 0;
 }
 
-static __inline void increase_rem_addr(struct ibv_send_wr *wr,int size,uint64_t scnt,uint64_t prim_addr,VerbType verb, int cache_line_size, int cycle_buffer)
+static __inline void increase_rem_addr(struct ibv_send_wr *wr,int size,uint64_t scnt,uint64_t prim_addr,VerbType verb, int cache_line_size, uint64_t cycle_buffer)
 {
 	if (verb == ATOMIC)
 		wr->wr.atomic.remote_addr += INC(size,cache_line_size);
@@ -837,7 +946,7 @@ static __inline int ctx_notify_send_recv_events(struct pingpong_context *ctx)
  *		prim_addr - The address of the original buffer.
  *		server_is_ud - Indication to weather we are in UD mode.
  */
-static __inline void increase_loc_addr(struct ibv_sge *sg,int size,uint64_t rcnt,uint64_t prim_addr,int server_is_ud, int cache_line_size, int cycle_buffer)
+static __inline void increase_loc_addr(struct ibv_sge *sg,int size,uint64_t rcnt,uint64_t prim_addr,int server_is_ud, int cache_line_size, uint64_t cycle_buffer)
 {
 	sg->addr  += INC(size,cache_line_size);
 
@@ -846,6 +955,23 @@ static __inline void increase_loc_addr(struct ibv_sge *sg,int size,uint64_t rcnt
 
 }
 
+/* track_recv_post.
+ *
+ * Description :
+ * 	Remembers where a receive was posted, they complete in order on the QP.
+ *
+ * Parameters :
+ *		ctx - Test Context, with the rx_posted_addr ring allocated.
+ *		user_param - user_parameters struct for this test.
+ *		qp_index - The QP the receive is posted on.
+ *		addr - The address of the receive buffer.
+ */
+static __inline void track_recv_post(struct pingpong_context *ctx, struct perftest_parameters *user_param,
+				     int qp_index, uint64_t addr)
+{
+	ctx->rx_posted_addr[qp_index * user_param->rx_depth + ctx->rx_posted_cnt[qp_index]++ % user_param->rx_depth] = addr;
+}
+
 /* catch_alarm.
  *
  * Description :
@@ -857,6 +983,15 @@ static __inline void increase_loc_addr(struct ibv_sge *sg,int size,uint64_t rcnt
  */
 void catch_alarm(int sig);
 
+/* start_duration_window.
+ *
+ * Description :
+ *	Starts the -D window of a DURATION test at once. run_iter_bw_server
+ *	otherwise starts it on the first message received.
+ *
+ */
+void start_duration_window(struct perftest_parameters *user_param);
+
 void check_alive(int sig);
 
 void print_bw_infinite_mode();
@@ -946,6 +1081,49 @@ int alloc_hugepage_region (struct pingpong_context *ctx, int qp_index);
  */
 int run_iter_fs(struct pingpong_context *ctx, struct perftest_parameters *user_param);
 
+/* run_iter_conn_rate
+ *
+ * Description :
+ *
+ *	The main testing method for the connection establishment rate.
+ *	Runs iters QP lifecycles (create, INIT, RTR, RTS, destroy) against the
+ *	remote QP of the test, on the --qp_threads pool, and keeps the cycles of
+ *	every step in user_param->conn_step_cycles.
+ *
+ * Parameters :
+ *
+ *	ctx		- Test Context.
+ *	user_param	- user_parameters struct for this test.
+ *	my_dest		- pingpong_dest struct of this side.
+ *	rem_dest	- pingpong_dest struct of the remote side.
+ *
+ * Return Value : SUCCESS, FAILURE.
+ *
+ */
+int run_iter_conn_rate(struct pingpong_context *ctx,
+		struct perftest_parameters *user_param,
+		struct pingpong_dest *my_dest, struct pingpong_dest *rem_dest);
+
+/* run_iter_reg_mr_rate
+ *
+ * Description :
+ *
+ *	The main testing method for the memory registration rate.
+ *	Registers and deregisters a buffer of user_param->size from the selected
+ *	memory backend (host, hugepages or mmap, with or without ODP) on each
+ *	thread of the --qp_threads pool, and keeps the cycles of every
+ *	ibv_reg_mr/ibv_dereg_mr call in user_param->reg_mr_cycles.
+ *
+ * Parameters :
+ *
+ *	ctx		- Test Context.
+ *	user_param	- user_parameters struct for this test.
+ *
+ * Return Value : SUCCESS, FAILURE.
+ *
+ */
+int run_iter_reg_mr_rate(struct pingpong_context *ctx, struct perftest_parameters *user_param);
+
 /* rdma_cm_allocate_nodes:
 *
 * Description:
@@ -0,0 +1,87 @@
+#include "perftest_seq_track.h"
+
+#define SEQ_TRACK_WORD(tracker, seq) (&(tracker)->window[((seq) % SEQ_TRACK_WINDOW) / 64])
+#define SEQ_TRACK_BIT(seq) (1ULL << ((seq) % 64))
+
+int seq_tracker_bucket(uint64_t value)
+{
+	int bucket = 63 - __builtin_clzll(value);
+
+	return bucket < SEQ_TRACK_HIST ? bucket : SEQ_TRACK_HIST - 1;
+}
+
+static void end_burst(struct seq_tracker *tracker)
+{
+	tracker->bursts++;
+	if (tracker->burst > tracker->max_burst)
+		tracker->max_burst = tracker->burst;
+	tracker->burst_hist[seq_tracker_bucket(tracker->burst)]++;
+	tracker->burst = 0;
+}
+
+/* Counts the sequence numbers below upto, in order, so the losses form bursts. */
+static void finalize(struct seq_tracker *tracker, uint64_t upto)
+{
+	uint64_t *word;
+
+	while (tracker->base < upto) {
+		/* Never received and out of the window at once. */
+		if (tracker->base >= tracker->next) {
+			tracker->lost += upto - tracker->base;
+			tracker->burst += upto - tracker->base;
+			tracker->base = upto;
+			break;
+		}
+
+		word = SEQ_TRACK_WORD(tracker, tracker->base);
+		if (*word & SEQ_TRACK_BIT(tracker->base)) {
+			*word &= ~SEQ_TRACK_BIT(tracker->base);
+			if (tracker->burst)
+				end_burst(tracker);
+		} else {
+			tracker->lost++;
+			tracker->burst++;
+		}
+		tracker->base++;
+	}
+}
+
+void seq_tracker_add(struct seq_tracker *tracker, uint64_t seq)
+{
+	uint64_t *word = SEQ_TRACK_WORD(tracker, seq);
+	uint64_t distance;
+
+	tracker->received++;
+
+	if (seq >= tracker->next) {
+		if (seq + 1 - tracker->base > SEQ_TRACK_WINDOW)
+			finalize(tracker, seq + 1 - SEQ_TRACK_WINDOW);
+		*word |= SEQ_TRACK_BIT(seq);
+		tracker->next = seq + 1;
+		return;
+	}
+
+	if (seq < tracker->base) {
+		tracker->late++;
+		return;
+	}
+
+	if (*word & SEQ_TRACK_BIT(seq)) {
+		tracker->duplicates++;
+		return;
+	}
+
+	*word |= SEQ_TRACK_BIT(seq);
+	distance = tracker->next - 1 - seq;
+	tracker->reordered++;
+	if (distance > tracker->max_reorder)
+		tracker->max_reorder = distance;
+	tracker->reorder_hist[seq_tracker_bucket(distance)]++;
+}
+
+void seq_tracker_flush(struct seq_tracker *tracker)
+{
+	finalize(tracker, tracker->next);
+	if (tracker->burst)
+		end_burst(tracker);
+}
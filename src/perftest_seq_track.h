@@ -0,0 +1,47 @@
+#ifndef PERFTEST_SEQ_TRACK_H
+#define PERFTEST_SEQ_TRACK_H
+
+#include <stdint.h>
+
+/* The sequence numbers behind the highest one received that are still
+ * waited for, older holes are counted lost.
+ */
+#define SEQ_TRACK_WINDOW (4096)
+/* Power of 2 buckets of the reorder distances and the loss bursts, the last one open ended. */
+#define SEQ_TRACK_HIST (13)
+
+/* The receive side of a flow, sequence numbers starting at 0. */
+struct seq_tracker {
+	uint64_t	base;		/* The lowest sequence number not counted yet. */
+	uint64_t	next;		/* One past the highest sequence number received. */
+	uint64_t	window[SEQ_TRACK_WINDOW / 64];
+	uint64_t	received;
+	uint64_t	lost;
+	uint64_t	duplicates;
+	uint64_t	late;		/* Behind the window, a duplicate or a message already counted lost. */
+	uint64_t	reordered;
+	uint64_t	max_reorder;
+	uint64_t	burst;		/* The loss burst in progress. */
+	uint64_t	bursts;
+	uint64_t	max_burst;
+	uint64_t	reorder_hist[SEQ_TRACK_HIST];
+	uint64_t	burst_hist[SEQ_TRACK_HIST];
+};
+
+/*
+ * Accounts a received sequence number of the flow.
+ */
+void seq_tracker_add(struct seq_tracker *tracker, uint64_t seq);
+
+/*
+ * Counts the holes up to the highest sequence number received as lost,
+ * before the tracker is reported.
+ */
+void seq_tracker_flush(struct seq_tracker *tracker);
+
+/*
+ * The histogram bucket of a reorder distance or a loss burst length.
+ */
+int seq_tracker_bucket(uint64_t value);
+
+#endif
@@ -1074,6 +1074,9 @@ int run_iter_fw(struct pingpong_context *ctx,struct perftest_parameters *user_pa
 						NOTIFY_COMP_ERROR_RECV(wc[i], totrcnt);
 					}
 
+					if (user_param->seq_track)
+						ctx_seq_track_recv(ctx, user_param, wc_id, rcnt_for_qp[wc_id]);
+
 					rcnt_for_qp[wc_id]++;
 					totrcnt++;
 				}
@@ -1114,6 +1117,8 @@ int run_iter_fw(struct pingpong_context *ctx,struct perftest_parameters *user_pa
 			while (rwqe_sent - totccnt < user_param->rx_depth) {    /* Post more than buffer_size */
 				if (user_param->test_type==DURATION ||
 					rcnt_for_qp[0] + user_param->rx_depth <= user_param->iters) {
+						if (ctx->rx_posted_addr)
+							track_recv_post(ctx, user_param, 0, ctx->rwr[0].sg_list->addr);
 						if (ibv_post_recv(ctx->qp[0], &ctx->rwr[0], &bad_wr_recv)) {
 							fprintf(stderr, "Couldn't post recv Qp=%d rcnt=%lu\n", 0, rcnt_for_qp[0]);
 							return_value = 15;
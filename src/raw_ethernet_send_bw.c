@@ -42,6 +42,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <signal.h>
 #include <getopt.h>
 #include <netinet/ip.h>
@@ -65,6 +66,7 @@ int main(int argc, char *argv[])
 	struct raw_ethernet_info	*rem_dest_info = NULL;
 	int				ret_parser;
 	struct perftest_parameters	user_param;
+	struct perftest_comm		user_comm;
 
 	struct ibv_flow			**flow_create_result;
 	struct ibv_flow_attr		**flow_rules;
@@ -78,6 +80,7 @@ int main(int argc, char *argv[])
 	/* init default values to user's parameters */
 	memset(&ctx, 0, sizeof(struct pingpong_context));
 	memset(&user_param, 0 , sizeof(struct perftest_parameters));
+	memset(&user_comm, 0, sizeof(struct perftest_comm));
 
 	user_param.verb    = SEND;
 	user_param.tst     = BW;
@@ -273,7 +276,29 @@ int main(int argc, char *argv[])
 		}
 	}
 
-	if (user_param.output == FULL_VERBOSITY) {
+	/* The RFC 2544 search exchanges the receive counts over a control connection. */
+	if (user_param.rfc2544) {
+		if (create_comm_struct(&user_comm, &user_param)) {
+			fprintf(stderr, " Unable to create the control connection\n");
+			goto destroy_ctx;
+		}
+
+		if (user_param.output == FULL_VERBOSITY && user_param.machine == SERVER) {
+			printf("\n************************************\n");
+			printf("* Waiting for client to connect... *\n");
+			printf("************************************\n");
+		}
+
+		if (establish_connection(&user_comm)) {
+			fprintf(stderr, " Unable to init the socket connection\n");
+			dealloc_comm_struct(&user_comm, &user_param);
+			goto destroy_ctx;
+		}
+
+		exchange_versions(&user_comm, &user_param);
+	}
+
+	if (user_param.output == FULL_VERBOSITY && !user_param.rfc2544) {
 		printf(RESULT_LINE);
 		if (user_param.raw_qos)
 			printf((user_param.report_fmt == MBS ? RESULT_FMT_QOS : RESULT_FMT_G_QOS));
@@ -282,7 +307,30 @@ int main(int argc, char *argv[])
 		printf((user_param.cpu_util_data.enable ? RESULT_EXT_CPU_UTIL : RESULT_EXT));
 	}
 
-	if (user_param.test_method == RUN_REGULAR) {
+	if (user_param.rfc2544) {
+		if (user_param.machine == SERVER) {
+			if (ctx_set_recv_wqes(&ctx, &user_param)) {
+				fprintf(stderr," Failed to post receive recv_wqes\n");
+				DEBUG_LOG(TRACE, "<<<<<<%s", __FUNCTION__);
+				close(user_comm.rdma_params->sockfd);
+				dealloc_comm_struct(&user_comm, &user_param);
+				goto free_devname;
+			}
+		}
+
+		if (run_rfc2544(&user_comm, &ctx, &user_param, NULL)) {
+			DEBUG_LOG(TRACE, "<<<<<<%s", __FUNCTION__);
+			close(user_comm.rdma_params->sockfd);
+			dealloc_comm_struct(&user_comm, &user_param);
+			goto free_devname;
+		}
+
+		if (user_param.output == FULL_VERBOSITY)
+			printf(RESULT_LINE);
+
+		close(user_comm.rdma_params->sockfd);
+		dealloc_comm_struct(&user_comm, &user_param);
+	} else if (user_param.test_method == RUN_REGULAR) {
 		if (user_param.machine == CLIENT || user_param.duplex) {
 			ctx_set_send_wqes(&ctx,	&user_param, NULL);
 		}
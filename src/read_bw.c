@@ -168,13 +168,10 @@ int main(int argc, char *argv[])
 
 	/* Print basic test information. */
 	ctx_print_test_info(&user_param);
-	for (i=0; i < user_param.num_of_qps; i++) {
-
-		/* shaking hands and gather the other side info. */
-		if (ctx_hand_shake(&user_comm,&my_dest[i],&rem_dest[i])) {
-			fprintf(stderr,"Failed to exchange data between server and clients\n");
-			goto destroy_context;
-		}
+	/* shaking hands and gather the other side info. */
+	if (ctx_hand_shake_bulk(&user_comm,my_dest,rem_dest,user_param.num_of_qps)) {
+		fprintf(stderr,"Failed to exchange data between server and clients\n");
+		goto destroy_context;
 	}
 
 	if (user_param.work_rdma_cm == OFF) {
@@ -208,14 +205,14 @@ int main(int argc, char *argv[])
 
 	user_comm.rdma_params->side = REMOTE;
 
-	for (i=0; i < user_param.num_of_qps; i++) {
-		if (ctx_hand_shake(&user_comm,&my_dest[i],&rem_dest[i])) {
-			fprintf(stderr," Failed to exchange data between server and clients\n");
-			goto destroy_context;
-		}
-		ctx_print_pingpong_data(&rem_dest[i],&user_comm);
+	if (ctx_hand_shake_bulk(&user_comm,my_dest,rem_dest,user_param.num_of_qps)) {
+		fprintf(stderr," Failed to exchange data between server and clients\n");
+		goto destroy_context;
 	}
 
+	for (i=0; i < user_param.num_of_qps; i++)
+		ctx_print_pingpong_data(&rem_dest[i],&user_comm);
+
 
 	/* An additional handshake is required after moving qp to RTR. */
 	if (ctx_hand_shake(&user_comm,&my_dest[0],&rem_dest[0])) {
@@ -223,6 +220,14 @@ int main(int argc, char *argv[])
 		goto destroy_context;
 	}
 
+	/* The server only waits for the client to finish, it takes no part in the search. */
+	if (user_param.autotune && user_param.machine == CLIENT) {
+		if (run_autotune(&ctx, &user_param, rem_dest)) {
+			fprintf(stderr," Failed to complete run_autotune function successfully\n");
+			goto destroy_context;
+		}
+	}
+
 	if (user_param.output == FULL_VERBOSITY) {
 		if (user_param.report_per_port) {
 			printf(RESULT_LINE_PER_PORT);
@@ -301,9 +306,11 @@ int main(int argc, char *argv[])
 
 	if (user_param.test_method == RUN_ALL) {
 
-		for (i = 1; i < 24 ; ++i) {
+		for (i = 0; i < SIZE_PASSES(&user_param); ++i) {
+
+			if (ctx_set_size_pass(&user_comm, &user_param, i, user_param.duplex))
+				goto free_mem;
 
-			user_param.size = (uint64_t)1 << i;
 			ctx_set_send_wqes(&ctx,&user_param,rem_dest);
 
 			if (user_param.perform_warm_up) {
@@ -320,7 +327,12 @@ int main(int argc, char *argv[])
 				}
 			}
 
-			if(run_iter_bw(&ctx,&user_param)) {
+			if (user_param.object_size) {
+				if (run_iter_bw_object(&ctx, &user_param)) {
+					error = 17;
+					goto free_mem;
+				}
+			} else if(run_iter_bw(&ctx,&user_param)) {
 				error = 17;
 				goto free_mem;
 			}
@@ -332,6 +344,10 @@ int main(int argc, char *argv[])
 				}
 			}
 
+			/* The probe of --time_per_size isn't reported. */
+			if (user_param.size_probe)
+				continue;
+
 			print_report_bw(&user_param,&my_bw_rep);
 
 			if (user_param.duplex) {
@@ -357,11 +373,19 @@ int main(int argc, char *argv[])
 			}
 		}
 
-		if(run_iter_bw(&ctx,&user_param)) {
+		if (user_param.object_size) {
+			if (run_iter_bw_object(&ctx, &user_param)) {
+				fprintf(stderr," Failed to complete run_iter_bw_object function successfully\n");
+				goto free_mem;
+			}
+		} else if(run_iter_bw(&ctx,&user_param)) {
 			fprintf(stderr," Failed to complete run_iter_bw function successfully\n");
 			goto free_mem;
 		}
 
+		if (user_param.verify)
+			ctx_verify_bw(&ctx, &user_param);
+
 		print_report_bw(&user_param,&my_bw_rep);
 
 		if (user_param.duplex) {
@@ -401,6 +425,8 @@ int main(int argc, char *argv[])
 			printf(RESULT_LINE);
 	}
 
+	print_report_verify(&user_param);
+
 	/* For half duplex tests, server just waits for client to exit */
 	if (user_param.machine == CLIENT && !user_param.duplex) {
 
@@ -427,6 +453,11 @@ int main(int argc, char *argv[])
 		goto destroy_context;
 	}
 
+	if (user_param.verify_errors) {
+		fprintf(stderr,"Error: %" PRIu64 " messages failed the data verification\n", user_param.verify_errors);
+		goto destroy_context;
+	}
+
 	if (user_param.work_rdma_cm == ON) {
 		if (destroy_ctx(&ctx,&user_param)) {
 			fprintf(stderr, "Failed to destroy resources\n");
@@ -187,13 +187,10 @@ int main(int argc, char *argv[])
 		goto destroy_context;
 	}
 
-	for (i=0; i < user_param.num_of_qps; i++) {
-
-		/* shaking hands and gather the other side info. */
-		if (ctx_hand_shake(&user_comm,&my_dest[i],&rem_dest[i])) {
-			fprintf(stderr,"Failed to exchange data between server and clients\n");
-			goto destroy_context;
-		}
+	/* shaking hands and gather the other side info. */
+	if (ctx_hand_shake_bulk(&user_comm,my_dest,rem_dest,user_param.num_of_qps)) {
+		fprintf(stderr,"Failed to exchange data between server and clients\n");
+		goto destroy_context;
 	}
 
 	if (user_param.work_rdma_cm == OFF) {
@@ -226,15 +223,13 @@ int main(int argc, char *argv[])
 
 	user_comm.rdma_params->side = REMOTE;
 
-	for (i=0; i < user_param.num_of_qps; i++) {
-
-		if (ctx_hand_shake(&user_comm,&my_dest[i],&rem_dest[i])) {
-			fprintf(stderr," Failed to exchange data between server and clients\n");
-			goto destroy_context;
-		}
+	if (ctx_hand_shake_bulk(&user_comm,my_dest,rem_dest,user_param.num_of_qps)) {
+		fprintf(stderr," Failed to exchange data between server and clients\n");
+		goto destroy_context;
+	}
 
+	for (i=0; i < user_param.num_of_qps; i++)
 		ctx_print_pingpong_data(&rem_dest[i],&user_comm);
-	}
 
 	/* An additional handshake is required after moving qp to RTR. */
 	if (ctx_hand_shake(&user_comm,my_dest,rem_dest)) {
@@ -300,13 +295,19 @@ int main(int argc, char *argv[])
 	ctx_set_send_wqes(&ctx,&user_param,rem_dest);
 
 	if (user_param.test_method == RUN_ALL) {
-		for (i = 1; i < 24 ; ++i) {
-			user_param.size = (uint64_t)1 << i;
+		for (i = 0; i < SIZE_PASSES(&user_param); ++i) {
+			if (ctx_set_size_pass(&user_comm, &user_param, i, 1))
+				goto free_mem;
+
 			if(run_iter_lat(&ctx,&user_param)) {
 				error = 17;
 				goto free_mem;
 			}
 
+			/* The probe of --time_per_size isn't reported. */
+			if (user_param.size_probe)
+				continue;
+
 			user_param.test_type == ITERATIONS ? print_report_lat(&user_param) : print_report_lat_duration(&user_param);
 		}
 	} else {
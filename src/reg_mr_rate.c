@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2005 Topspin Communications.  All rights reserved.
+ * Copyright (c) 2005 Mellanox Technologies Ltd.  All rights reserved.
+ * Copyright (c) 2009 HNR Consulting.  All rights reserved.
+ *
+ * This software is available to you under a choice of one of two
+ * licenses.  You may choose to be licensed under the terms of the GNU
+ * General Public License (GPL) Version 2, available from the file
+ * COPYING in the main directory of this source tree, or the
+ * OpenIB.org BSD license below:
+ *
+ *     Redistribution and use in source and binary forms, with or
+ *     without modification, are permitted provided that the following
+ *     conditions are met:
+ *
+ *      - Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *
+ *      - Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * $Id$
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#if !defined(__FreeBSD__)
+#include <malloc.h>
+#endif
+
+#include "get_clock.h"
+#include "perftest_parameters.h"
+#include "perftest_resources.h"
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+static void print_reg_mr_rate_info(struct perftest_parameters *user_param)
+{
+	if (user_param->output != FULL_VERBOSITY)
+		return;
+
+	printf(RESULT_LINE);
+	printf("                    Memory Registration Rate Test\n");
+	printf(" Device          : %s\n", user_param->ib_devname);
+	printf(" Memory          : %s\n", user_param->memory_type == MEMORY_MMAP ? "mmap" : "host");
+	printf(" Page policy     : %s\n", page_policy_str(user_param->page_policy));
+	printf(" ODP             : %s\n", user_param->use_odp ? "ON" : "OFF");
+	printf(" Threads         : %d\n", user_param->qp_threads);
+	printf(RESULT_LINE);
+	printf("%s\n", RESULT_FMT_REG_MR_RATE);
+}
+
+/******************************************************************************
+ *
+ ******************************************************************************/
+int main(int argc, char *argv[])
+{
+	int				ret_parser;
+	uint64_t			size;
+	struct report_options		report;
+	struct pingpong_context		ctx;
+	struct ibv_device		*ib_dev;
+	struct perftest_parameters	user_param;
+
+	/* init default values to user's parameters */
+	memset(&ctx,0,sizeof(struct pingpong_context));
+	memset(&user_param, 0, sizeof(struct perftest_parameters));
+
+	/* The test is local, no remote side is needed. */
+	user_param.verb        = WRITE;
+	user_param.tst         = LAT;
+	user_param.reg_mr_rate = ON;
+	user_param.r_flag      = &report;
+	strncpy(user_param.version, VERSION, sizeof(user_param.version));
+
+	/* Configure the parameters values according to user arguments or defalut values. */
+	ret_parser = parser(&user_param,argv,argc);
+	if (ret_parser) {
+		if (ret_parser != VERSION_EXIT && ret_parser != HELP_EXIT)
+			fprintf(stderr," Parser function exited with Error\n");
+		goto return_error;
+	}
+
+	/* Finding the IB device selected (or defalut if no selected). */
+	ib_dev = ctx_find_dev(&user_param.ib_devname);
+	if (!ib_dev) {
+		fprintf(stderr," Unable to find the Infiniband/RoCE device\n");
+		goto return_error;
+	}
+
+	/* Getting the relevant context from the device */
+	ctx.context = ctx_open_device(ib_dev, &user_param);
+	if (!ctx.context) {
+		fprintf(stderr, " Couldn't get context for the device\n");
+		goto free_devname;
+	}
+
+	/* Verify user parameters that require the device context,
+	 * the function will print the relevent error info. */
+	if (verify_params_with_device_context(ctx.context, &user_param))
+	{
+		fprintf(stderr, " Couldn't get context for the device\n");
+		goto close_device;
+	}
+
+	ctx.pd = ibv_alloc_pd(ctx.context);
+	if (!ctx.pd) {
+		fprintf(stderr, " Couldn't allocate PD\n");
+		goto close_device;
+	}
+
+	ctx.memory = user_param.memory_create(&user_param);
+	if (ctx.memory == NULL) {
+		fprintf(stderr, " Failed to create memory\n");
+		goto dealloc_pd;
+	}
+
+	if (ctx.memory->init(ctx.memory)) {
+		fprintf(stderr, " Failed to init memory\n");
+		goto destroy_memory;
+	}
+
+	print_reg_mr_rate_info(&user_param);
+
+	for (size = user_param.reg_min_size; size <= user_param.reg_max_size; size *= 2) {
+		user_param.size = size;
+
+		if (run_iter_reg_mr_rate(&ctx, &user_param)) {
+			fprintf(stderr," Test exited with Error\n");
+			goto destroy_memory;
+		}
+
+		print_report_reg_mr_rate(&user_param);
+	}
+
+	if (user_param.output == FULL_VERBOSITY)
+		printf(RESULT_LINE);
+
+	free(user_param.reg_mr_cycles);
+	ctx.memory->destroy(ctx.memory);
+	ibv_dealloc_pd(ctx.pd);
+	ibv_close_device(ctx.context);
+	free(user_param.ib_devname);
+	return SUCCESS;
+
+destroy_memory:
+	free(user_param.reg_mr_cycles);
+	ctx.memory->destroy(ctx.memory);
+dealloc_pd:
+	ibv_dealloc_pd(ctx.pd);
+close_device:
+	ibv_close_device(ctx.context);
+free_devname:
+	free(user_param.ib_devname);
+return_error:
+	return FAILURE;
+}
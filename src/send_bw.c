@@ -164,7 +164,6 @@ int main(int argc, char *argv[])
 	struct mcast_parameters     	mcg_params;
 	struct bw_report_data		my_bw_rep, rem_bw_rep;
 	int                      	ret_parser, i = 0, rc;
-	int                      	size_max_pow = 24;
 	int 						error = 1;
 	int rdma_cm_flow_destroyed = 0;
 
@@ -259,7 +258,7 @@ int main(int argc, char *argv[])
 	MAIN_ALLOC(rem_dest, struct pingpong_dest, user_param.num_of_qps, free_my_dest);
 	memset(rem_dest, 0, sizeof(struct pingpong_dest)*user_param.num_of_qps);
 
-	if (user_param.transport_type == IBV_TRANSPORT_IWARP)
+	if (user_param.transport_type == IBV_TRANSPORT_IWARP || user_param.use_credits)
 		ctx.send_rcredit = 1;
 
 	/* Allocating arrays needed for the test. */
@@ -301,12 +300,10 @@ int main(int argc, char *argv[])
 		ctx_alloc_credit(&ctx,&user_param,my_dest);
 
 	if (!user_param.connectionless) {
-		for (i=0; i < user_param.num_of_qps; i++) {
-			/* shaking hands and gather the other side info. */
-			if (ctx_hand_shake(&user_comm,&my_dest[i],&rem_dest[i])) {
-				fprintf(stderr,"Failed to exchange data between server and clients\n");
-				goto destroy_context;
-			}
+		/* shaking hands and gather the other side info. */
+		if (ctx_hand_shake_bulk(&user_comm,my_dest,rem_dest,user_param.num_of_qps)) {
+			fprintf(stderr,"Failed to exchange data between server and clients\n");
+			goto destroy_context;
 		}
 
 		if (user_param.work_rdma_cm == OFF) {
@@ -377,15 +374,13 @@ int main(int argc, char *argv[])
 	user_comm.rdma_params->side = REMOTE;
 
 	if (!user_param.connectionless) {
-		for (i=0; i < user_param.num_of_qps; i++) {
-
-			if (ctx_hand_shake(&user_comm,&my_dest[i],&rem_dest[i])) {
-				fprintf(stderr," Failed to exchange data between server and clients\n");
-				goto destroy_context;
-			}
+		if (ctx_hand_shake_bulk(&user_comm,my_dest,rem_dest,user_param.num_of_qps)) {
+			fprintf(stderr," Failed to exchange data between server and clients\n");
+			goto destroy_context;
+		}
 
+		for (i=0; i < user_param.num_of_qps; i++)
 			ctx_print_pingpong_data(&rem_dest[i],&user_comm);
-		}
 	}
 
 	if (user_param.use_event) {
@@ -399,7 +394,7 @@ int main(int argc, char *argv[])
 		}
 	}
 
-	if (user_param.output == FULL_VERBOSITY) {
+	if (user_param.output == FULL_VERBOSITY && !user_param.rfc2544) {
 		if (user_param.report_per_port) {
 			printf(RESULT_LINE_PER_PORT);
 			printf((user_param.report_fmt == MBS ? RESULT_FMT_PER_PORT : RESULT_FMT_G_PER_PORT));
@@ -412,14 +407,11 @@ int main(int argc, char *argv[])
 	}
 
 	if (user_param.test_method == RUN_ALL) {
-		if (user_param.connection_type == UD)
-			size_max_pow = (int)MSG_SZ_2_EXP(MTU_SIZE(user_param.curr_mtu)) + 1;
-		else if (user_param.connection_type == SRD)
-			size_max_pow = (int)MSG_SZ_2_EXP(user_param.size) + 1;
+		/* The sizes beyond the UD MTU or the SRD message size are trimmed by the MTU check. */
+		for (i = 0; i < SIZE_PASSES(&user_param); ++i) {
 
-		for (i = 1; i < size_max_pow ; ++i) {
-
-			user_param.size = (uint64_t)1 << i;
+			if (ctx_set_size_pass(&user_comm, &user_param, i, 1))
+				goto free_mem;
 
 			if (user_param.machine == CLIENT || user_param.duplex)
 				ctx_set_send_wqes(&ctx,&user_param,rem_dest);
@@ -461,11 +453,14 @@ int main(int argc, char *argv[])
 				}
 			}
 
-			print_report_bw(&user_param,&my_bw_rep);
+			/* The probe of --time_per_size isn't reported. */
+			if (!user_param.size_probe) {
+				print_report_bw(&user_param,&my_bw_rep);
 
-			if (user_param.duplex && user_param.test_type != DURATION) {
-				xchg_bw_reports(&user_comm, &my_bw_rep,&rem_bw_rep,atof(user_param.rem_version));
-				print_full_bw_report(&user_param, &my_bw_rep, &rem_bw_rep);
+				if (user_param.duplex && user_param.test_type != DURATION) {
+					xchg_bw_reports(&user_comm, &my_bw_rep,&rem_bw_rep,atof(user_param.rem_version));
+					print_full_bw_report(&user_param, &my_bw_rep, &rem_bw_rep);
+				}
 			}
 
 			if (ctx_hand_shake(&user_comm,&my_dest[0],&rem_dest[0])) {
@@ -479,6 +474,25 @@ int main(int argc, char *argv[])
 			}
 		}
 
+	} else if (user_param.rfc2544) {
+
+		if (user_param.machine == SERVER) {
+			if (ctx_set_recv_wqes(&ctx,&user_param)) {
+				fprintf(stderr," Failed to post receive recv_wqes\n");
+				goto free_mem;
+			}
+		}
+
+		if (ctx_hand_shake(&user_comm,&my_dest[0],&rem_dest[0])) {
+			fprintf(stderr,"Failed to exchange data between server and clients\n");
+			goto free_mem;
+		}
+
+		if (run_rfc2544(&user_comm,&ctx,&user_param,rem_dest)) {
+			error = 17;
+			goto free_mem;
+		}
+
 	} else if (user_param.test_method == RUN_REGULAR) {
 
 		if (user_param.machine == CLIENT || user_param.duplex)
@@ -575,6 +589,8 @@ int main(int argc, char *argv[])
 			printf(RESULT_LINE);
 	}
 
+	print_report_verify(&user_param);
+
 	if (ctx_close_connection(&user_comm,&my_dest[0],&rem_dest[0])) {
 		fprintf(stderr," Failed to close connection between server and client\n");
 		fprintf(stderr," Trying to close this side resources\n");
@@ -618,6 +634,11 @@ int main(int argc, char *argv[])
 		return FAILURE;
 	}
 
+	if (user_param.verify_errors) {
+		fprintf(stderr,"Error: %" PRIu64 " messages failed the data verification\n", user_param.verify_errors);
+		return FAILURE;
+	}
+
 	return SUCCESS;
 
 destroy_context:
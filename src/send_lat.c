@@ -164,7 +164,6 @@ static int send_destroy_ctx(struct pingpong_context *ctx,
 int main(int argc, char *argv[])
 {
 	int                        i = 0, rc, error = 1;
-	int                        size_max_pow = 24;
 	int			   ret_val;
 	struct report_options      report;
 	struct pingpong_context    ctx;
@@ -301,13 +300,10 @@ int main(int argc, char *argv[])
 	ctx_print_test_info(&user_param);
 	check_bf_support(&ctx);
 
-	for (i=0; i < user_param.num_of_qps; i++) {
-
-		/* shaking hands and gather the other side info. */
-		if (ctx_hand_shake(&user_comm,&my_dest[i],&rem_dest[i])) {
-			fprintf(stderr,"Failed to exchange data between server and clients\n");
-			goto destroy_ctx;
-		}
+	/* shaking hands and gather the other side info. */
+	if (ctx_hand_shake_bulk(&user_comm,my_dest,rem_dest,user_param.num_of_qps)) {
+		fprintf(stderr,"Failed to exchange data between server and clients\n");
+		goto destroy_ctx;
 	}
 
 	if (user_param.work_rdma_cm == OFF) {
@@ -374,14 +370,13 @@ int main(int argc, char *argv[])
 
 	user_comm.rdma_params->side = REMOTE;
 
-	for (i=0; i < user_param.num_of_qps; i++) {
-		if (ctx_hand_shake(&user_comm,&my_dest[i],&rem_dest[i])) {
-			fprintf(stderr," Failed to exchange data between server and clients\n");
-			goto destroy_ctx;
-		}
+	if (ctx_hand_shake_bulk(&user_comm,my_dest,rem_dest,user_param.num_of_qps)) {
+		fprintf(stderr," Failed to exchange data between server and clients\n");
+		goto destroy_ctx;
+	}
 
+	for (i=0; i < user_param.num_of_qps; i++)
 		ctx_print_pingpong_data(&rem_dest[i],&user_comm);
-	}
 
 	if (user_param.use_event) {
 
@@ -404,14 +399,11 @@ int main(int argc, char *argv[])
 	ctx_set_send_wqes(&ctx,&user_param,rem_dest);
 
 	if (user_param.test_method == RUN_ALL) {
-		if (user_param.connection_type == UD)
-			size_max_pow = (int)MSG_SZ_2_EXP(MTU_SIZE(user_param.curr_mtu)) + 1;
-		else if (user_param.connection_type == SRD)
-			size_max_pow = (int)MSG_SZ_2_EXP(user_param.size) + 1;
-
-		for (i = 1; i < size_max_pow ; ++i) {
+		/* The sizes beyond the UD MTU or the SRD message size are trimmed by the MTU check. */
+		for (i = 0; i < SIZE_PASSES(&user_param); ++i) {
 
-			user_param.size = (uint64_t)1 << i;
+			if (ctx_set_size_pass(&user_comm, &user_param, i, 1))
+				goto free_mem;
 
 			/* Post receive recv_wqes fo current message size */
 			if (ctx_set_recv_wqes(&ctx,&user_param)) {
@@ -433,6 +425,10 @@ int main(int argc, char *argv[])
 				goto free_mem;
 			}
 
+			/* The probe of --time_per_size isn't reported. */
+			if (user_param.size_probe)
+				continue;
+
 			user_param.test_type == ITERATIONS ? print_report_lat(&user_param) : print_report_lat_duration(&user_param);
 		}
 
@@ -174,12 +174,9 @@ int main(int argc, char *argv[])
 	/* Print basic test information. */
 	ctx_print_test_info(&user_param);
 
-	for (i=0; i < user_param.num_of_qps; i++) {
-
-		if (ctx_hand_shake(&user_comm,&my_dest[i],&rem_dest[i])) {
-			fprintf(stderr," Failed to exchange data between server and clients\n");
-			goto destroy_context;
-		}
+	if (ctx_hand_shake_bulk(&user_comm,my_dest,rem_dest,user_param.num_of_qps)) {
+		fprintf(stderr," Failed to exchange data between server and clients\n");
+		goto destroy_context;
 	}
 
 	if (user_param.work_rdma_cm == OFF) {
@@ -213,14 +210,13 @@ int main(int argc, char *argv[])
 
 	user_comm.rdma_params->side = REMOTE;
 
-	for (i=0; i < user_param.num_of_qps; i++) {
-		if (ctx_hand_shake(&user_comm,&my_dest[i],&rem_dest[i])) {
-			fprintf(stderr," Failed to exchange data between server and clients\n");
-			goto destroy_context;
-		}
+	if (ctx_hand_shake_bulk(&user_comm,my_dest,rem_dest,user_param.num_of_qps)) {
+		fprintf(stderr," Failed to exchange data between server and clients\n");
+		goto destroy_context;
+	}
 
+	for (i=0; i < user_param.num_of_qps; i++)
 		ctx_print_pingpong_data(&rem_dest[i],&user_comm);
-	}
 
 	/* An additional handshake is required after moving qp to RTR. */
 	if (ctx_hand_shake(&user_comm,&my_dest[0],&rem_dest[0])) {
@@ -228,6 +224,14 @@ int main(int argc, char *argv[])
 		goto destroy_context;
 	}
 
+	/* The server only waits for the client to finish, it takes no part in the search. */
+	if (user_param.autotune && user_param.machine == CLIENT) {
+		if (run_autotune(&ctx, &user_param, rem_dest)) {
+			fprintf(stderr," Failed to complete run_autotune function successfully\n");
+			goto destroy_context;
+		}
+	}
+
 	if (user_param.output == FULL_VERBOSITY) {
 		if (user_param.report_per_port) {
 			printf(RESULT_LINE_PER_PORT);
@@ -249,6 +253,10 @@ int main(int argc, char *argv[])
 			goto free_mem;
 		}
 
+		/* The client is done, the last messages of the run are in place. */
+		if (user_param.verify)
+			ctx_verify_bw(&ctx, &user_param);
+
 		xchg_bw_reports(&user_comm, &my_bw_rep,&rem_bw_rep,atof(user_param.rem_version));
 
 		if (user_param.test_method != RUN_INFINITELY) {
@@ -269,6 +277,12 @@ int main(int argc, char *argv[])
 				printf(RESULT_LINE);
 		}
 
+		print_report_verify(&user_param);
+		if (user_param.verify_errors) {
+			fprintf(stderr,"Error: %" PRIu64 " messages failed the data verification\n", user_param.verify_errors);
+			goto destroy_context;
+		}
+
 		if (user_param.work_rdma_cm == ON) {
 			if (destroy_ctx(&ctx,&user_param)) {
 				fprintf(stderr, "Failed to destroy resources\n");
@@ -301,9 +315,10 @@ int main(int argc, char *argv[])
 
 	if (user_param.test_method == RUN_ALL) {
 
-		for (i = 1; i < 24 ; ++i) {
+		for (i = 0; i < SIZE_PASSES(&user_param); ++i) {
 
-			user_param.size = (uint64_t)1 << i;
+			if (ctx_set_size_pass(&user_comm, &user_param, i, user_param.duplex || user_param.verb == WRITE_IMM))
+				goto free_mem;
 
 			if (user_param.machine == CLIENT || user_param.duplex)
 				ctx_set_send_wqes(&ctx,&user_param,rem_dest);
@@ -341,6 +356,13 @@ int main(int argc, char *argv[])
 					goto free_mem;
 				}
 
+			} else if (user_param.object_size) {
+
+				if (run_iter_bw_object(&ctx, &user_param)) {
+					fprintf(stderr," Failed to complete run_iter_bw_object function successfully\n");
+					goto free_mem;
+				}
+
 			} else if (user_param.machine == CLIENT || user_param.verb != WRITE_IMM) {
 
 				if(run_iter_bw(&ctx,&user_param)) {
@@ -363,6 +385,10 @@ int main(int argc, char *argv[])
 				}
 			}
 
+			/* The probe of --time_per_size isn't reported. */
+			if (user_param.size_probe)
+				continue;
+
 			print_report_bw(&user_param,&my_bw_rep);
 
 			if (user_param.duplex && (user_param.verb != WRITE_IMM || user_param.test_type != DURATION)) {
@@ -407,6 +433,13 @@ int main(int argc, char *argv[])
 				goto free_mem;
 			}
 
+		} else if (user_param.object_size) {
+
+			if (run_iter_bw_object(&ctx, &user_param)) {
+				fprintf(stderr," Failed to complete run_iter_bw_object function successfully\n");
+				goto free_mem;
+			}
+
 		} else if (user_param.machine == CLIENT || user_param.verb != WRITE_IMM) {
 
 			if(run_iter_bw(&ctx,&user_param)) {
@@ -483,6 +516,8 @@ int main(int argc, char *argv[])
 			printf(RESULT_LINE);
 	}
 
+	print_report_verify(&user_param);
+
 	/* For half duplex write tests, server just waits for client to exit */
 	if (user_param.machine == CLIENT && user_param.verb == WRITE && !user_param.duplex) {
 		if (ctx_hand_shake(&user_comm,&my_dest[0],&rem_dest[0])) {
@@ -508,6 +543,11 @@ int main(int argc, char *argv[])
 		fprintf(stderr,"Error: Msg rate  is below msg_rate limit\n");
 		goto destroy_context;
 	}
+
+	if (user_param.verify_errors) {
+		fprintf(stderr,"Error: %" PRIu64 " messages failed the data verification\n", user_param.verify_errors);
+		goto destroy_context;
+	}
 	if (user_param.work_rdma_cm == ON) {
 		if (destroy_ctx(&ctx,&user_param)) {
 			fprintf(stderr, "Failed to destroy resources\n");
@@ -195,13 +195,10 @@ int main(int argc, char *argv[])
 		goto destroy_context;
 	}
 
-	for (i=0; i < user_param.num_of_qps; i++) {
-		/* shaking hands and gather the other side info. */
-		if (ctx_hand_shake(&user_comm,&my_dest[i],&rem_dest[i])) {
-			fprintf(stderr,"Failed to exchange data between server and clients\n");
-			goto destroy_context;
-		}
-
+	/* shaking hands and gather the other side info. */
+	if (ctx_hand_shake_bulk(&user_comm,my_dest,rem_dest,user_param.num_of_qps)) {
+		fprintf(stderr,"Failed to exchange data between server and clients\n");
+		goto destroy_context;
 	}
 
 	if (user_param.work_rdma_cm == OFF) {
@@ -234,14 +231,13 @@ int main(int argc, char *argv[])
 
 	user_comm.rdma_params->side = REMOTE;
 
-	for (i=0; i < user_param.num_of_qps; i++) {
-		if (ctx_hand_shake(&user_comm,&my_dest[i],&rem_dest[i])) {
-			fprintf(stderr," Failed to exchange data between server and clients\n");
-			goto destroy_context;
-		}
+	if (ctx_hand_shake_bulk(&user_comm,my_dest,rem_dest,user_param.num_of_qps)) {
+		fprintf(stderr," Failed to exchange data between server and clients\n");
+		goto destroy_context;
+	}
 
+	for (i=0; i < user_param.num_of_qps; i++)
 		ctx_print_pingpong_data(&rem_dest[i],&user_comm);
-	}
 
 	/* An additional handshake is required after moving qp to RTR. */
 	if (ctx_hand_shake(&user_comm,my_dest,rem_dest)) {
@@ -259,8 +255,9 @@ int main(int argc, char *argv[])
 
 	if (user_param.test_method == RUN_ALL) {
 
-		for (i = 1; i < 24 ; ++i) {
-			user_param.size = (uint64_t)1 << i;
+		for (i = 0; i < SIZE_PASSES(&user_param); ++i) {
+			if (ctx_set_size_pass(&user_comm, &user_param, i, 1))
+				goto free_mem;
 
 			if (user_param.verb == WRITE_IMM) {
 				if (!user_param.use_unsolicited_write) {
@@ -291,6 +288,10 @@ int main(int argc, char *argv[])
 				}
 			}
 
+			/* The probe of --time_per_size isn't reported. */
+			if (user_param.size_probe)
+				continue;
+
 			user_param.test_type == ITERATIONS ? print_report_lat(&user_param) : print_report_lat_duration(&user_param);
 		}
 